@@ -0,0 +1,284 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "fuurin/zmqpart.h"
+#include "fuurin/zmqpartmulti.h"
+#include "fuurin/topic.h"
+#include "fuurin/uuid.h"
+#include "fuurin/lrucache.h"
+#include "fuurin/concurrentlrucache.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+
+
+using namespace fuurin;
+using namespace std::literals::string_view_literals;
+
+
+namespace {
+Topic mkTopic(Topic::Name name, size_t size)
+{
+    return Topic{Uuid::createRandomUuid(), Uuid::createRandomUuid(),
+        Topic::SeqN{1}, name, zmq::Part{std::string(size, 'x')}, Topic::State};
+}
+
+
+std::vector<Topic::Name> mkNames(size_t count)
+{
+    std::vector<Topic::Name> ret;
+    ret.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+        ret.emplace_back("topic/" + std::to_string(i));
+
+    return ret;
+}
+} // namespace
+
+
+static void BM_PartMultiPack(benchmark::State& state)
+{
+    const auto data = std::string(size_t(state.range(0)), 'x');
+    const auto id = Uuid::createRandomUuid();
+
+    for (auto _ : state) {
+        auto p = zmq::PartMulti::pack(uint64_t(1), uint8_t(0), id.bytes(),
+            std::string_view("topic/name"), std::string_view(data));
+        benchmark::DoNotOptimize(p.data());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_PartMultiPack)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_PartMultiUnpack(benchmark::State& state)
+{
+    const auto data = std::string(size_t(state.range(0)), 'x');
+    const auto id = Uuid::createRandomUuid();
+    const auto p = zmq::PartMulti::pack(uint64_t(1), uint8_t(0), id.bytes(),
+        std::string_view("topic/name"), std::string_view(data));
+
+    for (auto _ : state) {
+        auto v = zmq::PartMulti::unpack<uint64_t, uint8_t, Uuid::Bytes,
+            std::string_view, std::string_view>(p);
+        benchmark::DoNotOptimize(v);
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_PartMultiUnpack)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_TopicToPart(benchmark::State& state)
+{
+    const auto t = mkTopic("topic/name"sv, size_t(state.range(0)));
+
+    for (auto _ : state) {
+        auto p = t.toPart();
+        benchmark::DoNotOptimize(p.data());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_TopicToPart)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_TopicFromPart(benchmark::State& state)
+{
+    const auto p = mkTopic("topic/name"sv, size_t(state.range(0))).toPart();
+
+    for (auto _ : state) {
+        auto t = Topic::fromPart(p);
+        benchmark::DoNotOptimize(t.data().data());
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_TopicFromPart)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_LRUCachePut(benchmark::State& state)
+{
+    const size_t capacity = size_t(state.range(0));
+    const auto names = mkNames(capacity * 2);
+    const auto t = mkTopic("topic/name"sv, 16);
+
+    LRUCache<Topic::Name, Topic> cache{capacity};
+
+    size_t i = 0;
+    for (auto _ : state) {
+        // half of puts evict an item, once the cache is full.
+        cache.put(names[i], t);
+        i = (i + 1) % names.size();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_LRUCachePut)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_LRUCacheFind(benchmark::State& state)
+{
+    const size_t capacity = size_t(state.range(0));
+    const auto names = mkNames(capacity);
+    const auto t = mkTopic("topic/name"sv, 16);
+
+    LRUCache<Topic::Name, Topic> cache{capacity};
+    for (const auto& n : names)
+        cache.put(n, t);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        auto it = cache.find(names[i]);
+        benchmark::DoNotOptimize(it);
+        i = (i + 1) % names.size();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_LRUCacheFind)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_LRUCacheFindView(benchmark::State& state)
+{
+    const size_t capacity = size_t(state.range(0));
+    const auto names = mkNames(capacity);
+    const auto t = mkTopic("topic/name"sv, 16);
+
+    std::vector<std::string> views;
+    views.reserve(names.size());
+    for (const auto& n : names)
+        views.emplace_back(std::string_view(n));
+
+    LRUCache<Topic::Name, Topic> cache{capacity};
+    for (const auto& n : names)
+        cache.put(n, t);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        // lookup by string view, as done upon delivery.
+        auto it = cache.find(std::string_view(views[i]));
+        benchmark::DoNotOptimize(it);
+        i = (i + 1) % views.size();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_LRUCacheFindView)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_LRUCacheEmplace(benchmark::State& state)
+{
+    const size_t capacity = size_t(state.range(0));
+    const auto names = mkNames(capacity * 2);
+
+    LRUCache<Topic::Name, LRUCache<Uuid, Topic>> cache{capacity};
+
+    size_t i = 0;
+    for (auto _ : state) {
+        // nested cache is constructed in place, as done by broker storage.
+        cache.emplace(names[i], 8);
+        i = (i + 1) % names.size();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_LRUCacheEmplace)->Arg(1024)->Arg(64 * 1024);
+
+
+static void BM_LRUCacheGetPut(benchmark::State& state)
+{
+    const size_t capacity = size_t(state.range(0));
+    const auto names = mkNames(capacity);
+    const auto t = mkTopic("topic/name"sv, 16);
+
+    LRUCache<Topic::Name, Topic> cache{capacity};
+    for (const auto& n : names)
+        cache.put(n, t);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        // item is moved out and back in, recycling its node.
+        auto el = cache.get(names[i]);
+        cache.put(std::move(el->first), std::move(el->second));
+        i = (i + 1) % names.size();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_LRUCacheGetPut)->Arg(1024)->Arg(64 * 1024);
+
+
+namespace {
+constexpr size_t ConcurrentNames = 16 * 1024;
+
+/**
+ * Mixed workload of a last value cache: one put every eight lookups.
+ */
+template<typename Put, typename Find>
+void runConcurrentCache(benchmark::State& state, Put&& put, Find&& find)
+{
+    static const auto names = mkNames(ConcurrentNames);
+
+    size_t i = size_t(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        const auto& n = names[i % names.size()];
+        if (i % 8 == 0)
+            put(n, i);
+        else
+            benchmark::DoNotOptimize(find(n));
+        ++i;
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+} // namespace
+
+
+static void BM_LRUCacheMutex(benchmark::State& state)
+{
+    static std::mutex mtx;
+    static LRUCache<Topic::Name, uint64_t> cache{ConcurrentNames};
+
+    runConcurrentCache(
+        state,
+        [](const Topic::Name& n, uint64_t v) {
+            std::lock_guard<std::mutex> lock(mtx);
+            cache.put(n, v);
+        },
+        [](const Topic::Name& n) {
+            std::lock_guard<std::mutex> lock(mtx);
+            const auto it = cache.find(n);
+            return it != cache.list().end() ? it->second : 0;
+        });
+}
+BENCHMARK(BM_LRUCacheMutex)->ThreadRange(1, 16)->UseRealTime();
+
+
+static void BM_ConcurrentLRUCache(benchmark::State& state)
+{
+    static ConcurrentLRUCache<Topic::Name, uint64_t> cache{64, ConcurrentNames / 64};
+
+    runConcurrentCache(
+        state,
+        [](const Topic::Name& n, uint64_t v) {
+            cache.put(n, v);
+        },
+        [](const Topic::Name& n) {
+            return cache.find(n).value_or(0);
+        });
+}
+BENCHMARK(BM_ConcurrentLRUCache)->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,499 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "fuurin/broker.h"
+#include "fuurin/logger.h"
+#include "fuurin/worker.h"
+#include "fuurin/event.h"
+#include "fuurin/topic.h"
+#include "fuurin/uuid.h"
+#include "fuurin/stats.h"
+#include "fuurin/zmqcontext.h"
+#include "fuurin/zmqsocket.h"
+#include "fuurin/zmqtimer.h"
+#include "fuurin/zmqpart.h"
+#include "fuurin/zmqpartmulti.h"
+#include "topiclog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace fuurin;
+using namespace std::literals::chrono_literals;
+using namespace std::literals::string_view_literals;
+
+
+namespace {
+/// Transport used by benchmarks, passed as first argument.
+enum Transport : int64_t
+{
+    Ipc,
+    Tcp,
+};
+
+
+/// Timeout for any expected event.
+constexpr auto EventTimeout = 5s;
+
+
+/**
+ * \brief Broker and some workers connected together.
+ *
+ * Every worker is connected to the same broker and
+ * the cluster is ready after every worker is online.
+ *
+ * Events are waited for with a single periodic watchdog timer,
+ * so that no timer is created within the measured loops.
+ */
+class Cluster
+{
+public:
+    Cluster(Transport trans, size_t workers, const std::string& storage = {}, size_t storageTopics = 0)
+        : broker_{Uuid::createRandomUuid(), "bench_broker"}
+        , watchdog_{&ctx_, "bench_watchdog"}
+    {
+        std::vector<std::string> delivery, dispatch, snapshot;
+
+        switch (trans) {
+        case Ipc:
+            delivery = {"ipc:///tmp/fuurin_bench_delivery"};
+            dispatch = {"ipc:///tmp/fuurin_bench_dispatch"};
+            snapshot = {"ipc:///tmp/fuurin_bench_snapshot"};
+            break;
+        case Tcp:
+            delivery = {"tcp://127.0.0.1:50501"};
+            dispatch = {"tcp://127.0.0.1:50502"};
+            snapshot = {"tcp://127.0.0.1:50503"};
+            break;
+        }
+
+        broker_.setEndpoints(delivery, dispatch, snapshot);
+        if (!storage.empty())
+            broker_.setStorageFile(storage);
+
+        if (const auto [topics, versions, workers] = broker_.storageCapacity(); storageTopics > topics)
+            broker_.setStorageCapacity(storageTopics, versions, workers);
+
+        watchdog_.setInterval(EventTimeout);
+        watchdog_.setSingleShot(false);
+
+        for (size_t i = 0; i < workers; ++i) {
+            auto& w = workers_.emplace_back(std::make_unique<Worker>(
+                Uuid::createRandomUuid(), 0, "bench_worker" + std::to_string(i)));
+            w->setEndpoints(delivery, dispatch, snapshot);
+        }
+    }
+
+    ~Cluster() noexcept
+    {
+        for (auto& w : workers_)
+            w->stop();
+        broker_.stop();
+
+        for (auto& f : futures_)
+            f.get();
+    }
+
+    /**
+     * \brief Sets busy polling of every session and of workers' main thread.
+     *
+     * When there are enough CPUs, broker and workers sessions
+     * are pinned to different CPUs, so that spinning threads
+     * don't compete with each other.
+     */
+    void setBusyPoll(std::chrono::microseconds spin)
+    {
+        const bool pin = spin.count() > 0 && std::thread::hardware_concurrency() >= 3;
+
+        broker_.setBusyPoll(spin);
+        if (pin)
+            broker_.setCpuAffinity({1});
+
+        for (auto& w : workers_) {
+            w->setBusyPoll(spin);
+            if (pin)
+                w->setCpuAffinity({2});
+        }
+    }
+
+    bool start()
+    {
+        futures_.push_back(broker_.start());
+        for (auto& w : workers_)
+            futures_.push_back(w->start());
+
+        for (auto& w : workers_) {
+            if (!w->waitForOnline(EventTimeout))
+                return false;
+        }
+
+        watchdog_.start();
+
+        return true;
+    }
+
+    /**
+     * \brief Waits for an event of a worker.
+     *
+     * The wait times out after a full period of the watchdog has elapsed
+     * without any matching event, i.e. after \ref EventTimeout up to
+     * twice as much.
+     *
+     * \param[in] i Index of the worker.
+     * \param[in] match Types of event to wait for.
+     *
+     * \return The event, or an invalid event in case of timeout.
+     */
+    Event waitForEvent(size_t i, std::initializer_list<Event::Type> match)
+    {
+        for (int ticks = 0; ticks < 2;) {
+            const auto ev = workers_.at(i)->waitForEvent(&watchdog_);
+
+            if (ev.notification() == Event::Notification::Timeout) {
+                watchdog_.consume();
+                ++ticks;
+                continue;
+            }
+
+            if (std::find(match.begin(), match.end(), ev.type()) != match.end())
+                return ev;
+        }
+
+        return {};
+    }
+
+    /**
+     * \return Whether a topic was delivered to a worker.
+     *
+     * \see waitForEvent(size_t, std::initializer_list<Event::Type>)
+     */
+    bool waitForTopic(size_t i)
+    {
+        return waitForEvent(i, {Event::Type::Delivery}).type() == Event::Type::Delivery;
+    }
+
+    Worker& worker(size_t i)
+    {
+        return *workers_.at(i);
+    }
+
+    size_t size() const
+    {
+        return workers_.size();
+    }
+
+
+private:
+    Broker broker_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::future<void>> futures_;
+    zmq::Context ctx_;
+    zmq::Timer watchdog_;
+};
+
+
+const char* transportLabel(int64_t trans)
+{
+    return trans == Tcp ? "tcp" : "ipc";
+}
+} // namespace
+
+
+/**
+ * Worker and broker sessions own a different ZMQ context each,
+ * so they can't be connected through inproc transport. This is the
+ * floor of the round trip: a topic through two RADIO/DISH hops over
+ * inproc transport, including its packing and unpacking.
+ */
+static void BM_RoundTripInproc(benchmark::State& state)
+{
+    zmq::Context ctx;
+    zmq::Socket up1{&ctx, zmq::Socket::RADIO}, up2{&ctx, zmq::Socket::DISH};
+    zmq::Socket down1{&ctx, zmq::Socket::RADIO}, down2{&ctx, zmq::Socket::DISH};
+
+    up1.setEndpoints({"inproc://bench_up"});
+    up2.setEndpoints({"inproc://bench_up"});
+    down1.setEndpoints({"inproc://bench_down"});
+    down2.setEndpoints({"inproc://bench_down"});
+    up2.setGroups({"up"});
+    down2.setGroups({"down"});
+
+    up1.connect();
+    down1.connect();
+    up2.bind();
+    down2.bind();
+
+    std::this_thread::sleep_for(500ms);
+
+    const Topic t{Uuid::createRandomUuid(), Uuid::createRandomUuid(), 1,
+        "bench/roundtrip"sv, zmq::Part{std::string(size_t(state.range(0)), 'x')}, Topic::Event};
+
+    for (auto _ : state) {
+        zmq::Part p;
+
+        up1.send(t.toPart().withGroup("up"));
+        up2.recv(&p);
+
+        down1.send(Topic::fromPart(p).toPart().withGroup("down"));
+        down2.recv(&p);
+
+        benchmark::DoNotOptimize(Topic::fromPart(p));
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_RoundTripInproc)->Arg(16)->Arg(1024)->UseRealTime();
+
+
+/**
+ * Latency of a topic from a worker to the broker and back.
+ */
+static void BM_RoundTrip(benchmark::State& state)
+{
+    state.SetLabel(transportLabel(state.range(0)));
+
+    Cluster c{Transport(state.range(0)), 1};
+    if (!c.start()) {
+        state.SkipWithError("cluster did not start");
+        return;
+    }
+
+    auto& w = c.worker(0);
+    const zmq::Part data{std::string(size_t(state.range(1)), 'x')};
+
+    for (auto _ : state) {
+        w.dispatch("bench/roundtrip"sv, data, Topic::Event);
+
+        if (!c.waitForTopic(0)) {
+            state.SkipWithError("topic was not delivered");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_RoundTrip)
+    ->ArgsProduct({{Ipc, Tcp}, {16, 1024}})
+    ->UseRealTime();
+
+
+/**
+ * Percentiles of the round trip latency, with and without busy polling.
+ * Busy polling pays off only when every spinning thread has its own CPU.
+ */
+static void BM_RoundTripBusyPoll(benchmark::State& state)
+{
+    const auto spin = std::chrono::microseconds(state.range(0));
+    state.SetLabel(spin.count() > 0 ? "busy-poll" : "blocking");
+
+    Cluster c{Ipc, 1};
+    c.setBusyPoll(spin);
+
+    if (!c.start()) {
+        state.SkipWithError("cluster did not start");
+        return;
+    }
+
+    auto& w = c.worker(0);
+    const zmq::Part data{std::string(16, 'x')};
+    Histogram latency;
+
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+
+        w.dispatch("bench/roundtrip"sv, data, Topic::Event);
+
+        if (!c.waitForTopic(0)) {
+            state.SkipWithError("topic was not delivered");
+            break;
+        }
+
+        latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start));
+    }
+
+    const auto snap = latency.snapshot();
+    state.counters["p50_us"] = double(snap.percentile(0.50)) / 1e3;
+    state.counters["p99_us"] = double(snap.percentile(0.99)) / 1e3;
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+BENCHMARK(BM_RoundTripBusyPoll)
+    ->ArgName("spin_us")
+    ->Arg(0)
+    ->Arg(200)
+    ->UseRealTime();
+
+
+/**
+ * Cost of debug logs along the dispatch and delivery path.
+ *
+ * Messages are discarded by a silent handler, so the difference between
+ * the enabled and disabled levels is the construction of log arguments.
+ * Build with -DENABLE_LOG_DEBUG_INFO=OFF to compare against logs compiled out.
+ */
+static void BM_RoundTripDebugLog(benchmark::State& state)
+{
+    const auto level = log::Level(state.range(0));
+
+#if !defined(NDEBUG) && !defined(LOG_DISABLE_DEBUG_INFO)
+    state.SetLabel(level == log::Level::Debug ? "debug-enabled" : "debug-disabled");
+#else
+    state.SetLabel("debug-compiled-out");
+#endif
+
+    log::Logger::installContentHandler(new log::SilentHandler);
+    log::Logger::setLevel(level);
+
+    {
+        Cluster c{Ipc, 1};
+        if (!c.start()) {
+            state.SkipWithError("cluster did not start");
+        } else {
+            auto& w = c.worker(0);
+            const zmq::Part data{std::string(16, 'x')};
+
+            for (auto _ : state) {
+                w.dispatch("bench/roundtrip"sv, data, Topic::Event);
+
+                if (!c.waitForTopic(0)) {
+                    state.SkipWithError("topic was not delivered");
+                    break;
+                }
+            }
+
+            state.SetItemsProcessed(int64_t(state.iterations()));
+        }
+    }
+
+    log::Logger::setLevel(log::Level::Error);
+    log::Logger::installContentHandler(new log::StandardHandler);
+}
+BENCHMARK(BM_RoundTripDebugLog)
+    ->ArgName("level")
+    ->Arg(int64_t(log::Level::Debug))
+    ->Arg(int64_t(log::Level::Error))
+    ->UseRealTime();
+
+
+/**
+ * Latency of a topic from a worker to the broker and
+ * then to every subscriber, the last one included.
+ */
+static void BM_FanOut(benchmark::State& state)
+{
+    state.SetLabel(transportLabel(state.range(0)));
+
+    const size_t subscribers = size_t(state.range(1));
+
+    // first worker is the producer.
+    Cluster c{Transport(state.range(0)), subscribers + 1};
+    c.worker(0).setTopicsNames({});
+
+    if (!c.start()) {
+        state.SkipWithError("cluster did not start");
+        return;
+    }
+
+    const zmq::Part data{std::string(16, 'x')};
+
+    for (auto _ : state) {
+        c.worker(0).dispatch("bench/fanout"sv, data, Topic::Event);
+
+        for (size_t i = 1; i < c.size(); ++i) {
+            if (!c.waitForTopic(i)) {
+                state.SkipWithError("topic was not delivered");
+                return;
+            }
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(subscribers));
+}
+BENCHMARK(BM_FanOut)
+    ->ArgsProduct({{Ipc, Tcp}, {1, 10, 100}})
+    ->UseRealTime();
+
+
+/**
+ * Duration of a snapshot synchronization.
+ *
+ * Broker storage is preloaded from a file, so that
+ * setup doesn't depend on the dispatch throughput.
+ */
+static void BM_Sync(benchmark::State& state)
+{
+    state.SetLabel(transportLabel(state.range(0)));
+
+    const size_t topics = size_t(state.range(1));
+    const std::string storage = "/tmp/fuurin_bench_storage";
+
+    std::remove(storage.c_str());
+    std::remove((storage + ".log").c_str());
+
+    TopicLog{storage}.compact([topics](const TopicLog::WriteFunc& write) {
+        const auto wid = Uuid::createRandomUuid();
+        const zmq::Part data{std::string(16, 'x')};
+
+        for (size_t i = 0; i < topics; ++i)
+            write(Topic{Uuid{}, wid, Topic::SeqN(i + 1), Topic::Name{"bench/sync/" + std::to_string(i)}, data, Topic::State});
+    });
+
+    Cluster c{Transport(state.range(0)), 1, storage, topics};
+    if (!c.start()) {
+        state.SkipWithError("cluster did not start");
+        return;
+    }
+
+    auto& w = c.worker(0);
+    size_t elements = 0;
+
+    for (auto _ : state) {
+        w.sync();
+
+        for (bool done = false; !done;) {
+            const auto ev = c.waitForEvent(0, {Event::Type::SyncElement,
+                                                  Event::Type::SyncSuccess, Event::Type::SyncError});
+
+            switch (ev.type()) {
+            case Event::Type::SyncElement:
+                ++elements;
+                break;
+            case Event::Type::SyncSuccess:
+                done = true;
+                break;
+            case Event::Type::SyncError:
+            case Event::Type::Invalid:
+                state.SkipWithError("sync failed");
+                return;
+            default:
+                break;
+            }
+        }
+    }
+
+    state.counters["elements"] = benchmark::Counter(double(elements), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(int64_t(elements));
+
+    std::remove(storage.c_str());
+    std::remove((storage + ".log").c_str());
+}
+BENCHMARK(BM_Sync)
+    ->ArgsProduct({{Ipc, Tcp}, {1, 10, 100, 1000, 100000, 1000000}})
+    ->UseRealTime();
@@ -0,0 +1,466 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "fuurin/broker.h"
+#include "fuurin/worker.h"
+#include "fuurin/event.h"
+#include "fuurin/topic.h"
+#include "fuurin/stats.h"
+#include "fuurin/logger.h"
+#include "fuurin/zmqpart.h"
+#include "fuurin/zmqcontext.h"
+#include "fuurin/zmqtimer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+using namespace fuurin;
+using namespace std::literals::string_view_literals;
+using namespace std::literals::chrono_literals;
+
+
+namespace {
+const char* const Usage = R"(Usage: fuurin_loadgen [OPTION]...
+Drives producer and consumer workers against a broker and reports
+throughput, delivery latency, lost and duplicated topics.
+
+Options:
+  --producers=N      Number of producer workers (default 1).
+  --consumers=N      Number of consumer workers (default 1).
+  --rate=N           Topics per second of all producers, 0 is unlimited (default 1000).
+  --size=MIN[:MAX]   Payload size, uniformly distributed, at least 8 bytes (default 64).
+  --topics=N         Number of topic names (default 16).
+  --duration=SEC     Duration of load (default 10).
+  --delivery=ADDR    Delivery endpoint (default ipc:///tmp/fuurin_loadgen_delivery).
+  --dispatch=ADDR    Dispatch endpoint (default ipc:///tmp/fuurin_loadgen_dispatch).
+  --snapshot=ADDR    Snapshot endpoint (default ipc:///tmp/fuurin_loadgen_snapshot).
+  --tcp=PORT         Use tcp loopback endpoints at ports PORT, PORT+1 and PORT+2.
+  --no-broker        Don't run a broker, but connect to an external one.
+  --reconnect=SEC    Every period, consumers disconnect and connect again (default 0, disabled).
+  --sync=SEC         Every period, consumers synchronize (default 0, disabled).
+  --help             Print this help.
+)";
+
+
+/**
+ * \brief Load generator options.
+ */
+struct Options
+{
+    size_t producers = 1;
+    size_t consumers = 1;
+    size_t rate = 1000;
+    size_t sizeMin = 64;
+    size_t sizeMax = 64;
+    size_t topics = 16;
+    std::chrono::seconds duration = 10s;
+    std::string delivery = "ipc:///tmp/fuurin_loadgen_delivery";
+    std::string dispatch = "ipc:///tmp/fuurin_loadgen_dispatch";
+    std::string snapshot = "ipc:///tmp/fuurin_loadgen_snapshot";
+    bool broker = true;
+    std::chrono::seconds reconnect = 0s;
+    std::chrono::seconds sync = 0s;
+};
+
+
+/**
+ * \brief Parses command line options.
+ *
+ * \param[in] argc Command line \c argc.
+ * \param[in] argv Command line \c argv.
+ * \param[out] opts Parsed options.
+ *
+ * \return Whether options are valid.
+ */
+bool parseOptions(int argc, char** argv, Options* opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+        const auto eq = arg.find('=');
+        const auto key = arg.substr(0, eq);
+        const std::string val{eq == std::string_view::npos ? ""sv : arg.substr(eq + 1)};
+        const auto num = [&val]() { return size_t(std::strtoull(val.c_str(), nullptr, 10)); };
+
+        if (key == "--producers") {
+            opts->producers = num();
+        } else if (key == "--consumers") {
+            opts->consumers = num();
+        } else if (key == "--rate") {
+            opts->rate = num();
+        } else if (key == "--size") {
+            const auto sep = val.find(':');
+            opts->sizeMin = num();
+            opts->sizeMax = sep == std::string::npos
+                ? opts->sizeMin
+                : size_t(std::strtoull(val.c_str() + sep + 1, nullptr, 10));
+        } else if (key == "--topics") {
+            opts->topics = num();
+        } else if (key == "--duration") {
+            opts->duration = std::chrono::seconds(num());
+        } else if (key == "--delivery") {
+            opts->delivery = val;
+        } else if (key == "--dispatch") {
+            opts->dispatch = val;
+        } else if (key == "--snapshot") {
+            opts->snapshot = val;
+        } else if (key == "--tcp") {
+            const auto port = num();
+            opts->delivery = "tcp://127.0.0.1:" + std::to_string(port);
+            opts->dispatch = "tcp://127.0.0.1:" + std::to_string(port + 1);
+            opts->snapshot = "tcp://127.0.0.1:" + std::to_string(port + 2);
+        } else if (key == "--no-broker") {
+            opts->broker = false;
+        } else if (key == "--reconnect") {
+            opts->reconnect = std::chrono::seconds(num());
+        } else if (key == "--sync") {
+            opts->sync = std::chrono::seconds(num());
+        } else {
+            return false;
+        }
+    }
+
+    opts->sizeMin = std::max(opts->sizeMin, sizeof(uint64_t));
+    opts->sizeMax = std::max(opts->sizeMax, opts->sizeMin);
+
+    return opts->producers > 0 && opts->consumers > 0 && opts->topics > 0;
+}
+
+
+/// Timestamp of dispatch, which is written at the beginning of payload.
+uint64_t nowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+
+/**
+ * \brief Results of a consumer.
+ */
+struct ConsumerResult
+{
+    uint64_t delivered = 0;     ///< Topics delivered.
+    uint64_t lost = 0;          ///< Topics never delivered, by sequence number gaps.
+    uint64_t duplicated = 0;    ///< Topics delivered again, or out of order.
+    uint64_t syncElements = 0;  ///< Topics received by synchronizations.
+    uint64_t reconnections = 0; ///< Number of disconnections.
+    uint64_t syncs = 0;         ///< Number of synchronizations.
+
+    std::unordered_map<Uuid, Topic::SeqN> lastSeqN; ///< Last sequence number of every producer.
+
+    Histogram latency; ///< Delivery latency.
+};
+
+
+/**
+ * \brief Storm of events, which is triggered periodically.
+ *
+ * Every consumer compares the storm epoch against the last one it
+ * handled, so that it reacts once to each storm.
+ */
+struct Storm
+{
+    std::atomic<uint64_t> reconnect{0}; ///< Epoch of reconnections.
+    std::atomic<uint64_t> sync{0};      ///< Epoch of synchronizations.
+};
+
+
+void setEndpoints(Runner* r, const Options& opts)
+{
+    r->setEndpoints({opts.delivery}, {opts.dispatch}, {opts.snapshot});
+}
+
+
+void runProducer(Worker* w, const Options& opts, size_t index, const std::atomic<bool>* running)
+{
+    std::mt19937 rng{unsigned(index)};
+    std::uniform_int_distribution<size_t> size{opts.sizeMin, opts.sizeMax};
+
+    std::vector<Topic::Name> names;
+    for (size_t i = 0; i < opts.topics; ++i)
+        names.emplace_back("loadgen/" + std::to_string(i));
+
+    const auto period = opts.rate == 0
+        ? std::chrono::nanoseconds(0)
+        : std::chrono::nanoseconds(std::chrono::seconds(opts.producers)) / int64_t(opts.rate);
+
+    auto next = std::chrono::steady_clock::now();
+    std::string buf;
+
+    for (size_t n = 0; running->load(); ++n) {
+        buf.assign(size(rng), 'x');
+
+        const zmq::Part ts{nowNs()};
+        std::memcpy(buf.data(), ts.data(), ts.size());
+
+        w->dispatch(names[(n + index) % names.size()], zmq::Part{buf});
+
+        if (period.count() > 0) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
+
+
+void collectDelivery(const Topic& t, ConsumerResult* res)
+{
+    ++res->delivered;
+
+    if (t.data().size() >= sizeof(uint64_t)) {
+        const uint64_t sent = zmq::Part{t.data().data(), sizeof(uint64_t)}.toUint64();
+        res->latency.record(std::chrono::nanoseconds(int64_t(nowNs() - sent)));
+    }
+
+    auto& last = res->lastSeqN.try_emplace(t.worker(), 0).first->second;
+
+    if (t.seqNum() <= last) {
+        ++res->duplicated;
+        return;
+    }
+
+    res->lost += t.seqNum() - last - 1;
+    last = t.seqNum();
+}
+
+
+void runConsumer(Worker* w, std::future<void>* f, const Storm* storm, const std::atomic<bool>* running, ConsumerResult* res)
+{
+    uint64_t reconnEpoch = 0;
+    uint64_t syncEpoch = 0;
+
+    /**
+     * Waiting for events with a timeout creates a cancellation
+     * every time, which is expensive, so a periodic timer
+     * is used instead, to check whether to stop.
+     */
+    zmq::Context ctx;
+    zmq::Timer tick{&ctx, "loadgen_tick"};
+    tick.setInterval(100ms);
+    tick.start();
+
+    while (running->load()) {
+        if (const auto e = storm->reconnect.load(); e != reconnEpoch) {
+            reconnEpoch = e;
+            ++res->reconnections;
+
+            w->stop();
+            w->waitForStopped(5s);
+            f->get();
+
+            *f = w->start();
+            w->waitForOnline(5s);
+        }
+
+        if (const auto e = storm->sync.load(); e != syncEpoch) {
+            syncEpoch = e;
+            ++res->syncs;
+            w->sync();
+        }
+
+        const auto ev = w->waitForEvent(tick);
+
+        switch (ev.type()) {
+        case Event::Type::Invalid:
+            tick.consume();
+            break;
+        case Event::Type::Delivery:
+            collectDelivery(Topic::fromPart(ev.payload()), res);
+            break;
+        case Event::Type::SyncElement:
+            ++res->syncElements;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+
+void printLatency(std::string_view label, const Histogram::Snapshot& s)
+{
+    const auto us = [](double ns) { return ns / 1000.0; };
+
+    std::cout << std::fixed << std::setprecision(1)
+              << label << " latency (us):"
+              << " mean " << us(s.mean())
+              << ", p50 " << us(double(s.percentile(0.50)))
+              << ", p99 " << us(double(s.percentile(0.99)))
+              << ", p999 " << us(double(s.percentile(0.999)))
+              << ", max " << us(double(s.max))
+              << "\n";
+}
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parseOptions(argc, argv, &opts)) {
+        std::cerr << Usage;
+        return 1;
+    }
+
+    log::Logger::setLevel(log::Level::Warn);
+
+    std::unique_ptr<Broker> broker;
+    std::future<void> brokerFuture;
+    if (opts.broker) {
+        broker = std::make_unique<Broker>(Uuid::createRandomUuid(), "loadgen_broker");
+        setEndpoints(broker.get(), opts);
+        brokerFuture = broker->start();
+    }
+
+    std::vector<std::unique_ptr<Worker>> producers, consumers;
+    std::vector<std::future<void>> prodFutures, consFutures;
+
+    for (size_t i = 0; i < opts.producers; ++i) {
+        auto& w = producers.emplace_back(std::make_unique<Worker>(
+            Uuid::createRandomUuid(), 0, "loadgen_producer" + std::to_string(i)));
+        setEndpoints(w.get(), opts);
+        w->setTopicsNames({});
+        prodFutures.push_back(w->start());
+    }
+
+    for (size_t i = 0; i < opts.consumers; ++i) {
+        auto& w = consumers.emplace_back(std::make_unique<Worker>(
+            Uuid::createRandomUuid(), 0, "loadgen_consumer" + std::to_string(i)));
+        setEndpoints(w.get(), opts);
+        consFutures.push_back(w->start());
+    }
+
+    for (auto& w : producers) {
+        if (!w->waitForOnline(5s)) {
+            std::cerr << "Error: producer " << w->name() << " is not online\n";
+            return 1;
+        }
+    }
+    for (auto& w : consumers) {
+        if (!w->waitForOnline(5s)) {
+            std::cerr << "Error: consumer " << w->name() << " is not online\n";
+            return 1;
+        }
+    }
+
+    std::atomic<bool> producing{true}, consuming{true};
+    Storm storm;
+
+    std::vector<ConsumerResult> results(opts.consumers);
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < opts.consumers; ++i) {
+        threads.emplace_back(runConsumer, consumers[i].get(), &consFutures[i],
+            &storm, &consuming, &results[i]);
+    }
+
+    // producers shall consume their events too.
+    std::vector<std::thread> drains;
+    for (auto& w : producers)
+        drains.emplace_back([&w]() { w->waitForStopped(); });
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < opts.producers; ++i)
+        threads.emplace_back(runProducer, producers[i].get(), std::cref(opts), i, &producing);
+
+    for (auto t = t0; t < t0 + opts.duration; t += 1s) {
+        std::this_thread::sleep_until(t + 1s);
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(t + 1s - t0);
+        if (opts.reconnect.count() > 0 && elapsed.count() % opts.reconnect.count() == 0)
+            ++storm.reconnect;
+        if (opts.sync.count() > 0 && elapsed.count() % opts.sync.count() == 0)
+            ++storm.sync;
+    }
+
+    producing = false;
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // let in-flight topics be delivered.
+    std::this_thread::sleep_for(1s);
+    consuming = false;
+
+    for (auto& t : threads)
+        t.join();
+
+    uint64_t dispatched = 0;
+    for (auto& w : producers)
+        dispatched += w->seqNumber();
+
+    ConsumerResult total;
+    Histogram::Snapshot latency = total.latency.snapshot();
+
+    for (auto& r : results) {
+        // topics dispatched after the last delivered one are lost too.
+        for (const auto& w : producers) {
+            const auto it = r.lastSeqN.find(w->uuid());
+            r.lost += w->seqNumber() - (it == r.lastSeqN.end() ? 0 : it->second);
+        }
+
+        total.delivered += r.delivered;
+        total.lost += r.lost;
+        total.duplicated += r.duplicated;
+        total.syncElements += r.syncElements;
+        total.reconnections += r.reconnections;
+        total.syncs += r.syncs;
+
+        const auto s = r.latency.snapshot();
+        latency.count += s.count;
+        latency.sum += s.sum;
+        latency.max = std::max(latency.max, s.max);
+        for (size_t i = 0; i < s.buckets.size(); ++i)
+            latency.buckets[i] += s.buckets[i];
+    }
+
+    for (auto& w : producers)
+        w->stop();
+    for (auto& w : consumers)
+        w->stop();
+    if (broker)
+        broker->stop();
+
+    for (auto& t : drains)
+        t.join();
+    for (auto& f : prodFutures)
+        f.get();
+    for (auto& f : consFutures)
+        f.get();
+    if (brokerFuture.valid())
+        brokerFuture.get();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Duration: " << elapsed << " s\n"
+              << "Producers: " << opts.producers << ", consumers: " << opts.consumers << "\n"
+              << "Dispatched: " << dispatched << " (" << double(dispatched) / elapsed << " topics/s)\n"
+              << "Delivered: " << total.delivered << " (" << double(total.delivered) / elapsed << " topics/s)\n"
+              << "Lost: " << total.lost << ", duplicated: " << total.duplicated << "\n"
+              << "Reconnections: " << total.reconnections
+              << ", syncs: " << total.syncs
+              << ", sync elements: " << total.syncElements << "\n";
+
+    printLatency("Delivery", latency);
+
+    return 0;
+}
@@ -29,6 +29,15 @@ set(LIB_COMPILE_DEFS
 include(Coverage)
 
 
+option(ENABLE_LOG_DEBUG_INFO "Enable debug and info logs" ON)
+if (ENABLE_LOG_DEBUG_INFO)
+    message(STATUS "Debug and info logs enabled")
+else()
+    message(STATUS "Debug and info logs disabled")
+    list(APPEND LIB_COMPILE_DEFS LOG_DISABLE_DEBUG_INFO)
+endif()
+
+
 function (AddLibrary TARGET)
     message("-- Adding library ${TARGET}")
     target_compile_definitions(${TARGET} PRIVATE ${LIB_COMPILE_DEFS})
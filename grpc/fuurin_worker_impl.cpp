@@ -21,6 +21,7 @@
 #include "fuurin/uuid.h"
 #include "fuurin/logger.h"
 #include "fuurin/zmqtimer.h"
+#include "fuurin/event.h"
 
 #include <grpcpp/server_builder.h>
 
@@ -28,6 +29,8 @@
 #include <string>
 #include <optional>
 #include <vector>
+#include <array>
+#include <algorithm>
 
 
 namespace flog = fuurin::log;
@@ -64,24 +67,113 @@ T protoParse(std::string_view name, const fuurin::zmq::Part& val)
     return ret;
 }
 
+
+Event createEvent(Event_Type type)
+{
+    Event e;
+    e.set_type(type);
+    return e;
+}
+
 } // namespace
 
 
+/**
+ * \brief Stream of events, owned by the completion queue loop.
+ *
+ * Events are queued by the events loop and written by the
+ * completion queue loop, by means of a lock-free ring buffer.
+ */
+class WorkerServiceImpl::EventStream
+{
+public:
+    EventStream()
+        : writer{&ctx}
+        , tagRequest{this, StreamOp::Request}
+        , tagWrite{this, StreamOp::Write}
+        , tagFinish{this, StreamOp::Finish}
+        , tagDeadline{this, StreamOp::Deadline}
+    {
+    }
+
+    /**
+     * \brief Queues an event, called by the events loop only.
+     * \return Whether there was room for the event.
+     */
+    bool push(EventPtr ev) noexcept
+    {
+        const size_t h = head_.load(std::memory_order_relaxed);
+        if (h - tail_.load(std::memory_order_acquire) == EventQueueMax)
+            return false;
+
+        ring_[h & (EventQueueMax - 1)] = std::move(ev);
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * \brief Dequeues an event, called by the completion queue loop only.
+     * \return Whether an event was available.
+     */
+    bool pop(EventPtr* ev) noexcept
+    {
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        if (t == head_.load(std::memory_order_acquire))
+            return false;
+
+        *ev = std::move(ring_[t & (EventQueueMax - 1)]);
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+
+public:
+    grpc::ServerContext ctx;                 ///< Call context.
+    EventTimeout timeout;                    ///< Requested timeout.
+    grpc::ServerAsyncWriter<Event> writer;   ///< Call writer.
+    grpc::Alarm deadline;                    ///< Alarm for requested timeout.
+
+    StreamTag tagRequest;  ///< Tag for call request.
+    StreamTag tagWrite;    ///< Tag for event write.
+    StreamTag tagFinish;   ///< Tag for call finish.
+    StreamTag tagDeadline; ///< Tag for timeout.
+
+    std::atomic<bool> overflow{false}; ///< Whether some event was dropped.
+
+    EventPtr current;              ///< Event being written.
+    bool writing = false;          ///< Whether either a write or finish is pending.
+    bool deadlineSet = false;      ///< Whether timeout alarm is pending.
+    bool closing = false;          ///< Whether stream shall be closed.
+    bool finished = false;         ///< Whether stream was finished.
+    bool teardown = false;         ///< Whether to send teardown event upon close.
+    grpc::Status status;           ///< Status to return upon close.
+
+
+private:
+    static_assert((EventQueueMax & (EventQueueMax - 1)) == 0, "event queue size must be a power of two");
+
+    std::array<EventPtr, EventQueueMax> ring_; ///< Queued events.
+
+    alignas(64) std::atomic<size_t> head_{0}; ///< Producer position.
+    alignas(64) std::atomic<size_t> tail_{0}; ///< Consumer position.
+};
+
+
 WorkerServiceImpl::WorkerServiceImpl(const std::string& server_addr)
     : server_addr_{server_addr}
     , worker_{std::make_unique<fuurin::Worker>()}
     , zrpcClient_{std::make_unique<fuurin::zmq::Socket>(worker_->context(), fuurin::zmq::Socket::CLIENT)}
     , zrpcServer_{std::make_unique<fuurin::zmq::Socket>(worker_->context(), fuurin::zmq::Socket::SERVER)}
-    , zrpcEvents_{std::make_unique<fuurin::zmq::Socket>(worker_->context(), fuurin::zmq::Socket::RADIO)}
     , zcanc1_{std::make_unique<fuurin::zmq::Cancellation>(worker_->context(), "WorkerServiceImpl_canc1")}
-    , zcanc2_{std::make_unique<fuurin::zmq::Cancellation>(worker_->context(), "WorkerServiceImpl_canc2")}
-    , cancNum_{0}
+    , streams_{std::make_shared<const StreamList>()}
+    , teardown_{false}
+    , wakeTag_{nullptr, StreamOp::Wake}
+    , wakePending_{false}
+    , cqDown_{true}
 {
-    zrpcEvents_->setEndpoints({"inproc://rpc-events"});
     zrpcServer_->setEndpoints({"inproc://rpc-worker"});
     zrpcClient_->setEndpoints({"inproc://rpc-worker"});
 
-    zrpcEvents_->bind();
     zrpcServer_->bind();
     zrpcClient_->connect();
 
@@ -128,10 +220,11 @@ auto WorkerServiceImpl::Run(const std::string& addr, const utils::Endpoints& end
 
 void WorkerServiceImpl::shutdown()
 {
-    zcanc2_->cancel();
+    teardown_ = true;
+    wakeStreams();
 
     if (server_)
-        server_->Shutdown();
+        server_->Shutdown(std::chrono::system_clock::now() + LatencyDuration);
 
     sendRPC(RPC::SetStop);
 }
@@ -206,85 +299,39 @@ grpc::Status WorkerServiceImpl::Sync(grpc::ServerContext*,
 }
 
 
-grpc::Status WorkerServiceImpl::Dispatch(grpc::ServerContext*,
+grpc::Status WorkerServiceImpl::Dispatch(grpc::ServerContext* context,
     grpc::ServerReader<Topic>* stream, google::protobuf::Empty*)
 {
     Topic topic;
 
     while (stream->Read(&topic)) {
-        sendRPC(RPC::SetDispatch, protoSerialize(&topic));
-    }
-
-    return grpc::Status::OK;
-}
-
-
-grpc::Status WorkerServiceImpl::WaitForEvent(grpc::ServerContext* context,
-    const EventTimeout* timeout, grpc::ServerWriter<Event>* stream)
-{
-    fuurin::zmq::Socket zevDish{worker_->context(), fuurin::zmq::Socket::DISH};
-    zevDish.setEndpoints({"inproc://rpc-events"});
-    zevDish.setGroups({"EVNT"});
-    zevDish.connect();
-
-    fuurin::zmq::Cancellation tmeoCanc{worker_->context(),
-        "WorkerServiceImpl::WaitForEvent_canc#"s + std::to_string(++cancNum_)};
-
-    if (timeout->millis() > 0)
-        tmeoCanc.setDeadline(std::chrono::milliseconds{timeout->millis()});
-
-    fuurin::zmq::Poller poll{fuurin::zmq::PollerEvents::Type::Read, LatencyDuration,
-        &zevDish, zcanc2_.get(), &tmeoCanc};
-
-    const auto createEvent = [](Event_Type type) {
-        Event e;
-        e.set_type(type);
-        return e;
-    };
-
-    bool rcpSetupSent = false;
-
-    grpc::Status ret;
-
-    for (;;) {
-        const auto sock = poll.wait();
+        PendingTopic t{
+            fuurin::Topic::Name{topic.name()},
+            fuurin::Topic::Data{topic.data()},
+            topic.type() == Topic_Type_State
+                ? fuurin::Topic::State
+                : fuurin::Topic::Event,
+        };
 
-        if (context->IsCancelled())
-            return grpc::Status::CANCELLED;
+        std::unique_lock<std::mutex> lock(dispatchMutex_);
 
-        for (auto s : sock) {
-            if (s == zcanc2_.get()) {
-                stream->Write(createEvent(Event_Type_RCPTeardown));
+        while (!dispatchCond_.wait_for(lock, LatencyDuration, [this]() {
+            return dispatchQueue_.size() < DispatchQueueMax;
+        })) {
+            if (context->IsCancelled())
                 return grpc::Status::CANCELLED;
-            }
-
-            if (s == &tmeoCanc) {
-                stream->Write(createEvent(Event_Type_RCPTeardown));
-                return grpc::Status::OK;
-            }
-
-            fuurin::zmq::Part pay;
-            zevDish.recv(&pay);
+        }
 
-            const auto ev = getEvent(pay);
+        dispatchQueue_.push_back(std::move(t));
 
-            /**
-             * Either a liveness ping or an actual event
-             * from the channel, so it's alive.
-             * Thus send an Event::RCPSetup at first.
-             */
-            if (!rcpSetupSent) {
-                rcpSetupSent = true;
-                stream->Write(createEvent(Event_Type_RCPSetup));
-            }
-
-            if (ev) {
-                stream->Write(ev.value());
-            }
+        // worker main loop drains the whole queue upon wake up.
+        if (dispatchQueue_.size() == 1) {
+            lock.unlock();
+            sendRPC(RPC::SetDispatch);
         }
     }
 
-    return grpc::Status{grpc::INTERNAL, "internal error"};
+    return grpc::Status::OK;
 }
 
 
@@ -295,12 +342,31 @@ void WorkerServiceImpl::runServer(std::promise<bool>* started)
     builder.AddListeningPort(server_addr_, grpc::InsecureServerCredentials());
     builder.RegisterService(this);
 
+    cq_ = builder.AddCompletionQueue();
     server_ = builder.BuildAndStart();
 
+    if (server_) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            cqDown_ = false;
+        }
+        cqloop_ = std::async(std::launch::async, &WorkerServiceImpl::runStreams, this);
+    }
+
     started->set_value(server_ != nullptr);
 
-    if (server_)
-        server_->Wait();
+    if (!server_)
+        return;
+
+    server_->Wait();
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        cqDown_ = true;
+        cq_->Shutdown();
+    }
+
+    cqloop_.get();
 }
 
 
@@ -348,9 +414,11 @@ void WorkerServiceImpl::runEvents()
         /**
          * In case timeout has expired, then we get an event `ev` such that:
          * ev.notification() == fuurin::Event::Notification::Timeout.
-         * It's ok to forward this timeout that shall act as a liveness ping.
+         * It's ok to forward this timeout as a null event,
+         * that shall act as a liveness ping.
          */
-        zrpcEvents_->send(ev.toPart().withGroup("EVNT"));
+        auto rpcEv = getEvent(ev);
+        broadcastEvent(rpcEv ? std::make_shared<const Event>(std::move(*rpcEv)) : EventPtr{});
 
         /**
          * Checking here for global cancellation implies waiting for a time
@@ -364,6 +432,222 @@ void WorkerServiceImpl::runEvents()
 }
 
 
+void WorkerServiceImpl::broadcastEvent(EventPtr ev)
+{
+    const auto streams = std::atomic_load(&streams_);
+
+    if (streams->empty())
+        return;
+
+    for (const auto& s : *streams) {
+        if (!s->push(ev))
+            s->overflow = true;
+    }
+
+    wakeStreams();
+}
+
+
+void WorkerServiceImpl::wakeStreams()
+{
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+
+    if (wakePending_ || cqDown_)
+        return;
+
+    wakePending_ = true;
+    wake_.Set(cq_.get(), std::chrono::system_clock::now(), &wakeTag_);
+}
+
+
+void WorkerServiceImpl::runStreams()
+{
+    auto next = requestStream();
+
+    void* tag;
+    bool ok;
+
+    while (cq_->Next(&tag, &ok)) {
+        const auto t = static_cast<const StreamTag*>(tag);
+
+        if (t->op == StreamOp::Wake) {
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                wakePending_ = false;
+            }
+
+            const auto streams = std::atomic_load(&streams_);
+            for (const auto& s : *streams) {
+                if (teardown_)
+                    closeStream(s.get(), grpc::Status::CANCELLED, true);
+                else
+                    drainStream(s.get());
+            }
+            continue;
+        }
+
+        if (t->op == StreamOp::Request) {
+            if (!ok) {
+                // server is shutting down.
+                next.reset();
+                continue;
+            }
+
+            owned_.push_back(next);
+            next = requestStream();
+        }
+
+        serveStream(t->stream, t->op, ok);
+    }
+}
+
+
+auto WorkerServiceImpl::requestStream() -> std::shared_ptr<EventStream>
+{
+    auto s = std::make_shared<EventStream>();
+
+    RequestWaitForEvent(&s->ctx, &s->timeout, &s->writer,
+        cq_.get(), cq_.get(), &s->tagRequest);
+
+    return s;
+}
+
+
+void WorkerServiceImpl::serveStream(EventStream* s, StreamOp op, bool ok)
+{
+    switch (op) {
+    case StreamOp::Request: {
+        auto list = std::make_shared<StreamList>(*std::atomic_load(&streams_));
+        list->push_back(owned_.back());
+        std::atomic_store(&streams_, std::shared_ptr<const StreamList>{std::move(list)});
+
+        if (s->timeout.millis() > 0) {
+            s->deadlineSet = true;
+            s->deadline.Set(cq_.get(),
+                std::chrono::system_clock::now() + std::chrono::milliseconds{s->timeout.millis()},
+                &s->tagDeadline);
+        }
+
+        /**
+         * Stream is already in the active list,
+         * so it won't miss any further event.
+         */
+        static const auto setup = createEvent(Event_Type_RCPSetup);
+        s->writing = true;
+        s->writer.Write(setup, &s->tagWrite);
+
+        if (teardown_)
+            closeStream(s, grpc::Status::CANCELLED, true);
+        break;
+    }
+
+    case StreamOp::Write:
+        s->writing = false;
+        s->current.reset();
+
+        if (!ok)
+            closeStream(s, grpc::Status::CANCELLED, false);
+        else if (s->closing)
+            closeStream(s, s->status, s->teardown);
+        else
+            drainStream(s);
+        break;
+
+    case StreamOp::Deadline:
+        s->deadlineSet = false;
+
+        // alarm is not ok when cancelled.
+        if (ok)
+            closeStream(s, grpc::Status::OK, true);
+        break;
+
+    case StreamOp::Finish:
+        s->writing = false;
+        s->finished = true;
+        break;
+
+    case StreamOp::Wake:
+        break;
+    }
+
+    if (s->finished && !s->deadlineSet) {
+        owned_.erase(std::remove_if(owned_.begin(), owned_.end(),
+                         [s](const auto& p) { return p.get() == s; }),
+            owned_.end());
+    }
+}
+
+
+void WorkerServiceImpl::drainStream(EventStream* s)
+{
+    if (s->writing || s->closing)
+        return;
+
+    if (s->overflow) {
+        closeStream(s, grpc::Status{grpc::RESOURCE_EXHAUSTED, "too many pending events"}, false);
+        return;
+    }
+
+    EventPtr ev;
+    while (s->pop(&ev)) {
+        if (!ev) {
+            if (s->ctx.IsCancelled()) {
+                closeStream(s, grpc::Status::CANCELLED, false);
+                return;
+            }
+            continue;
+        }
+
+        s->current = std::move(ev);
+        s->writing = true;
+        s->writer.Write(*s->current, &s->tagWrite);
+        return;
+    }
+}
+
+
+void WorkerServiceImpl::closeStream(EventStream* s, grpc::Status status, bool teardown)
+{
+    if (s->finished)
+        return;
+
+    if (!s->closing) {
+        s->closing = true;
+        s->status = std::move(status);
+        s->teardown = teardown;
+
+        removeStream(s);
+
+        if (s->deadlineSet)
+            s->deadline.Cancel();
+    }
+
+    if (s->writing)
+        return;
+
+    static const auto teardownEv = createEvent(Event_Type_RCPTeardown);
+
+    s->writing = true;
+
+    if (s->teardown && !s->ctx.IsCancelled())
+        s->writer.WriteAndFinish(teardownEv, grpc::WriteOptions{}, s->status, &s->tagFinish);
+    else
+        s->writer.Finish(s->status, &s->tagFinish);
+}
+
+
+void WorkerServiceImpl::removeStream(EventStream* s)
+{
+    auto list = std::make_shared<StreamList>(*std::atomic_load(&streams_));
+
+    list->erase(std::remove_if(list->begin(), list->end(),
+                    [s](const auto& p) { return p.get() == s; }),
+        list->end());
+
+    std::atomic_store(&streams_, std::shared_ptr<const StreamList>{std::move(list)});
+}
+
+
 void WorkerServiceImpl::sendRPC(RPC type)
 {
     sendRPC(type, fuurin::zmq::Part{});
@@ -427,7 +711,7 @@ fuurin::zmq::Part WorkerServiceImpl::serveRPC(RPC type, const fuurin::zmq::Part&
         break;
 
     case RPC::SetDispatch:
-        setDispatch(protoParse<Topic>("RPC::SetDispatch"sv, pay));
+        setDispatch();
         break;
     };
 
@@ -470,20 +754,24 @@ void WorkerServiceImpl::applyEndpoints(const Endpoints& endp)
 }
 
 
-void WorkerServiceImpl::setDispatch(const Topic& topic)
+void WorkerServiceImpl::setDispatch()
 {
-    worker_->dispatch(fuurin::Topic::Name{topic.name()},
-        fuurin::Topic::Data{topic.data()},
-        topic.type() == Topic_Type_State
-            ? fuurin::Topic::State
-            : fuurin::Topic::Event);
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex_);
+        dispatchBatch_.swap(dispatchQueue_);
+    }
+
+    dispatchCond_.notify_all();
+
+    for (auto& t : dispatchBatch_)
+        worker_->dispatch(t.name, std::move(t.data), t.type);
+
+    dispatchBatch_.clear();
 }
 
-std::optional<Event> WorkerServiceImpl::getEvent(const fuurin::zmq::Part& pay) const
-{
-    // TODO: event payload is here copied, we could just use a view over 'pay'.
-    const auto ev = fuurin::Event::fromPart(pay);
 
+std::optional<Event> WorkerServiceImpl::getEvent(const fuurin::Event& ev) const
+{
     if (ev.notification() == fuurin::Event::Notification::Timeout ||
         ev.notification() == fuurin::Event::Notification::Discard ||
         ev.type() == fuurin::Event::Type::Invalid) //
@@ -14,9 +14,13 @@
 #include "worker.grpc.pb.h"
 #include "utils.h"
 
+#include "fuurin/topic.h"
+
 #include <grpc/grpc.h>
 #include <grpcpp/server.h>
 #include <grpcpp/server_context.h>
+#include <grpcpp/completion_queue.h>
+#include <grpcpp/alarm.h>
 
 #include <memory>
 #include <string>
@@ -27,6 +31,9 @@
 #include <atomic>
 #include <chrono>
 #include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
 
 
 namespace fuurin {
@@ -37,13 +44,18 @@ class Cancellation;
 } // namespace zmq
 
 class Worker;
+class Event;
 } // namespace fuurin
 
 
 /**
  * \brief GRPC server implementation.
+ *
+ * Every RPC is synchronous but \c WaitForEvent, which is served
+ * by means of the asynchronous API, in order to share the same
+ * events among many clients without any thread or socket per stream.
  */
-class WorkerServiceImpl final : public WorkerService::Service
+class WorkerServiceImpl final : public WorkerService::WithAsyncMethod_WaitForEvent<WorkerService::Service>
 {
 public:
     ///< Cancel function type, for server stopping.
@@ -52,6 +64,12 @@ public:
     ///< Latency for other monitoring events.
     static constexpr std::chrono::seconds LatencyDuration{5};
 
+    ///< Maximum number of streamed topics waiting to be dispatched.
+    static constexpr size_t DispatchQueueMax = 4096;
+
+    ///< Maximum number of events waiting to be written to each \c WaitForEvent stream.
+    static constexpr size_t EventQueueMax = 1024;
+
 
     /**
      * Disable copy.
@@ -99,7 +117,7 @@ protected:
         SetStart,         ///< Start worker and connect to the broker.
         SetStop,          ///< Stop worker and disconnect from broker.
         SetSync,          ///< Synchronize with broker.
-        SetDispatch,      ///< Dispatches data to the broker.
+        SetDispatch,      ///< Dispatches queued data to the broker.
     };
 
     ///< Underlying type of RPC kind.
@@ -156,18 +174,16 @@ protected:
 
     /**
      * \brief RPC to dispatch worker topic to broker.
+     *
+     * Streamed topics are queued and dispatched in batches by the worker
+     * main loop, which is woken up only when the queue was empty.
+     * No reply is waited for, but the stream is paused while
+     * \ref DispatchQueueMax topics are already queued.
      */
     grpc::Status Dispatch(grpc::ServerContext*,
         grpc::ServerReader<Topic>* stream,
         google::protobuf::Empty*) override;
 
-    /**
-     * \brief RPC to wait for worker/broker events.
-     */
-    grpc::Status WaitForEvent(grpc::ServerContext*,
-        const EventTimeout* timeout,
-        grpc::ServerWriter<Event>* stream) override;
-
 
 private:
     /**
@@ -189,10 +205,18 @@ private:
     void runClient();
 
     /**
-     * \brief Runs the worker main loop, to read and forwards events.
+     * \brief Runs the worker main loop, to read and broadcast events.
+     *
+     * Every event is converted once and shared with every
+     * active \c WaitForEvent stream, see \ref broadcastEvent.
      */
     void runEvents();
 
+    /**
+     * \brief Runs the completion queue loop, to serve \c WaitForEvent streams.
+     */
+    void runStreams();
+
     /**
      * \brief Shutdown the RPC server and stops the worker.
      */
@@ -236,11 +260,9 @@ private:
     void applyEndpoints(const Endpoints& endp);
 
     /**
-     * \brief Actually dispatches a topic with worker.
-     *
-     * \param[in] topic Requested topic to dispatch.
+     * \brief Actually dispatches every queued topic with worker.
      */
-    void setDispatch(const Topic& topic);
+    void setDispatch();
 
     /**
      * \brief Read an event sent by the main worker events loop.
@@ -249,7 +271,94 @@ private:
      *
      * \return A RCP event to send back to the RPC client, in case of no errors.
      */
-    std::optional<Event> getEvent(const fuurin::zmq::Part& pay) const;
+    std::optional<Event> getEvent(const fuurin::Event& ev) const;
+
+    /**
+     * \brief Stream of events requested by a \c WaitForEvent client.
+     */
+    class EventStream;
+
+    ///< Event shared among streams, a null event is a liveness ping.
+    using EventPtr = std::shared_ptr<const Event>;
+
+    ///< List of active streams.
+    using StreamList = std::vector<std::shared_ptr<EventStream>>;
+
+    /**
+     * \brief Kind of completion queue operation.
+     */
+    enum struct StreamOp : uint8_t
+    {
+        Wake,     ///< Events were queued.
+        Request,  ///< New stream was requested.
+        Write,    ///< Event was written.
+        Finish,   ///< Stream was finished.
+        Deadline, ///< Stream timeout expired.
+    };
+
+    /**
+     * \brief Tag of completion queue operation.
+     */
+    struct StreamTag
+    {
+        EventStream* stream; ///< Stream of the operation, if any.
+        StreamOp op;         ///< Operation.
+    };
+
+    /**
+     * \brief Queues an event to every active stream.
+     *
+     * Called by the events loop only.
+     *
+     * \param[in] ev Event to queue.
+     */
+    void broadcastEvent(EventPtr ev);
+
+    /**
+     * \brief Wakes up the completion queue loop.
+     *
+     * Multiple wake ups are coalesced until the loop has run.
+     */
+    void wakeStreams();
+
+    /**
+     * \brief Starts waiting for a new \c WaitForEvent stream.
+     *
+     * \return The stream, which is not yet active.
+     */
+    std::shared_ptr<EventStream> requestStream();
+
+    /**
+     * \brief Handles a completion queue operation.
+     *
+     * \param[in] s Stream of the operation.
+     * \param[in] op Completed operation.
+     * \param[in] ok Whether the operation succeeded.
+     */
+    void serveStream(EventStream* s, StreamOp op, bool ok);
+
+    /**
+     * \brief Writes the next queued event of a stream, if any.
+     *
+     * \param[in] s Stream to write to.
+     */
+    void drainStream(EventStream* s);
+
+    /**
+     * \brief Closes a stream as soon as no write is pending.
+     *
+     * \param[in] s Stream to close.
+     * \param[in] status Status to return to the client.
+     * \param[in] teardown Whether to send an \c Event::RCPTeardown at first.
+     */
+    void closeStream(EventStream* s, grpc::Status status, bool teardown);
+
+    /**
+     * \brief Removes a stream from the active list.
+     *
+     * \param[in] s Stream to remove.
+     */
+    void removeStream(EventStream* s);
 
 
 private:
@@ -260,14 +369,37 @@ private:
     const std::unique_ptr<fuurin::Worker> worker_;            ///< Fuurin worker.
     const std::unique_ptr<fuurin::zmq::Socket> zrpcClient_;   ///< ZMQ socket to send data to worker.
     const std::unique_ptr<fuurin::zmq::Socket> zrpcServer_;   ///< ZMQ socket to read data for worker.
-    const std::unique_ptr<fuurin::zmq::Socket> zrpcEvents_;   ///< ZMQ socket to send worker events.
     const std::unique_ptr<fuurin::zmq::Cancellation> zcanc1_; ///< Cancellation for worker loop.
-    const std::unique_ptr<fuurin::zmq::Cancellation> zcanc2_; ///< Cancellation for events loop.
 
-    std::atomic<uint32_t> cancNum_; ///< Value to handle multiple WaitForEvent connections.
+    std::unique_ptr<grpc::ServerCompletionQueue> cq_; ///< Completion queue for \c WaitForEvent streams.
+    std::shared_ptr<const StreamList> streams_;       ///< Active streams, atomically replaced.
+    std::vector<std::shared_ptr<EventStream>> owned_; ///< Streams not yet released, by completion queue loop.
+    std::atomic<bool> teardown_;                      ///< Whether streams shall be closed.
+
+    grpc::Alarm wake_;      ///< Alarm to wake up the completion queue loop.
+    StreamTag wakeTag_;     ///< Tag of wake up alarm.
+    std::mutex wakeMutex_;  ///< Guards the wake up alarm.
+    bool wakePending_;      ///< Whether wake up alarm is set.
+    bool cqDown_;           ///< Whether completion queue was shut down.
+
+    /**
+     * \brief Topic which was streamed but not yet dispatched.
+     */
+    struct PendingTopic
+    {
+        fuurin::Topic::Name name; ///< Topic name.
+        fuurin::Topic::Data data; ///< Topic data.
+        fuurin::Topic::Type type; ///< Topic type.
+    };
+
+    std::mutex dispatchMutex_;                  ///< Guards the dispatch queue.
+    std::condition_variable dispatchCond_;      ///< Notifies the dispatch queue was drained.
+    std::vector<PendingTopic> dispatchQueue_;   ///< Topics to dispatch.
+    std::vector<PendingTopic> dispatchBatch_;   ///< Topics being dispatched by worker main loop.
 
     std::future<void> client_; ///< Future for worker main loop.
     std::future<void> events_; ///< Future for events main loop.
+    std::future<void> cqloop_; ///< Future for completion queue loop.
     std::future<void> active_; ///< Future for worker started.
 
     std::unique_ptr<grpc::Server> server_; ///< RPC server.
@@ -21,6 +21,7 @@
 
 #include <google/protobuf/util/message_differencer.h>
 #include <grpcpp/create_channel.h>
+#include <benchmark/benchmark.h>
 
 #include <string>
 #include <future>
@@ -747,3 +748,43 @@ BOOST_DATA_TEST_CASE(testParseArgsServerAddress,
 
     BOOST_TEST(wantAddr == gotAddr);
 }
+
+
+static void BM_DispatchStream(benchmark::State& state)
+{
+    ServiceFixture fx;
+
+    waitForGRPCEvents(fx.client.get(), RCPSetupTimeout,
+        {Event::Online},
+        {Event::RCPSetup},
+        [&fx](Event_Type) {
+            BOOST_TEST(fx.client->Start());
+        });
+
+    const auto n = size_t(state.range(0));
+    std::vector<std::pair<std::string, std::string>> stream;
+    stream.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        stream.emplace_back("topic" + std::to_string(i % 100), "Hello");
+
+    uint64_t want = fx.worker->stats().dispatched;
+    for (auto _ : state) {
+        if (!fx.client->Dispatch(stream, Topic_Type_Event)) {
+            state.SkipWithError("dispatch stream failed");
+            break;
+        }
+
+        want += n;
+        while (fx.worker->stats().dispatched < want)
+            std::this_thread::yield();
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_DispatchStream)->Arg(1)->Arg(100)->Arg(10000)->UseRealTime();
+
+
+BOOST_AUTO_TEST_CASE(bench, *utf::disabled())
+{
+    ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -17,11 +17,14 @@
 #include <ostream>
 #include <initializer_list>
 #include <atomic>
+#include <cstdint>
 
 
 namespace fuurin {
 namespace log {
 
+class AsyncHandler;
+
 
 /// Type which represents an error code.
 struct ec_t
@@ -41,16 +44,19 @@ struct ec_t
  * allocations.
  *
  * However, as a special case, when the dymanic value fits the size of the
- * biggest underlying type (~16 bytes), then it's still stored in the stack,
- * without allocations.
+ * inline buffer (\ref MaxStringStackSize bytes), then it's still stored
+ * in the stack, without allocations.
  *
  * When an argument is storing an array value, heap data is always allocated
  * and reference counted.
  *
- * Reference counter is manage atomically, so it's thread-safe.
+ * Reference counter is manage atomically, so it's thread-safe, though the
+ * sole owner of the data releases it without any atomic read-modify-write.
  */
 class Arg final
 {
+    friend class AsyncHandler;
+
 public:
     /**
      * \brief Type of this argument.
@@ -59,6 +65,8 @@ public:
     {
         Invalid, ///< Invalid argument.
         Int,     ///< Integer.
+        Int64,   ///< 64 bit signed integer.
+        UInt64,  ///< 64 bit unsigned integer.
         Errno,   ///< Error Code.
         Double,  ///< Double.
         String,  ///< String.
@@ -82,6 +90,8 @@ public:
      */
     ///@{
     explicit Arg(int val) noexcept;
+    explicit Arg(int64_t val) noexcept;
+    explicit Arg(uint64_t val) noexcept;
     explicit Arg(ec_t val) noexcept;
     explicit Arg(double val) noexcept;
     explicit Arg(std::string_view val) noexcept;
@@ -105,6 +115,8 @@ public:
      */
     ///@{
     explicit Arg(std::string_view key, int val) noexcept;
+    explicit Arg(std::string_view key, int64_t val) noexcept;
+    explicit Arg(std::string_view key, uint64_t val) noexcept;
     explicit Arg(std::string_view key, ec_t val) noexcept;
     explicit Arg(std::string_view key, double val) noexcept;
     explicit Arg(std::string_view key, std::string_view val) noexcept;
@@ -147,10 +159,12 @@ public:
 
     /**
      * \return The value of this argument if the type matches the requested value,
-     *         or 0 otherwise.
+     *         or 0 otherwise. Any integer type matches a 64 bit integer value.
      */
     ///@{
     int toInt() const noexcept;
+    int64_t toInt64() const noexcept;
+    uint64_t toUInt64() const noexcept;
     double toDouble() const noexcept;
     std::string_view toString() const noexcept;
     const Arg* toArray() const noexcept;
@@ -214,6 +228,8 @@ private:
         /// Sets the value.
         ///@{
         explicit Val(int) noexcept;
+        explicit Val(int64_t) noexcept;
+        explicit Val(uint64_t) noexcept;
         explicit Val(double) noexcept;
         explicit Val(std::string_view) noexcept;
         explicit Val(Ref<char>*) noexcept;
@@ -223,13 +239,15 @@ private:
         /// Underlying type of value.
         ///@{
         int int_;
+        int64_t i64_;
+        uint64_t u64_;
         double dbl_;
         std::string_view chr_;
-        /// Underlying buffer type of value.
+        /// Underlying buffer type of value, sized to fit short dynamic strings.
         struct Buf
         {
             uint8_t siz_;
-            char dat_[sizeof(chr_) - sizeof(siz_)];
+            char dat_[2 * sizeof(chr_) - sizeof(siz_)];
         } buf_;
         Ref<char>* str_;
         Ref<Arg>* arr_;
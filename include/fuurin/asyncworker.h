@@ -0,0 +1,250 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef FUURIN_ASYNCWORKER_H
+#define FUURIN_ASYNCWORKER_H
+
+#include "fuurin/worker.h"
+#include "fuurin/event.h"
+#include "fuurin/topic.h"
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <utility>
+
+
+namespace fuurin {
+
+namespace internal {
+
+/**
+ * \brief Composed operation of \ref asyncNextEvent.
+ */
+template<typename Executor>
+class AsyncNextEventOp
+{
+public:
+    AsyncNextEventOp(const Worker* w, const Executor& ex)
+        : worker_{w}
+        , ex_{ex}
+        , started_{false}
+    {
+    }
+
+    template<typename Self>
+    void operator()(Self& self, boost::system::error_code ec = {})
+    {
+        if (ec) {
+            self.complete(ec, Event{});
+            return;
+        }
+
+        if (pending_) {
+            auto ev = std::move(*pending_);
+            pending_.reset();
+            self.complete(ec, std::move(ev));
+            return;
+        }
+
+        auto ev = worker_->waitForEvent(std::chrono::milliseconds(0));
+
+        if (ev.notification() == Event::Notification::Timeout) {
+            started_ = true;
+
+            // descriptor is registered after events were drained,
+            // so it's readable right away, if any event arrived since then.
+            desc_ = std::make_unique<boost::asio::posix::stream_descriptor>(ex_, ::dup(worker_->eventFD()));
+            desc_->async_wait(boost::asio::posix::descriptor_base::wait_read, std::move(self));
+            return;
+        }
+
+        if (!started_) {
+            // never complete within the initiating function.
+            started_ = true;
+            pending_.emplace(std::move(ev));
+            boost::asio::post(ex_, std::move(self));
+            return;
+        }
+
+        self.complete(ec, std::move(ev));
+    }
+
+
+private:
+    const Worker* worker_;                                        ///< Worker to read events from.
+    Executor ex_;                                                 ///< Executor to wait for events.
+    std::unique_ptr<boost::asio::posix::stream_descriptor> desc_; ///< Duplicate of the events descriptor.
+    std::optional<Event> pending_;                                ///< Event read upon initiation.
+    bool started_;                                                ///< Whether the operation was initiated.
+};
+
+
+/**
+ * \brief Composed operation of \ref asyncDispatch.
+ */
+template<typename Executor>
+class AsyncDispatchOp
+{
+public:
+    AsyncDispatchOp(Worker* w, const Executor& ex, Topic::Name name, Topic::Data&& data, Topic::Type type)
+        : worker_{w}
+        , timer_{std::make_unique<boost::asio::steady_timer>(ex)}
+        , name_{std::move(name)}
+        , data_{std::move(data)}
+        , type_{type}
+        , started_{false}
+    {
+    }
+
+    template<typename Self>
+    void operator()(Self& self, boost::system::error_code ec = {})
+    {
+        if (ec) {
+            self.complete(ec, Worker::DispatchResult::NotRunning);
+            return;
+        }
+
+        if (result_) {
+            self.complete(ec, *result_);
+            return;
+        }
+
+        // data is moved only when the topic is sent.
+        const auto ret = worker_->tryDispatch(name_, std::move(data_), type_);
+
+        if (ret == Worker::DispatchResult::WouldBlock) {
+            started_ = true;
+            timer_->expires_after(RetryInterval);
+            timer_->async_wait(std::move(self));
+            return;
+        }
+
+        if (!started_) {
+            // never complete within the initiating function.
+            started_ = true;
+            result_ = ret;
+            boost::asio::post(timer_->get_executor(), std::move(self));
+            return;
+        }
+
+        self.complete(ec, ret);
+    }
+
+
+public:
+    ///< Interval to retry a dispatch which would block.
+    static constexpr std::chrono::milliseconds RetryInterval{1};
+
+
+private:
+    Worker* worker_;                                   ///< Worker to dispatch to.
+    std::unique_ptr<boost::asio::steady_timer> timer_; ///< Timer to retry dispatch.
+    Topic::Name name_;                                 ///< Topic name.
+    Topic::Data data_;                                 ///< Topic data.
+    Topic::Type type_;                                 ///< Topic type.
+    std::optional<Worker::DispatchResult> result_;     ///< Result of dispatch upon initiation.
+    bool started_;                                     ///< Whether the operation was initiated.
+};
+
+} // namespace internal
+
+
+/**
+ * \brief Asynchronously waits for the next event of a worker.
+ *
+ * The operation waits for the events file descriptor of the worker,
+ * see \ref Worker::eventFD(), using the passed executor, so no thread
+ * is blocked, and it completes with the same event which would be
+ * returned by \ref Worker::waitForEvent().
+ *
+ * The completion handler is invoked through its associated executor,
+ * which defaults to the passed one. The completion signature is
+ * <tt>void(boost::system::error_code, Event)</tt>, where the error
+ * is set only when the wait was aborted, e.g. the executor's context
+ * was stopped.
+ *
+ * Any completion token is supported, e.g. a callback,
+ * \c boost::asio::use_future or, with C++20 coroutines,
+ * \c boost::asio::use_awaitable:
+ *
+ * \code
+ * auto ev = co_await asyncNextEvent(w, co_await boost::asio::this_coro::executor,
+ *     boost::asio::use_awaitable);
+ * \endcode
+ *
+ * Since \ref Worker is not thread-safe, at most one operation shall
+ * be outstanding for a worker, and the worker shall not be waited
+ * for events by other means in the meanwhile.
+ *
+ * \param[in] w Worker, it must outlive the operation.
+ * \param[in] ex Executor of an I/O context, used to wait for events.
+ * \param[in] token Completion token.
+ *
+ * \see Worker::waitForEvent(std::chrono::milliseconds)
+ */
+template<typename Executor, typename CompletionToken>
+auto asyncNextEvent(const Worker& w, const Executor& ex, CompletionToken&& token)
+{
+    return boost::asio::async_compose<CompletionToken, void(boost::system::error_code, Event)>(
+        internal::AsyncNextEventOp<Executor>{&w, ex}, token, ex);
+}
+
+
+/**
+ * \brief Asynchronously dispatches a topic.
+ *
+ * The topic is dispatched by \ref Worker::tryDispatch(), which is
+ * retried every millisecond, through a timer of the passed executor,
+ * as long as the result is \ref Worker::DispatchResult::WouldBlock.
+ * So back pressure is applied to the caller without blocking any thread.
+ *
+ * The completion handler is invoked through its associated executor,
+ * which defaults to the passed one. The completion signature is
+ * <tt>void(boost::system::error_code, Worker::DispatchResult)</tt>,
+ * where the result is either \ref Worker::DispatchResult::Sent or
+ * \ref Worker::DispatchResult::NotRunning.
+ *
+ * Like \ref asyncNextEvent, any completion token is supported:
+ *
+ * \code
+ * co_await asyncDispatch(w, ex, "topic", zmq::Part{"data"sv}, Topic::State,
+ *     boost::asio::use_awaitable);
+ * \endcode
+ *
+ * \param[in] w Worker, it must outlive the operation.
+ * \param[in] ex Executor of an I/O context, used to retry dispatch.
+ * \param[in] name Name of topic.
+ * \param[in] data Data of topic.
+ * \param[in] type Type of topic.
+ * \param[in] token Completion token.
+ *
+ * \see Worker::tryDispatch(Topic::Name, Topic::Data&&, Topic::Type)
+ */
+template<typename Executor, typename CompletionToken>
+auto asyncDispatch(Worker& w, const Executor& ex, Topic::Name name, Topic::Data data,
+    Topic::Type type, CompletionToken&& token)
+{
+    return boost::asio::async_compose<CompletionToken, void(boost::system::error_code, Worker::DispatchResult)>(
+        internal::AsyncDispatchOp<Executor>{&w, ex, std::move(name), std::move(data), type}, token, ex);
+}
+
+} // namespace fuurin
+
+#endif // FUURIN_ASYNCWORKER_H
@@ -13,9 +13,13 @@
 
 #include "fuurin/runner.h"
 #include "fuurin/uuid.h"
+#include "fuurin/stats.h"
 
 #include <memory>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <tuple>
 
 
 namespace fuurin {
@@ -39,6 +43,112 @@ public:
      */
     virtual ~Broker() noexcept;
 
+    /**
+     * \brief Sets endpoints to connect to peer brokers.
+     *
+     * Topics received from workers are forwarded to the \c dispatch
+     * endpoints of the peers, tagged with this broker's uuid.
+     * Topics forwarded by a peer are never forwarded again, so there
+     * are no loops, but peers shall be fully connected to each other.
+     * A snapshot is requested to the \c snapshot endpoints of the peers
+     * at start, and again whenever a peer reconnects, as detected by
+     * keepalives exchanged among peers, so topics lost in the meanwhile
+     * are recovered. Topics received twice are discarded by means
+     * of the per worker sequence number.
+     * By default no peer is configured.
+     *
+     * \param[in] dispatch List of peers' dispatch endpoints.
+     * \param[in] snapshot List of peers' snapshot endpoints.
+     *
+     * \see peerEndpointDispatch()
+     * \see peerEndpointSnapshot()
+     */
+    void setPeerEndpoints(const std::vector<std::string>& dispatch,
+        const std::vector<std::string>& snapshot);
+
+    /**
+     * \return Current peer endpoints.
+     *
+     * \see setPeerEndpoints(std::vector<std::string>, std::vector<std::string>)
+     */
+    ///@{
+    const std::vector<std::string>& peerEndpointDispatch() const;
+    const std::vector<std::string>& peerEndpointSnapshot() const;
+    ///@}
+
+    /**
+     * \brief Sets the persistent storage.
+     *
+     * Stored topics of type \ref Topic::State are appended to a log file,
+     * which is periodically compacted into the storage file.
+     * Appended topics are buffered and periodically flushed, so topics
+     * stored within the latest flush interval are lost in case of crash.
+     * Compaction is written in background, so file I/O never stalls
+     * the delivery of topics. I/O errors are logged and counted by
+     * \ref BrokerStats::storageErrors, while the broker keeps serving.
+     * Upon start the storage is loaded, so snapshots can be served
+     * without waiting for workers to publish their topics again.
+     * By default persistence is disabled.
+     *
+     * \param[in] path Path of the storage file, empty to disable persistence.
+     * \param[in] compaction Interval of compaction.
+     * \param[in] flush Interval of log flush.
+     *
+     * \see storageFile()
+     * \see storageCompaction()
+     * \see storageFlush()
+     */
+    void setStorageFile(const std::string& path,
+        std::chrono::milliseconds compaction = std::chrono::seconds(10),
+        std::chrono::milliseconds flush = std::chrono::milliseconds(100));
+
+    /**
+     * \return Current persistent storage settings.
+     *
+     * \see setStorageFile(const std::string&, std::chrono::milliseconds, std::chrono::milliseconds)
+     */
+    ///@{
+    const std::string& storageFile() const;
+    std::chrono::milliseconds storageCompaction() const;
+    std::chrono::milliseconds storageFlush() const;
+    ///@}
+
+    /**
+     * \brief Sets the capacity of the in memory storage.
+     *
+     * When a capacity is reached, the least recently updated
+     * element is evicted. A zero capacity means no limit.
+     * The new capacity is applied upon the next start.
+     * By default capacities are 1024 topic names, 8 workers
+     * per topic name and 64 workers.
+     *
+     * \param[in] topics Maximum number of topic names.
+     * \param[in] versions Maximum number of workers' topics per name.
+     * \param[in] workers Maximum number of workers which sequence number is tracked.
+     *
+     * \see storageCapacity()
+     */
+    void setStorageCapacity(size_t topics, size_t versions, size_t workers);
+
+    /**
+     * \return Current capacity of the in memory storage, as topics, versions and workers.
+     *
+     * \see setStorageCapacity(size_t, size_t, size_t)
+     */
+    std::tuple<size_t, size_t, size_t> storageCapacity() const;
+
+    /**
+     * \brief Returns the statistics of this broker.
+     *
+     * Statistics are recorded by the asynchronous task,
+     * without any locking, and they can be read at any time.
+     *
+     * This method is thread-safe.
+     *
+     * \return Current statistics.
+     */
+    BrokerStats stats() const;
+
 
 protected:
     /**
@@ -55,6 +165,21 @@ protected:
      * \see BrokerSession
      */
     virtual std::unique_ptr<Session> createSession() const override;
+
+
+protected:
+    const std::unique_ptr<BrokerMetrics> metrics_; ///< Metrics recorded by the session.
+
+
+private:
+    std::vector<std::string> peerDispatch_; ///< List of peer endpoints.
+    std::vector<std::string> peerSnapshot_; ///< List of peer endpoints.
+    std::string storFile_;                  ///< Storage file.
+    std::chrono::milliseconds storCompact_; ///< Storage compaction interval.
+    std::chrono::milliseconds storFlush_;   ///< Storage flush interval.
+    size_t storTopics_;                     ///< Storage capacity of topic names.
+    size_t storVersions_;                   ///< Storage capacity of workers' topics per name.
+    size_t storWorkers_;                    ///< Storage capacity of workers.
 };
 
 } // namespace fuurin
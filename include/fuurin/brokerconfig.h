@@ -15,6 +15,7 @@
 
 #include <vector>
 #include <string>
+#include <chrono>
 
 
 namespace fuurin {
@@ -39,6 +40,34 @@ struct BrokerConfig
     std::vector<std::string> endpSnapshot;
     ///@}
 
+    ///< List of peer brokers endpoints.
+    ///@{
+    std::vector<std::string> endpPeerDispatch;
+    std::vector<std::string> endpPeerSnapshot;
+    ///@}
+
+    ///< Path of the storage file, empty to disable persistence.
+    std::string storageFile;
+    ///< Interval of storage compaction.
+    std::chrono::milliseconds storageCompaction;
+    ///< Interval of storage log flush.
+    std::chrono::milliseconds storageFlush;
+
+    ///< High water marks of data sockets, zero means no limit, \see Runner::setHighWaterMark.
+    ///@{
+    int hwmSend = 0;
+    int hwmRecv = 0;
+    ///@}
+
+    ///< Kernel buffer sizes of data sockets, -1 means OS default, \see Runner::setBufferSize.
+    ///@{
+    int bufSend = -1;
+    int bufRecv = -1;
+    ///@}
+
+    ///< Maximum number of messages received per ready data socket, \see Runner::setDrainBatch.
+    int drainBatch = 32;
+
     /**
      * \brief Comparison operator.
      * \param[in] rhs Another config.
@@ -12,6 +12,7 @@
 #define FUURIN_C_BROKER_H
 
 #include "fuurin/c/cuuid.h"
+#include "fuurin/c/cstats.h"
 
 #include <stdbool.h>
 
@@ -103,6 +104,12 @@ extern "C"
      */
     bool CBroker_isRunning(CBroker* b);
 
+    /**
+     * \return Broker statistics.
+     * \param[in] b Pointer to a C broker object.
+     */
+    CBrokerStats CBroker_stats(CBroker* b);
+
 #ifdef __cplusplus
 }
 #endif
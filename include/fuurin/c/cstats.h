@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef FUURIN_C_STATS_H
+#define FUURIN_C_STATS_H
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * \brief C type for a latency histogram summary.
+     *
+     * Every value is expressed in nanoseconds.
+     */
+    typedef struct CLatency
+    {
+        unsigned long long count; ///< Number of recorded values.
+        double mean;              ///< Average value.
+        unsigned long long p50;   ///< 50th percentile.
+        unsigned long long p99;   ///< 99th percentile.
+        unsigned long long p999;  ///< 99.9th percentile.
+        unsigned long long max;   ///< Maximum value.
+    } CLatency;
+
+    /**
+     * \brief C type for worker statistics.
+     * \see fuurin::WorkerStats
+     */
+    typedef struct CWorkerStats
+    {
+        unsigned long long dispatched;      ///< Topics dispatched to broker(s).
+        unsigned long long delivered;       ///< Topics delivered from broker(s).
+        unsigned long long discarded;       ///< Topics discarded, because already delivered.
+        unsigned long long syncElements;    ///< Snapshot elements received.
+        unsigned long long syncRetries;     ///< Snapshot requests sent again after a timeout.
+        unsigned long long connTransitions; ///< Changes of connection state.
+        unsigned long long conflated;       ///< Deliveries replaced by a newer one, before being read.
+        unsigned long long dispatchBlocked; ///< Topics refused because the dispatch queue reached its high water mark.
+        unsigned long long dispatchDropped; ///< Topics dropped because the worker was not running.
+        unsigned long long handlerOverruns; ///< Calls of the delivery handler which exceeded their time budget.
+        CLatency deliveryLatency;           ///< Latency from dispatch to delivery of own topics.
+        CLatency syncLatency;               ///< Latency to download a snapshot.
+        CLatency keepaliveLatency;          ///< Latency from keepalive to its echo by broker(s).
+        CLatency handlerLatency;            ///< Latency of every call of the delivery handler.
+        unsigned long long brokerWorkers;   ///< Workers connected to the latest broker which sent a keepalive.
+        unsigned long long brokerLoad;      ///< Topics per second dispatched by that broker.
+        unsigned long long brokerTopics;    ///< Topic names stored by that broker.
+    } CWorkerStats;
+
+    /**
+     * \brief C type for broker statistics.
+     * \see fuurin::BrokerStats
+     */
+    typedef struct CBrokerStats
+    {
+        unsigned long long received;      ///< Topics received from workers.
+        unsigned long long dispatched;    ///< Topics stored and dispatched to workers.
+        unsigned long long discarded;     ///< Topics discarded, because already stored.
+        unsigned long long syncRequests;  ///< Snapshot requests served.
+        unsigned long long syncElements;  ///< Snapshot elements sent.
+        unsigned long long syncAborts;    ///< Snapshot replies aborted, because send would block.
+        unsigned long long dropped;       ///< Topics of workers lost before being received.
+        unsigned long long peerReceived;  ///< Topics received from peers, either forwarded or by snapshot.
+        unsigned long long storageErrors; ///< Errors of the persistent storage.
+        CLatency dispatchLatency;         ///< Latency to store and dispatch a topic.
+        CLatency syncLatency;             ///< Latency to send a snapshot.
+    } CBrokerStats;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUURIN_C_STATS_H
@@ -13,6 +13,7 @@
 
 #include "fuurin/c/cuuid.h"
 #include "fuurin/c/cevent.h"
+#include "fuurin/c/cstats.h"
 
 #include <stdbool.h>
 
@@ -218,6 +219,12 @@ extern "C"
      */
     int CWorker_eventFD(CWorker* w);
 
+    /**
+     * \return Worker statistics.
+     * \param[in] w Pointer to a C worker object.
+     */
+    CWorkerStats CWorker_stats(CWorker* w);
+
 #ifdef __cplusplus
 }
 #endif
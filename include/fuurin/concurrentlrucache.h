@@ -0,0 +1,332 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef FUURIN_CONCURRENTLRUCACHE_H
+#define FUURIN_CONCURRENTLRUCACHE_H
+
+#include "fuurin/lrucache.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+
+namespace fuurin {
+
+/**
+ * \brief Thread-safe Least Recently Used Cache.
+ *
+ * Items are partitioned by key hash into a number of shards,
+ * each one being a \ref LRUCache with its own capacity and lock.
+ * So threads accessing different shards never contend, and readers
+ * of the same shard share the lock, since lookups don't change
+ * the usage ordering.
+ *
+ * The least recently used item is evicted per shard, so the
+ * eviction order is approximated with respect to the whole cache.
+ *
+ * Items are never exposed by reference outside a lock,
+ * either they are copied or visited under the shard lock.
+ *
+ * \see LRUCache
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<>>
+class ConcurrentLRUCache
+{
+public:
+    ///< Item alias.
+    using Item = std::pair<K, V>;
+    ///< Cache alias of a single shard.
+    using Cache = LRUCache<K, V, Hash, Equal>;
+
+
+public:
+    /**
+     * \brief Initializes a cache.
+     *
+     * \param[in] shards Number of shards, rounded up to a power of two.
+     * \param[in] capacity Capacity of each shard, zero means infinite.
+     */
+    ConcurrentLRUCache(size_t shards, size_t capacity)
+        : bits_{shardBits(shards)}
+    {
+        shards_.reserve(size_t(1) << bits_);
+        for (size_t i = 0; i < (size_t(1) << bits_); ++i)
+            shards_.emplace_back(std::make_unique<Shard>(capacity));
+    }
+
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    ConcurrentLRUCache(const ConcurrentLRUCache&) = delete;
+    ConcurrentLRUCache& operator=(const ConcurrentLRUCache&) = delete;
+    ///@}
+
+
+    /**
+     * \brief Destructor.
+     */
+    virtual ~ConcurrentLRUCache() noexcept = default;
+
+
+    /**
+     * \return Number of shards.
+     */
+    size_t shards() const noexcept
+    {
+        return shards_.size();
+    }
+
+
+    /**
+     * \return Capacity of each shard.
+     */
+    size_t capacity() const noexcept
+    {
+        return shards_.front()->cache.capacity();
+    }
+
+
+    /**
+     * \return Cache size, summing every shard.
+     *
+     * The returned value may be stale, in case of concurrent access.
+     */
+    size_t size() const
+    {
+        size_t ret = 0;
+        for (const auto& s : shards_) {
+            std::shared_lock<std::shared_mutex> lock(s->mtx);
+            ret += s->cache.size();
+        }
+        return ret;
+    }
+
+
+    /**
+     * \return Whether cache size is zero.
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+
+    /**
+     * \brief Clears every shard.
+     */
+    void clear()
+    {
+        for (auto& s : shards_) {
+            std::unique_lock<std::shared_mutex> lock(s->mtx);
+            s->cache.clear();
+        }
+    }
+
+
+    /**
+     * \brief Puts or updates an item into the cache.
+     *
+     * \param[in] k Item's key.
+     * \param[in] v Item's value.
+     *
+     * \see LRUCache::put(KK&&, VV&&)
+     */
+    template<typename KK, typename VV>
+    void put(KK&& k, VV&& v)
+    {
+        emplace(std::forward<KK>(k), std::forward<VV>(v));
+    }
+
+
+    /**
+     * \brief Puts or updates an item into the cache, constructing its value in place.
+     *
+     * \param[in] k Item's key.
+     * \param[in] args Arguments to construct the item's value.
+     *
+     * \see LRUCache::emplace(KK&&, Args&&...)
+     */
+    template<typename KK, typename... Args>
+    void emplace(KK&& k, Args&&... args)
+    {
+        auto& s = shard(k);
+        std::unique_lock<std::shared_mutex> lock(s.mtx);
+        s.cache.emplace(std::forward<KK>(k), std::forward<Args>(args)...);
+    }
+
+
+    /**
+     * \brief Gets an item from the cache.
+     *
+     * If the passed key is contained in the cache,
+     * then it is removed and returned.
+     *
+     * \param[in] k Item's key.
+     *
+     * \return Optionally the removed item.
+     *
+     * \see LRUCache::get(const K&)
+     */
+    template<typename Q>
+    std::optional<Item> get(const Q& k)
+    {
+        auto& s = shard(k);
+        std::unique_lock<std::shared_mutex> lock(s.mtx);
+        return s.cache.get(k);
+    }
+
+
+    /**
+     * \brief Finds an item by its key.
+     *
+     * The usage ordering is not modified.
+     *
+     * \param[in] k Item's key.
+     *
+     * \return Optionally a copy of the item's value.
+     *
+     * \see LRUCache::find(const K&)
+     */
+    template<typename Q>
+    std::optional<V> find(const Q& k) const
+    {
+        std::optional<V> ret;
+        visit(k, [&ret](const V& v) { ret.emplace(v); });
+        return ret;
+    }
+
+
+    /**
+     * \brief Visits an item by its key, without copying it.
+     *
+     * The passed function is called with the shard lock held,
+     * so it shall not access this cache.
+     *
+     * \param[in] k Item's key.
+     * \param[in] f Function called with the item's value.
+     *
+     * \return Whether the item was found.
+     */
+    template<typename Q, typename F>
+    bool visit(const Q& k, F&& f) const
+    {
+        const auto& s = shard(k);
+        std::shared_lock<std::shared_mutex> lock(s.mtx);
+
+        const auto& cache = s.cache;
+        const auto it = cache.find(k);
+        if (it == cache.list().end())
+            return false;
+
+        f(it->second);
+        return true;
+    }
+
+
+    /**
+     * \brief Visits every item, shard by shard.
+     *
+     * The passed function is called with the shard lock held,
+     * so it shall not access this cache. Items of each shard are
+     * visited from the least to the most recently used one.
+     *
+     * \param[in] f Function called with every item.
+     */
+    template<typename F>
+    void forEach(F&& f) const
+    {
+        for (const auto& s : shards_) {
+            std::shared_lock<std::shared_mutex> lock(s->mtx);
+            for (const auto& v : s->cache.list())
+                f(v);
+        }
+    }
+
+
+private:
+    /**
+     * \brief Shard of the cache.
+     */
+    struct alignas(64) Shard
+    {
+        explicit Shard(size_t capacity)
+            : cache{capacity}
+        {
+        }
+
+        mutable std::shared_mutex mtx; ///< Shard lock.
+        Cache cache;                   ///< Shard items.
+    };
+
+
+    /**
+     * \return Number of bits to select a shard.
+     */
+    static unsigned shardBits(size_t shards) noexcept
+    {
+        unsigned ret = 0;
+        while ((size_t(1) << ret) < shards && ret < 16)
+            ++ret;
+        return ret;
+    }
+
+
+    /**
+     * \brief Selects the shard of a key.
+     *
+     * The high bits of the mixed hash are used, since the
+     * low bits select the hash bucket within the shard.
+     *
+     * \param[in] k Key.
+     *
+     * \return The shard.
+     */
+    ///@{
+    template<typename Q>
+    Shard& shard(const Q& k)
+    {
+        return *shards_[shardIndex(k)];
+    }
+
+    template<typename Q>
+    const Shard& shard(const Q& k) const
+    {
+        return *shards_[shardIndex(k)];
+    }
+
+    template<typename Q>
+    size_t shardIndex(const Q& k) const
+    {
+        if (bits_ == 0)
+            return 0;
+
+        const uint64_t h = uint64_t(hash_(k)) * 0x9e3779b97f4a7c15ull;
+        return size_t(h >> (64 - bits_));
+    }
+    ///@}
+
+
+private:
+    const unsigned bits_;                       ///< Number of bits to select a shard.
+    Hash hash_;                                 ///< Hash function.
+    std::vector<std::unique_ptr<Shard>> shards_; ///< Shards.
+};
+
+} // namespace fuurin
+
+#endif // FUURIN_CONCURRENTLRUCACHE_H
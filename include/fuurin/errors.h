@@ -98,6 +98,8 @@ DECL_ERROR(ZMQPartGroupFailed)
 DECL_ERROR(ZMQPollerCreateFailed)
 DECL_ERROR(ZMQPollerAddSocketFailed)
 DECL_ERROR(ZMQPollerWaitFailed)
+DECL_ERROR(StorageReadFailed)
+DECL_ERROR(StorageWriteFailed)
 
 #undef DECL_ERROR
 
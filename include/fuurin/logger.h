@@ -14,6 +14,9 @@
 #include "fuurin/arg.h"
 
 #include <memory>
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
 
 
 namespace fuurin {
@@ -29,6 +32,19 @@ struct Loc
 };
 
 
+/**
+ * \brief Level of the log message.
+ */
+enum struct Level : uint8_t
+{
+    Debug, ///< Debug message.
+    Info,  ///< Information message.
+    Warn,  ///< Warning message.
+    Error, ///< Error message.
+    Fatal, ///< Fatal message, it can't be disabled.
+};
+
+
 /**
  * \brief Interface for a generic content handler.
  * User code shall derive this class to implement custom logging.
@@ -101,6 +117,112 @@ class SilentHandler : public Handler
     ///@}
 };
 
+/**
+ * \brief Logging handler which defers the content to a background thread.
+ *
+ * Every calling thread owns a lock-free single producer ring buffer,
+ * where it pushes a compact binary copy of the log content, that
+ * is location, level and arguments values (strings are copied too).
+ * A background thread pops the records from every ring and it
+ * passes them to the sink handler, which actually formats and writes
+ * the content. The order of records is preserved within the same
+ * calling thread only. The background thread is woken up as soon
+ * as a record is pushed, unless it was already signaled.
+ * A ring is released when its thread exits, and it's reused by
+ * the next thread which logs for the first time.
+ *
+ * When a ring is full, the record is either discarded or the calling
+ * thread waits for room, depending on the \ref Overflow policy.
+ * A \c fatal log always waits for every pending record to be written
+ * and then it's passed to the sink on the calling thread.
+ *
+ * \see Handler
+ */
+class AsyncHandler : public Handler
+{
+public:
+    /**
+     * \brief Policy to apply when a ring buffer is full.
+     */
+    enum struct Overflow
+    {
+        Drop,  ///< Records are discarded and counted.
+        Block, ///< Calling thread waits until there is room.
+    };
+
+
+public:
+    /**
+     * \brief Starts the background thread.
+     *
+     * \param[in] sink Handler which writes the content, or \c nullptr
+     *      to use a \ref StandardHandler. The ownership of the object is taken.
+     * \param[in] policy Policy to apply when a ring buffer is full.
+     * \param[in] capacity Size in bytes of each ring buffer,
+     *      it's rounded up to a power of two.
+     */
+    explicit AsyncHandler(Handler* sink = nullptr, Overflow policy = Overflow::Drop,
+        size_t capacity = 64 * 1024);
+
+    /**
+     * \brief Writes every pending record and stops the background thread.
+     */
+    ~AsyncHandler() noexcept;
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    AsyncHandler(const AsyncHandler&) = delete;
+    AsyncHandler& operator=(const AsyncHandler&) = delete;
+    ///@}
+
+    /**
+     * \brief Logging function which pushes the content to a ring buffer.
+     *
+     * This method is thread-safe.
+     */
+    ///@{
+    void debug(const Loc&, const Arg[], size_t) const override;
+    void info(const Loc&, const Arg[], size_t) const override;
+    void warn(const Loc&, const Arg[], size_t) const override;
+    void error(const Loc&, const Arg[], size_t) const override;
+    void fatal(const Loc&, const Arg[], size_t) const override;
+    ///@}
+
+    /**
+     * \brief Waits for every record pushed so far to be written.
+     *
+     * This method is thread-safe.
+     */
+    void flush() const;
+
+    /**
+     * \return The overflow policy.
+     */
+    Overflow overflow() const noexcept;
+
+    /**
+     * \return Number of records which were discarded, because of overflow.
+     */
+    size_t dropped() const noexcept;
+
+    /**
+     * \return Number of records which were written to the sink.
+     */
+    size_t written() const noexcept;
+
+    /**
+     * \return Number of ring buffers, which are reused after their thread exited.
+     */
+    size_t rings() const noexcept;
+
+
+private:
+    struct Impl;
+    const std::unique_ptr<Impl> d_; ///< Private implementation.
+};
+
 /**
  * \brief Library-level generic logger.
  *
@@ -121,6 +243,39 @@ public:
      */
     static void installContentHandler(Handler* handler);
 
+    /**
+     * \brief Sets the minimum level of logged messages.
+     *
+     * Messages below the threshold are discarded by the logging macros
+     * before their arguments are evaluated.
+     * The \ref Level::Fatal level is always enabled.
+     * The default threshold is \ref Level::Debug.
+     *
+     * \param[in] lvl Minimum enabled level.
+     *
+     * \see level()
+     * \see isEnabled(Level)
+     */
+    static void setLevel(Level lvl) noexcept;
+
+    /**
+     * \return The minimum enabled level.
+     *
+     * \see setLevel(Level)
+     */
+    static Level level() noexcept;
+
+    /**
+     * \param[in] lvl Level of a message.
+     * \return Whether messages of level \c lvl are enabled.
+     *
+     * \see setLevel(Level)
+     */
+    static bool isEnabled(Level lvl) noexcept
+    {
+        return lvl == Level::Fatal || lvl >= level_.load(std::memory_order_relaxed);
+    }
+
     /**
      * \brief Logs a content for level, using the installed \ref Handler.
      * In case no handler was installed, then the default one is used.
@@ -141,6 +296,7 @@ public:
 
 private:
     static std::unique_ptr<Handler> handler_; ///< The user defined log handler.
+    static std::atomic<Level> level_;         ///< Minimum enabled level.
 };
 
 } // namespace log
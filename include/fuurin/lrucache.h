@@ -11,11 +11,17 @@
 #ifndef FUURIN_LRUCACHE_H
 #define FUURIN_LRUCACHE_H
 
+#include <algorithm>
+#include <functional>
 #include <initializer_list>
-#include <list>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <optional>
-#include <unordered_map>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 
 namespace fuurin {
@@ -29,15 +35,310 @@ namespace fuurin {
  * The cache has a capacity parameter. When the size of the cache reaches the
  * capacity limit, then upon insertion of a new item, the least recently used
  * one will be removed.
+ *
+ * Every item is stored in a single node, which is linked both in the usage
+ * list and in a hash bucket. Nodes are allocated in chunks from an internal
+ * pool and they are recycled upon removal, so no allocation is performed
+ * once the cache has reached its working size.
+ *
+ * In case \c Hash declares an \c is_transparent type, then items can be
+ * looked up by any key type which is accepted by \c Hash and \c Equal,
+ * without constructing a temporary \c K.
  */
-template<typename K, typename V>
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<>>
 class LRUCache
 {
 public:
     ///< List item alias.
     using Item = std::pair<K, V>;
-    ///< List alias.
-    using List = std::list<Item>;
+
+
+private:
+    /**
+     * \brief Link of the usage list.
+     */
+    struct Link
+    {
+        Link* prev; ///< Previous (less recently used) node.
+        Link* next; ///< Next (more recently used) node.
+    };
+
+    /**
+     * \brief Storage of an item.
+     */
+    struct Node : Link
+    {
+        Node* chain; ///< Next node in the same hash bucket, or in the free list.
+        size_t hash; ///< Hash of the item key.
+
+        alignas(Item) unsigned char storage[sizeof(Item)]; ///< Item storage.
+
+        /// \return The stored item.
+        ///@{
+        Item& item() noexcept
+        {
+            return *std::launder(reinterpret_cast<Item*>(storage));
+        }
+
+        const Item& item() const noexcept
+        {
+            return *std::launder(reinterpret_cast<const Item*>(storage));
+        }
+        ///@}
+    };
+
+
+public:
+    /**
+     * \brief Doubly linked list of items, ordered by usage.
+     *
+     * The list can be walked and read, but it's modified only
+     * by the owning cache.
+     */
+    class List
+    {
+    public:
+        /**
+         * \brief Bidirectional iterator of the list.
+         */
+        template<bool Const>
+        class Iterator
+        {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = Item;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<Const, const Item&, Item&>;
+            using pointer = std::conditional_t<Const, const Item*, Item*>;
+
+            Iterator() noexcept
+                : link_{nullptr}
+            {
+            }
+
+            /// Converts a mutable iterator into a constant one.
+            template<bool C, typename = std::enable_if_t<Const && !C>>
+            Iterator(const Iterator<C>& it) noexcept
+                : link_{it.link_}
+            {
+            }
+
+            reference operator*() const noexcept
+            {
+                return static_cast<Node*>(link_)->item();
+            }
+
+            pointer operator->() const noexcept
+            {
+                return &**this;
+            }
+
+            Iterator& operator++() noexcept
+            {
+                link_ = link_->next;
+                return *this;
+            }
+
+            Iterator operator++(int) noexcept
+            {
+                auto ret = *this;
+                ++*this;
+                return ret;
+            }
+
+            Iterator& operator--() noexcept
+            {
+                link_ = link_->prev;
+                return *this;
+            }
+
+            Iterator operator--(int) noexcept
+            {
+                auto ret = *this;
+                --*this;
+                return ret;
+            }
+
+            template<bool C>
+            bool operator==(const Iterator<C>& rhs) const noexcept
+            {
+                return link_ == rhs.link_;
+            }
+
+            template<bool C>
+            bool operator!=(const Iterator<C>& rhs) const noexcept
+            {
+                return link_ != rhs.link_;
+            }
+
+
+        private:
+            friend class List;
+            friend class LRUCache;
+            template<bool>
+            friend class Iterator;
+
+            explicit Iterator(Link* l) noexcept
+                : link_{l}
+            {
+            }
+
+            Link* link_; ///< Current link.
+        };
+
+        ///< Mutable iterator.
+        using iterator = Iterator<false>;
+        ///< Constant iterator.
+        using const_iterator = Iterator<true>;
+
+
+        /**
+         * \return Iterators to the least recently used item
+         *      and past the most recently used one.
+         */
+        ///@{
+        iterator begin() noexcept
+        {
+            return iterator{head_.next};
+        }
+
+        iterator end() noexcept
+        {
+            return iterator{&head_};
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return const_iterator{head_.next};
+        }
+
+        const_iterator end() const noexcept
+        {
+            return const_iterator{const_cast<Link*>(&head_)};
+        }
+        ///@}
+
+        /**
+         * \return The least recently used item, list must not be empty.
+         */
+        ///@{
+        Item& front() noexcept
+        {
+            return *begin();
+        }
+
+        const Item& front() const noexcept
+        {
+            return *begin();
+        }
+        ///@}
+
+        /**
+         * \return The most recently used item, list must not be empty.
+         */
+        ///@{
+        Item& back() noexcept
+        {
+            return *--end();
+        }
+
+        const Item& back() const noexcept
+        {
+            return *--end();
+        }
+        ///@}
+
+        /**
+         * \return List size.
+         */
+        size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        /**
+         * \return Whether list size is zero.
+         */
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        /**
+         * \brief Comparison operator.
+         *
+         * \param[in] rhs Other list to compare.
+         *
+         * \return \c true in case the lists have the same items and the same ordering.
+         */
+        ///@{
+        bool operator==(const List& rhs) const
+        {
+            return size_ == rhs.size_ && std::equal(begin(), end(), rhs.begin());
+        }
+
+        bool operator!=(const List& rhs) const
+        {
+            return !(*this == rhs);
+        }
+        ///@}
+
+
+    private:
+        friend class LRUCache;
+
+        List() noexcept
+        {
+            reset();
+        }
+
+        List(const List&) = delete;
+        List& operator=(const List&) = delete;
+
+        /// Makes this list empty, without touching nodes.
+        void reset() noexcept
+        {
+            head_.prev = &head_;
+            head_.next = &head_;
+            size_ = 0;
+        }
+
+        /// Takes all nodes of another list.
+        void steal(List& other) noexcept
+        {
+            if (other.empty())
+                return;
+
+            head_.next = other.head_.next;
+            head_.prev = other.head_.prev;
+            head_.next->prev = &head_;
+            head_.prev->next = &head_;
+            size_ = other.size_;
+
+            other.reset();
+        }
+
+        /// Links a node as the most recently used.
+        void pushBack(Link* l) noexcept
+        {
+            l->prev = head_.prev;
+            l->next = &head_;
+            head_.prev->next = l;
+            head_.prev = l;
+            ++size_;
+        }
+
+        /// Unlinks a node.
+        void unlink(Link* l) noexcept
+        {
+            l->prev->next = l->next;
+            l->next->prev = l->prev;
+            --size_;
+        }
+
+        Link head_;   ///< Sentinel node.
+        size_t size_; ///< Number of linked nodes.
+    };
 
 
 public:
@@ -79,10 +380,59 @@ public:
     }
 
 
+    /**
+     * \brief Copy constructor.
+     *
+     * Items are copied preserving their usage order.
+     *
+     * \param[in] other Cache to copy.
+     */
+    LRUCache(const LRUCache& other)
+        : capacity_{other.capacity_}
+        , hash_{other.hash_}
+        , equal_{other.equal_}
+    {
+        for (const auto& v : other.list_)
+            put(v.first, v.second);
+    }
+
+
+    /**
+     * \brief Move constructor.
+     *
+     * \param[in] other Cache to move, it is left empty.
+     */
+    LRUCache(LRUCache&& other) noexcept
+        : capacity_{other.capacity_}
+        , hash_{std::move(other.hash_)}
+        , equal_{std::move(other.equal_)}
+        , buckets_{std::move(other.buckets_)}
+        , chunks_{std::move(other.chunks_)}
+        , free_{other.free_}
+    {
+        list_.steal(other.list_);
+        other.buckets_.clear();
+        other.free_ = nullptr;
+    }
+
+
+    /**
+     * Disable assignment.
+     */
+    ///@{
+    LRUCache& operator=(const LRUCache&) = delete;
+    LRUCache& operator=(LRUCache&&) = delete;
+    ///@}
+
+
     /**
      * \brief Destructor.
      */
-    virtual ~LRUCache() noexcept = default;
+    virtual ~LRUCache() noexcept
+    {
+        for (auto& v : list_)
+            v.~Item();
+    }
 
 
     /**
@@ -114,11 +464,20 @@ public:
 
     /**
      * \brief Clears this cache.
+     *
+     * Nodes are kept in the pool, to be reused.
      */
     void clear()
     {
-        list_.clear();
-        map_.clear();
+        for (auto it = list_.begin(); it != list_.end();) {
+            const auto n = static_cast<Node*>((it++).link_);
+            n->item().~Item();
+            n->chain = free_;
+            free_ = n;
+        }
+
+        list_.reset();
+        std::fill(buckets_.begin(), buckets_.end(), nullptr);
     }
 
 
@@ -128,35 +487,80 @@ public:
      * The passed item is set as the most recently used.
      *
      * In case the same key is already present in cache,
-     * then its usage is updated and moved to the end
+     * then its value is replaced and moved to the end
      * of the list.
      *
      * In case the key needs to be added and the capacity
      * was already reached, then the least recently used
      * item will be removed.
      *
+     * Both key and value are either copied or moved,
+     * according to the passed arguments.
+     *
      * \param[in] k Item's key.
      * \param[in] v Item's value.
      *
      * \return An iterator to the new inserted item,
      *         that is the last element of the \ref list().
+     *
+     * \see emplace(KK&&, Args&&...)
      */
-    typename List::iterator put(const K& k, const V& v)
+    template<typename KK, typename VV>
+    typename List::iterator put(KK&& k, VV&& v)
     {
-        if (auto it = map_.find(k); it == map_.end()) {
-            if (capacity_ > 0 && map_.size() >= capacity_) {
-                const auto& el = list_.front();
-                map_.erase(el.first);
-                list_.pop_front();
-            }
+        return emplace(std::forward<KK>(k), std::forward<VV>(v));
+    }
+
+
+    /**
+     * \brief Puts or updates an item into the cache, constructing its value in place.
+     *
+     * The same as \ref put(KK&&, VV&&), but the value is constructed
+     * from the passed arguments. When the key is already present,
+     * then the old value is destroyed before constructing the new one.
+     *
+     * \param[in] k Item's key.
+     * \param[in] args Arguments to construct the item's value.
+     *
+     * \return An iterator to the new inserted item.
+     */
+    template<typename KK, typename... Args>
+    typename List::iterator emplace(KK&& k, Args&&... args)
+    {
+        const size_t h = hash_(k);
+
+        if (Node* n = lookup(k, h)) {
+            V v(std::forward<Args>(args)...);
+            n->item().second.~V();
+            new (&n->item().second) V(std::move(v));
+
+            list_.unlink(n);
+            list_.pushBack(n);
+            return typename List::iterator{n};
+        }
+
+        Node* n;
+        if (capacity_ > 0 && list_.size() >= capacity_) {
+            n = static_cast<Node*>(list_.head_.next);
+            unlinkNode(n);
+            n->item().~Item();
         } else {
-            list_.erase(it->second);
+            n = allocNode();
+        }
+
+        try {
+            new (n->storage) Item(std::piecewise_construct,
+                std::forward_as_tuple(std::forward<KK>(k)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        } catch (...) {
+            n->chain = free_;
+            free_ = n;
+            throw;
         }
 
-        list_.emplace_back(k, v);
-        const auto it = --list_.end();
-        map_[k] = it;
-        return it;
+        n->hash = h;
+        linkNode(n);
+        return typename List::iterator{n};
     }
 
 
@@ -164,27 +568,24 @@ public:
      * \brief Gets an item from the cache.
      *
      * If the passed key is contained in the cache,
-     * then it is removed and returned.
+     * then it is removed and returned, by moving it.
      *
      * \param[in] k Item's key.
      *
      * \return Optionally the removed item.
      */
+    ///@{
     std::optional<Item> get(const K& k)
     {
-        const auto it = map_.find(k);
-
-        if (it == map_.end())
-            return {};
-
-        const auto vit = it->second;
-        const Item ret{*vit};
-
-        map_.erase(k);
-        list_.erase(vit);
+        return getImpl(k);
+    }
 
-        return {ret};
+    template<typename Q, typename H = Hash, typename = typename H::is_transparent>
+    std::optional<Item> get(const Q& k)
+    {
+        return getImpl(k);
     }
+    ///@}
 
 
     /**
@@ -199,20 +600,28 @@ public:
     ///@{
     typename List::iterator find(const K& k)
     {
-        const auto it = map_.find(k);
-        if (it == map_.end())
-            return list_.end();
-
-        return it->second;
+        Node* n = lookup(k, hash_(k));
+        return n != nullptr ? typename List::iterator{n} : list_.end();
     }
 
     typename List::const_iterator find(const K& k) const
     {
-        const auto it = map_.find(k);
-        if (it == map_.end())
-            return list_.end();
+        Node* n = lookup(k, hash_(k));
+        return n != nullptr ? typename List::const_iterator{n} : list_.end();
+    }
+
+    template<typename Q, typename H = Hash, typename = typename H::is_transparent>
+    typename List::iterator find(const Q& k)
+    {
+        Node* n = lookup(k, hash_(k));
+        return n != nullptr ? typename List::iterator{n} : list_.end();
+    }
 
-        return it->second;
+    template<typename Q, typename H = Hash, typename = typename H::is_transparent>
+    typename List::const_iterator find(const Q& k) const
+    {
+        Node* n = lookup(k, hash_(k));
+        return n != nullptr ? typename List::const_iterator{n} : list_.end();
     }
     ///@}
 
@@ -241,12 +650,12 @@ public:
      * \return \c true in case the cache list has the same items and the same ordering.
      */
     ///@{
-    bool operator==(const LRUCache<K, V>& rhs) const
+    bool operator==(const LRUCache& rhs) const
     {
         return list_ == rhs.list_;
     }
 
-    bool operator!=(const LRUCache<K, V>& rhs) const
+    bool operator!=(const LRUCache& rhs) const
     {
         return !(*this == rhs);
     }
@@ -254,9 +663,138 @@ public:
 
 
 private:
-    const size_t capacity_;                              ///< Cache capacity, i.e. max size.
-    List list_;                                          ///< List of cache items.
-    std::unordered_map<K, typename List::iterator> map_; ///< Items position in cache list.
+    ///< Maximum number of nodes allocated at once.
+    static constexpr size_t ChunkMax = 4096;
+
+
+    /**
+     * \brief Looks up a node.
+     *
+     * \param[in] k Key to look up.
+     * \param[in] h Hash of the key.
+     *
+     * \return The node, or \c nullptr when not found.
+     */
+    template<typename Q>
+    Node* lookup(const Q& k, size_t h) const
+    {
+        if (buckets_.empty())
+            return nullptr;
+
+        for (Node* n = buckets_[h & (buckets_.size() - 1)]; n != nullptr; n = n->chain) {
+            if (n->hash == h && equal_(n->item().first, k))
+                return n;
+        }
+
+        return nullptr;
+    }
+
+
+    /**
+     * \brief Removes and returns an item.
+     */
+    template<typename Q>
+    std::optional<Item> getImpl(const Q& k)
+    {
+        Node* n = lookup(k, hash_(k));
+
+        if (n == nullptr)
+            return {};
+
+        std::optional<Item> ret{std::move(n->item())};
+
+        unlinkNode(n);
+        n->item().~Item();
+        n->chain = free_;
+        free_ = n;
+
+        return ret;
+    }
+
+
+    /**
+     * \brief Takes a node from the pool, allocating a new chunk when empty.
+     */
+    Node* allocNode()
+    {
+        if (free_ == nullptr) {
+            size_t sz = std::clamp<size_t>(list_.size(), 8, ChunkMax);
+            if (capacity_ > 0)
+                sz = std::min(sz, capacity_ - list_.size());
+
+            chunks_.emplace_back(new Node[sz]);
+
+            Node* chunk = chunks_.back().get();
+            for (size_t i = 0; i < sz; ++i) {
+                chunk[i].chain = free_;
+                free_ = &chunk[i];
+            }
+        }
+
+        Node* n = free_;
+        free_ = n->chain;
+        return n;
+    }
+
+
+    /**
+     * \brief Links a node as most recently used and into its hash bucket.
+     */
+    void linkNode(Node* n)
+    {
+        if (list_.size() + 1 > buckets_.size())
+            rehash(std::max<size_t>(8, buckets_.size() * 2));
+
+        auto& b = buckets_[n->hash & (buckets_.size() - 1)];
+        n->chain = b;
+        b = n;
+
+        list_.pushBack(n);
+    }
+
+
+    /**
+     * \brief Unlinks a node from both the list and its hash bucket.
+     */
+    void unlinkNode(Node* n) noexcept
+    {
+        Node** p = &buckets_[n->hash & (buckets_.size() - 1)];
+        while (*p != n)
+            p = &(*p)->chain;
+        *p = n->chain;
+
+        list_.unlink(n);
+    }
+
+
+    /**
+     * \brief Redistributes nodes into a new number of buckets.
+     *
+     * \param[in] sz Number of buckets, a power of two.
+     */
+    void rehash(size_t sz)
+    {
+        std::vector<Node*> b(sz, nullptr);
+
+        for (auto it = list_.begin(); it != list_.end(); ++it) {
+            const auto n = static_cast<Node*>(it.link_);
+            auto& bb = b[n->hash & (sz - 1)];
+            n->chain = bb;
+            bb = n;
+        }
+
+        buckets_.swap(b);
+    }
+
+
+private:
+    const size_t capacity_;                      ///< Cache capacity, i.e. max size.
+    Hash hash_;                                  ///< Hash function.
+    Equal equal_;                                ///< Key comparison function.
+    List list_;                                  ///< List of cache items.
+    std::vector<Node*> buckets_;                 ///< Hash buckets, size is a power of two.
+    std::vector<std::unique_ptr<Node[]>> chunks_; ///< Pool of nodes.
+    Node* free_ = nullptr;                       ///< List of free nodes.
 };
 
 } // namespace fuurin
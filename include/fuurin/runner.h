@@ -25,10 +25,14 @@
 #include <string>
 #include <string_view>
 #include <atomic>
+#include <cstdint>
+#include <tuple>
+#include <optional>
 
 
 namespace fuurin {
 class Session;
+struct SessionState;
 
 namespace zmq {
 class Context;
@@ -121,6 +125,135 @@ public:
     const std::vector<std::string>& endpointSnapshot() const;
     ///@}
 
+    /**
+     * \brief Sets high water marks of data sockets.
+     *
+     * Every socket to exchange data with broker(s) or worker(s)
+     * is limited to the passed number of queued messages.
+     * When a limit is reached, messages are either dropped or
+     * refused, depending on the socket type.
+     *
+     * By default no limit is set.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] snd Limit of outbound messages, 0 means no limit.
+     * \param[in] rcv Limit of inbound messages, 0 means no limit.
+     *
+     * \see highWaterMark()
+     * \see zmq::Socket::setHighWaterMark(int, int)
+     */
+    void setHighWaterMark(int snd, int rcv);
+
+    /**
+     * \return A tuple with outbound and inbound high water marks.
+     *
+     * \see setHighWaterMark(int, int)
+     */
+    std::tuple<int, int> highWaterMark() const;
+
+    /**
+     * \brief Sets kernel buffer sizes of data sockets.
+     *
+     * By default the OS buffer sizes are used.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] snd Transmit buffer size in bytes, -1 means OS default.
+     * \param[in] rcv Receive buffer size in bytes, -1 means OS default.
+     *
+     * \see bufferSize()
+     * \see zmq::Socket::setBufferSize(int, int)
+     */
+    void setBufferSize(int snd, int rcv);
+
+    /**
+     * \return A tuple with transmit and receive buffer sizes.
+     *
+     * \see setBufferSize(int, int)
+     */
+    std::tuple<int, int> bufferSize() const;
+
+    /**
+     * \brief Sets the maximum number of messages received per ready data socket.
+     *
+     * Whenever a socket to exchange data with broker(s) or worker(s)
+     * is ready, the asynchronous task receives up to the passed
+     * number of messages without blocking, before polling again.
+     * So under high load, the cost of polling is shared by a batch of
+     * messages, while every ready socket is served in turn and timers
+     * and operations are still handled after each batch.
+     *
+     * By default up to 32 messages are received per ready socket.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] n Maximum number of messages, values lower than 1 mean 1, that is no batching.
+     *
+     * \see drainBatch()
+     */
+    void setDrainBatch(int n);
+
+    /**
+     * \return The maximum number of messages received per ready data socket.
+     *
+     * \see setDrainBatch(int)
+     */
+    int drainBatch() const;
+
+    /**
+     * \brief Sets the duration of busy polling.
+     *
+     * Both the asynchronous task and \ref waitForEvent() poll
+     * without blocking, for up to the passed duration, before
+     * falling back to a blocking wait. So latency is traded for CPU:
+     * a ready socket is detected without being woken up by the kernel,
+     * while a thread keeps a CPU busy for the whole spin duration,
+     * every time it's idle.
+     *
+     * By default no busy polling is performed.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] spin Duration of busy polling, zero means no busy polling.
+     *
+     * \see busyPoll()
+     * \see zmq::PollerWaiter::busyWait(std::chrono::microseconds)
+     */
+    void setBusyPoll(std::chrono::microseconds spin);
+
+    /**
+     * \return The duration of busy polling.
+     *
+     * \see setBusyPoll(std::chrono::microseconds)
+     */
+    std::chrono::microseconds busyPoll() const;
+
+    /**
+     * \brief Sets the CPUs the asynchronous task is allowed to run on.
+     *
+     * Pinning the asynchronous task avoids its migration between CPUs,
+     * which is mostly useful together with \ref setBusyPoll().
+     * In case the affinity can't be set, e.g. a CPU doesn't exist,
+     * then a warning is logged and the task runs on any CPU.
+     *
+     * By default the task runs on any CPU.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] cpus List of CPU indexes, empty for any CPU.
+     *
+     * \see cpuAffinity()
+     */
+    void setCpuAffinity(const std::vector<int>& cpus);
+
+    /**
+     * \return The CPUs the asynchronous task is allowed to run on, empty for any CPU.
+     *
+     * \see setCpuAffinity(const std::vector<int>&)
+     */
+    const std::vector<int>& cpuAffinity() const;
+
     /**
      * \brief Starts the background thread of the main task.
      *
@@ -163,6 +296,13 @@ public:
      */
     bool isRunning() const noexcept;
 
+    /**
+     * \return Number of operations sent and not yet received by the asynchronous task.
+     *
+     * This method is thread-safe.
+     */
+    uint64_t pendingOperations() const noexcept;
+
 
 protected:
     /**
@@ -202,6 +342,21 @@ protected:
      */
     virtual std::unique_ptr<Session> createSession() const;
 
+    /**
+     * \brief Takes the payload of a conflated event.
+     *
+     * This method shall be overridden by subclasses which
+     * keep the payload of events notified by
+     * \ref Session::sendConflatedEvent().
+     *
+     * \param[in] token Token of the notifying session.
+     * \param[in] name Name the event was conflated by.
+     *
+     * \return The payload of a \ref Event::Type::Delivery event,
+     *      if any is still pending for the passed token.
+     */
+    virtual std::optional<zmq::Part> takeConflatedEvent(SessionEnv::token_t token, std::string_view name) const;
+
     /**
      * \brief Wrapper to initialize any specific session.
      *
@@ -211,7 +366,7 @@ protected:
     std::unique_ptr<Session> makeSession(Args&&... args) const
     {
         return std::make_unique<S>(name_, uuid_, token_,
-            zctx_.get(), zfins_.get(), zopr_.get(), zevs_.get(),
+            zctx_.get(), state_.get(), zopr_.get(), zevs_.get(),
             std::forward<Args>(args)...);
     }
 
@@ -273,6 +428,13 @@ protected:
      */
     int eventFD() const;
 
+    /**
+     * \return State shared with the asynchronous task.
+     *
+     * This method is thread-safe.
+     */
+    SessionState* sessionState() const noexcept;
+
 
 private:
     friend class TestRunner;
@@ -301,8 +463,7 @@ private:
     const std::unique_ptr<zmq::Socket> zopr_;  ///< Inter-thread receiving socket.
     const std::unique_ptr<zmq::Socket> zevs_;  ///< Inter-thread events notifications.
     const std::unique_ptr<zmq::Socket> zevr_;  ///< Inter-thread events reception.
-    const std::unique_ptr<zmq::Socket> zfins_; ///< Inter-thread send completion message.
-    const std::unique_ptr<zmq::Socket> zfinr_; ///< Inter-thread recv completion message.
+    const std::unique_ptr<SessionState> state_; ///< Inter-thread shared state.
 
     /**
      * FIXME: to be removed when ZMQ_FD option can be accessed
@@ -311,12 +472,20 @@ private:
      */
     const std::unique_ptr<zmq::Poller<zmq::Socket>> zevpoll_;
 
-    mutable std::atomic<bool> running_; ///< Whether the task is running.
-    SessionEnv::token_t token_;         ///< Current execution token for the task.
+    SessionEnv::token_t token_; ///< Current execution token for the task.
 
     std::vector<std::string> endpDelivery_; ///< List of endpoints.
     std::vector<std::string> endpDispatch_; ///< List of endpoints.
     std::vector<std::string> endpSnapshot_; ///< List of endpoints.
+
+    int hwmSend_; ///< High water mark of outbound messages.
+    int hwmRecv_; ///< High water mark of inbound messages.
+    int bufSend_; ///< Size of transmit buffers.
+    int bufRecv_; ///< Size of receive buffers.
+    int drain_;   ///< Maximum number of messages received per ready socket.
+
+    std::chrono::microseconds busyPoll_; ///< Duration of busy polling.
+    std::vector<int> cpus_;              ///< CPU affinity of the asynchronous task.
 };
 
 } // namespace fuurin
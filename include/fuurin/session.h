@@ -16,8 +16,10 @@
 #include "fuurin/event.h"
 #include "fuurin/uuid.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
+#include <string_view>
 
 
 namespace fuurin {
@@ -30,6 +32,8 @@ class Pollable;
 class PollerWaiter;
 } // namespace zmq
 
+struct SessionState;
+
 
 /**
  * \brief Session for the asynchronous task.
@@ -56,12 +60,12 @@ public:
      * \param[in] id Session identifier.
      * \param[in] token Session token, it's constant as long as this session is alive.
      * \param[in] zctx ZMQ context.
-     * \param[in] zfin ZMQ socket to send completion event.
+     * \param[in] state State shared with the runner, to notify completion.
      * \param[in] zoper ZMQ socket to receive operation commands from main task.
      * \param[in] zevent ZMQ socket to send events to main task.
      */
     explicit Session(const std::string& name, Uuid id, SessionEnv::token_t token,
-        zmq::Context* zctx, zmq::Socket* zfin, zmq::Socket* zoper,
+        zmq::Context* zctx, SessionState* state, zmq::Socket* zoper,
         zmq::Socket* zevent);
 
     /**
@@ -89,9 +93,22 @@ public:
      * \see operationReady(Operation*)
      * \see socketReady(zmq::Pollable*)
      * \see recvOperation()
+     * \see setBusyPoll(std::chrono::microseconds)
      */
     void run();
 
+    /**
+     * \brief Sets the duration of busy polling, before every blocking wait of \ref run().
+     *
+     * This method shall be called before \ref run().
+     *
+     * \param[in] spin Duration of busy polling, zero means no busy polling.
+     *
+     * \see Runner::setBusyPoll(std::chrono::microseconds)
+     * \see zmq::PollerWaiter::busyWait(std::chrono::microseconds)
+     */
+    void setBusyPoll(std::chrono::microseconds spin) noexcept;
+
 
 protected:
     /**
@@ -130,7 +147,13 @@ protected:
      * added by \ref createPoller() (other than the inter-thread \ref zopr_),
      * then this nofitication is never issued.
      *
+     * Every ready item is notified in turn, before waiting again, so
+     * a socket may be drained of a bounded batch of messages, without
+     * starving other sockets, timers and operations.
+     *
      * \param[in] pble Ready pollable item.
+     *
+     * \see Runner::setDrainBatch(int)
      */
     virtual void socketReady(zmq::Pollable* pble);
 
@@ -145,6 +168,20 @@ protected:
      */
     void sendEvent(Event::Type event, zmq::Part&& payload);
 
+    /**
+     * \brief Notifies the main thread of a conflated event.
+     *
+     * This method shall be called from the asynchronous task thread.
+     * Only the name is sent over the inter-thread radio socket,
+     * while the payload is kept aside, so that it can be replaced
+     * until the main thread reads it.
+     *
+     * \param[in] name Name the event is conflated by.
+     *
+     * \see Runner::takeConflatedEvent()
+     */
+    void sendConflatedEvent(std::string_view name);
+
 
 protected:
     /**
@@ -183,9 +220,12 @@ protected:
     const Uuid uuid_;                 ///< Identifier.
     const SessionEnv::token_t token_; ///< Session token.
     zmq::Context* const zctx_;        ///< \see Runner::zctx_.
-    zmq::Socket* const zfins_;        ///< \see Runner::zfins_.
+    SessionState* const state_;       ///< \see Runner::state_.
     zmq::Socket* const zopr_;         ///< \see Runner::zopr_.
     zmq::Socket* const zevs_;         ///< \see Runner::zevs_.
+
+private:
+    std::chrono::microseconds busyPoll_; ///< Duration of busy polling.
 };
 
 } // namespace fuurin
@@ -16,6 +16,7 @@
 #include "fuurin/brokerconfig.h"
 #include "fuurin/topic.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -26,6 +27,13 @@ namespace zmq {
 class Timer;
 } // namespace zmq
 
+class TopicLog;
+struct BrokerMetrics;
+
+namespace err {
+class Error;
+} // namespace err
+
 
 /**
  * \brief Broker specific asynchronous task session.
@@ -39,10 +47,17 @@ public:
      *
      * The socket used to receive storage is created and bound.
      *
+     * \param[in] metrics Metrics to record, they must outlive this session.
+     * \param[in] storTopics Capacity of topic names in storage, zero means infinite.
+     * \param[in] storVersions Capacity of workers' topics per name in storage, zero means infinite.
+     * \param[in] storWorkers Capacity of workers' sequence numbers in storage, zero means infinite.
+     *
      * \see Session::Session(...)
+     * \see Broker::setStorageCapacity(size_t, size_t, size_t)
      */
     explicit BrokerSession(const std::string& name, Uuid id, SessionEnv::token_t token,
-        zmq::Context* zctx, zmq::Socket* zfin, zmq::Socket* zoper, zmq::Socket* zevents);
+        zmq::Context* zctx, SessionState* state, zmq::Socket* zoper, zmq::Socket* zevents,
+        BrokerMetrics* metrics, size_t storTopics, size_t storVersions, size_t storWorkers);
 
     /**
      * \brief Destructor.
@@ -83,11 +98,88 @@ protected:
      */
     void closeSockets();
 
+    /**
+     * \brief Loads the persistent storage, if enabled.
+     *
+     * Loaded topics are stored as they were received by workers,
+     * then the storage log is opened and its flush and compaction
+     * are started. In case of error, persistence is disabled
+     * until the next start.
+     *
+     * \see storeTopic(const Topic&)
+     */
+    void openStorage();
+
+    /**
+     * \brief Compacts and closes the persistent storage, if enabled.
+     *
+     * This is the only storage operation which waits for file I/O.
+     */
+    void closeStorage();
+
+    /**
+     * \brief Starts compacting the persistent storage.
+     *
+     * Storage is compacted only when topics were stored since
+     * the latest compaction, and no compaction is in progress.
+     *
+     * \see TopicLog::compact(const TopicLog::VisitFunc&)
+     */
+    void compactStorage();
+
+    /**
+     * \brief Flushes the persistent storage log.
+     *
+     * It also collects the result of a completed compaction.
+     */
+    void flushStorage();
+
+    /**
+     * \brief Appends a topic to the persistent storage, if enabled.
+     *
+     * Only topics of type \ref Topic::State are persisted.
+     *
+     * \param[in] t Topic to persist.
+     */
+    void persistTopic(const Topic& t);
+
+    /**
+     * \brief Handles an error of the persistent storage.
+     *
+     * The error is logged and counted, while the broker keeps serving.
+     *
+     * \param[in] e Storage error.
+     */
+    void storageFailed(const err::Error& e);
+
     /**
      * \brief Sends a keepalive.
+     *
+     * Keepalive is skipped when topics were dispatched since the
+     * latest one, as long as no worker announced itself meanwhile
+     * and no worker which filters topics by name was ever seen.
      */
     void sendHugz();
 
+    /**
+     * \brief Sends the echo of a worker keepalive.
+     *
+     * Like any keepalive, the echo carries the status of this broker.
+     *
+     * \param[in] worker Uuid of worker.
+     * \param[in] nonce Nonce of worker keepalive.
+     * \param[in] stamp Timestamp of worker keepalive.
+     */
+    void sendHugz(const Uuid::Bytes& worker, uint64_t nonce, uint64_t stamp);
+
+    /**
+     * \brief Updates the status which is sent along with keepalives.
+     *
+     * Workers and peers which were not seen for \ref WorkerExpiry keepalive
+     * intervals are no more counted as connected.
+     */
+    void updateStatus();
+
     /**
      * \brief Collects a message which was published by a worker.
      *
@@ -95,6 +187,17 @@ protected:
      */
     void collectWorkerMessage(zmq::Part&& payload);
 
+    /**
+     * \brief Stores and dispatches a topic published by a worker or forwarded by a peer.
+     *
+     * Topics received from workers are forwarded to peers,
+     * while topics forwarded by peers are not.
+     *
+     * \param[in] payload Message payload.
+     * \param[in] fromPeer Whether the topic was forwarded by a peer.
+     */
+    void collectTopic(const zmq::Part& payload, bool fromPeer);
+
     /**
      * \brief Stores a topic into local storage.
      *
@@ -108,6 +211,50 @@ protected:
      */
     bool storeTopic(const Topic& t);
 
+    /**
+     * \brief Forwards a topic to peer brokers.
+     *
+     * The topic is tagged with this broker's uuid, i.e. its origin,
+     * and sent to the peers, so that they will store it and deliver it
+     * to their workers, without forwarding it any further.
+     *
+     * \param[in] t Topic to forward.
+     *
+     * \see storeTopic(const Topic&)
+     */
+    void forwardTopic(const Topic& t);
+
+    /**
+     * \brief Requests a snapshot to every peer broker.
+     */
+    void requestPeerSnapshot();
+
+    /**
+     * \brief Sends a keepalive to peer brokers.
+     */
+    void sendPeerHugz();
+
+    /**
+     * \brief Collects a keepalive sent by a peer broker.
+     *
+     * A snapshot is requested again whenever a peer is seen
+     * for the first time, or after it has expired, since topics
+     * forwarded in the meanwhile might have been lost.
+     *
+     * \param[in] peer Peer broker uuid.
+     */
+    void collectPeerHugz(const Uuid& peer);
+
+    /**
+     * \brief Collects a snapshot reply sent by a peer broker.
+     *
+     * Received elements are stored, if they are newer
+     * than the already stored ones.
+     *
+     * \param[in] payload Message payload.
+     */
+    void collectPeerSnapshot(zmq::Part&& payload);
+
     /**
      * \brief Receives a synchronous command requested by a worker.
      *
@@ -130,6 +277,11 @@ protected:
     const std::unique_ptr<zmq::Socket> zdelivery_; ///< ZMQ socket receive data.
     const std::unique_ptr<zmq::Socket> zdispatch_; ///< ZMQ socket send data.
     const std::unique_ptr<zmq::Timer> zhugz_;      ///< ZMQ timer to send keepalives.
+    const std::unique_ptr<zmq::Socket> zpeerdisp_; ///< ZMQ socket forward data to peers.
+    const std::unique_ptr<zmq::Socket> zpeersnap_; ///< ZMQ socket receive snapshots from peers.
+    const std::unique_ptr<zmq::Timer> zcompact_;   ///< ZMQ timer to compact storage.
+    const std::unique_ptr<zmq::Timer> zflush_;     ///< ZMQ timer to flush storage.
+    BrokerMetrics* const metrics_;                 ///< Metrics of this session.
 
     BrokerConfig conf_; ///< Session configuration.
 
@@ -138,6 +290,20 @@ protected:
 
     LRUCache<Topic::Name, LRUCache<WorkerUuid, Topic>> storTopic_; ///< Topic storage.
     LRUCache<WorkerUuid, Topic::SeqN> storWorker_;                 ///< Worker storage.
+    std::unique_ptr<TopicLog> storLog_;                            ///< Persistent storage.
+    const size_t storVersions_;                                    ///< Capacity of workers' topics per name.
+
+    bool hugzData_;     ///< Whether topics were dispatched since the latest keepalive.
+    bool hugzAnnounce_; ///< Whether any worker announced since the latest keepalive.
+    bool hugzFiltered_; ///< Whether any worker filters topics by name.
+
+    /// Number of keepalive intervals after which a silent worker is disconnected.
+    static constexpr int WorkerExpiry = 3;
+
+    LRUCache<WorkerUuid, std::chrono::steady_clock::time_point> hugzWorker_; ///< Connected workers.
+    LRUCache<Uuid, std::chrono::steady_clock::time_point> hugzPeer_;         ///< Connected peer brokers.
+    uint64_t hugzDispatched_; ///< Topics dispatched until the latest keepalive.
+    uint64_t hugzLoad_;       ///< Topics per second.
 };
 } // namespace fuurin
 
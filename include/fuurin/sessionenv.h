@@ -25,14 +25,40 @@ struct SessionEnv
     ///< Type of session execution token.
     using token_t = uint8_t;
 
-    ///< Broker publish group for keepalives.
+    /**
+     * \brief Broker publish group for keepalives.
+     *
+     * Payload is made up of the broker status, that is the number
+     * of connected workers, topics per second and stored topic names,
+     * followed by the uuid, nonce and timestamp of the echoed worker
+     * keepalive, or a null uuid for periodic keepalives.
+     */
     static constexpr std::string_view BrokerHugz{"HUGZ"};
-    ///< Worker publish group for announcemets.
+    /**
+     * \brief Worker publish group for announcemets.
+     *
+     * Payload is made up of flags, worker uuid, nonce and timestamp,
+     * which are echoed back by the broker.
+     */
     static constexpr std::string_view WorkerHugz{"HUGZ"};
     ///< Broker publish group for delivery.
     static constexpr std::string_view BrokerUpdt{"UPDT"};
     ///< Worker publish group for dispatch.
     static constexpr std::string_view WorkerUpdt{"UPDT"};
+    /**
+     * \brief Broker publish group for topics forwarded to peers.
+     *
+     * Payload is a topic, which broker is the one that received
+     * it from the worker, i.e. the origin broker.
+     */
+    static constexpr std::string_view BrokerPeerUpdt{"PEER"};
+    ///< Broker publish group for keepalives to peers, payload is the broker uuid.
+    static constexpr std::string_view BrokerPeerHugz{"PHGZ"};
+
+    ///< Worker keepalive flag, it's an announcement instead of a reply.
+    static constexpr uint8_t WorkerHugzAnnounce{0x01};
+    ///< Worker keepalive flag, worker filters topics by name.
+    static constexpr uint8_t WorkerHugzFiltered{0x02};
 
     ///< Broker sync request.
     static constexpr std::string_view BrokerSyncReqst{"SYNC"};
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef FUURIN_SESSIONSTATE_H
+#define FUURIN_SESSIONSTATE_H
+
+#include "fuurin/sessionenv.h"
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace fuurin {
+
+/**
+ * \brief State shared between a \ref Runner and its running \ref Session.
+ *
+ * Every field is written by a single thread only, and it's placed
+ * on its own cache line, so that reads from the main thread
+ * don't contend with writes from the asynchronous task.
+ *
+ * A session is running as long as the current \ref token differs
+ * from the \ref finished one.
+ */
+struct SessionState
+{
+    ///< Size of a cache line.
+    static constexpr size_t CacheLine = 64;
+
+    ///< Token of the latest started session, written by the runner.
+    alignas(CacheLine) std::atomic<SessionEnv::token_t> token{0};
+    ///< Token of the latest completed session, written by the session.
+    alignas(CacheLine) std::atomic<SessionEnv::token_t> finished{0};
+    ///< Latest sequence number, written by the session.
+    alignas(CacheLine) std::atomic<uint64_t> seqNum{0};
+    ///< Number of operations sent, written by the runner.
+    alignas(CacheLine) std::atomic<uint64_t> opsSent{0};
+    ///< Number of operations received, of any token, written by the session.
+    alignas(CacheLine) std::atomic<uint64_t> opsReceived{0};
+};
+
+} // namespace fuurin
+
+#endif // FUURIN_SESSIONSTATE_H
@@ -16,11 +16,23 @@
 #include "fuurin/workerconfig.h"
 #include "fuurin/topic.h"
 
+#include <array>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+#include <utility>
+
 
 namespace fuurin {
 
 class ConnMachine;
+class DeliveryConflater;
 class SyncMachine;
+class TopicCache;
+class TopicView;
+struct WorkerMetrics;
 
 
 /**
@@ -35,11 +47,18 @@ public:
      *
      * The sockets used for communication are created.
      *
+     * \param[in] metrics Metrics to record, they must outlive this session.
+     * \param[in] cache Cache of the latest state topics, if not null, it must outlive this session.
+     * \param[in] conflater Pending conflated deliveries, it must outlive this session.
+     * \param[in] handler Handler of deliveries, if any, see \ref Worker::setDeliveryHandler.
+     * \param[in] handlerBudget Expected maximum duration of the handler.
+     *
      * \see Session::Session(...)
      */
     explicit WorkerSession(const std::string& name, Uuid id, SessionEnv::token_t token,
-        zmq::Context* zctx, zmq::Socket* zfin, zmq::Socket* zoper, zmq::Socket* zevent,
-        zmq::Socket* zseqs);
+        zmq::Context* zctx, SessionState* state, zmq::Socket* zoper, zmq::Socket* zevent,
+        WorkerMetrics* metrics, TopicCache* cache, DeliveryConflater* conflater,
+        std::function<void(const TopicView&)> handler, std::chrono::nanoseconds handlerBudget);
 
     /**
      * \brief Destructor.
@@ -65,30 +84,79 @@ protected:
 
 protected:
     /**
-     * \brief Closes/Opens the sockets connection.
+     * \brief Creates the poller for every socket and timer.
+     *
+     * \param[in] snap Indexes of snapshot sockets.
+     * \param[in] path Indexes of paths.
+     *
+     * \return A new poller.
+     */
+    template<size_t... S, size_t... P>
+    zmq::PollerWaiter* createPoller(std::index_sequence<S...> snap, std::index_sequence<P...> path);
+
+    /**
+     * \brief Returns the endpoints used by a socket, out of a list.
+     *
+     * Each socket gets one endpoint, while the last socket
+     * gets every remaining one.
+     *
+     * \param[in] endp List of endpoints.
+     * \param[in] idx Index of socket.
+     * \param[in] count Number of sockets.
+     *
+     * \return The endpoints for socket \c idx.
+     */
+    static std::list<std::string> sliceEndpoints(const std::vector<std::string>& endp, size_t idx, size_t count);
+
+    /**
+     * \brief Closes/Opens the sockets connection of a path.
+     *
+     * \param[in] idx Index of path.
      */
     ///@{
-    void connClose();
-    void connOpen();
+    void connClose(size_t idx);
+    void connOpen(size_t idx);
     ///@}
 
     /**
      * \brief Closes/Opens the sockets for synchronization.
+     *
+     * Each socket is connected to one snapshot endpoint,
+     * while the last socket is connected to the remaining ones.
+     *
+     * \param[in] idx Index of socket.
      */
     ///@{
-    void snapClose();
-    void snapOpen();
+    void snapClose(int idx);
+    void snapOpen(int idx);
     ///@}
 
     /**
      * \brief Sends announce message to the remote party.
+     *
+     * \param[in] idx Index of path.
+     */
+    void sendAnnounce(size_t idx);
+
+    /**
+     * \brief Sends a message to the broker(s).
+     *
+     * The message is sent through every path which is stable,
+     * or through every path when none of them is stable.
+     * Paths are preferred by their measured round trip time,
+     * so the message is sent to the fastest path first.
+     *
+     * \param[in] part Message to send.
      */
-    void sendAnnounce();
+    void sendDispatch(zmq::Part&& part);
 
     /**
      * \brief Sends sync message to the remote party.
+     *
+     * \param[in] idx Index of socket.
+     * \param[in] seqn Sequence number of request.
      */
-    void sendSync(uint8_t seqn);
+    void sendSync(int idx, uint8_t seqn);
 
     /**
      * \brief Save the configuration upon start.
@@ -100,16 +168,30 @@ protected:
     /**
      * \brief Collects a message which was published by a broker.
      *
+     * \param[in] idx Index of path.
+     * \param[in] payload Message payload.
+     */
+    void collectBrokerMessage(size_t idx, zmq::Part&& payload);
+
+    /**
+     * \brief Collects a keepalive which was published by a broker.
+     *
+     * Broker status is recorded. A periodic keepalive is a ping,
+     * while an echo of the latest keepalive sent by this path
+     * is a sample of round trip time. Any other echo counts as data.
+     *
+     * \param[in] idx Index of path.
      * \param[in] payload Message payload.
      */
-    void collectBrokerMessage(zmq::Part&& payload);
+    void collectBrokerHugz(size_t idx, const zmq::Part& payload);
 
     /**
      * \brief Receives snapshot data from broker.
      *
+     * \param[in] idx Index of socket.
      * \param[in] payload Payload received from broker.
      */
-    void recvBrokerSnapshot(zmq::Part&& payload);
+    void recvBrokerSnapshot(int idx, zmq::Part&& payload);
 
     /**
      * \brief Accepts a topic, for the specified worker.
@@ -119,13 +201,58 @@ protected:
      * updated.
      *
      * \param[in] part Packed topic.
+     * \param[in] conn Connection of the path where the topic was delivered,
+     *      it's notified with the round trip time of own topics,
+     *      or null for topics of a snapshot.
      *
      * \return Whether topic was accepted or not.
      *
      * \see acceptTopic(const Uuid&, Topic::SeqN)
      * \see notifySequenceNumber()
+     * \see cacheTopic(const Topic&, bool, bool)
+     */
+    bool acceptTopic(const zmq::Part& part, ConnMachine* conn);
+
+    /**
+     * \brief Stores a state topic into the cache, if any.
+     *
+     * Accepted topics always replace the cached value.
+     * A snapshot topic which was not accepted is stored only
+     * when its name is not cached yet, because a newer topic
+     * of the same worker may have been already delivered with
+     * a different name.
+     *
+     * \param[in] t Topic.
+     * \param[in] accepted Whether topic was accepted.
+     * \param[in] snapshot Whether topic was received by a snapshot.
+     */
+    void cacheTopic(const Topic& t, bool accepted, bool snapshot);
+
+    /**
+     * \brief Conflates a delivery, if its name was configured to be.
+     *
+     * Only \ref Topic::State topics are conflated.
+     * The main thread is notified only when no delivery
+     * of the same name is already pending, otherwise the
+     * pending one is replaced.
+     *
+     * \param[in] payload Packed topic, moved only if conflated.
+     *
+     * \return Whether delivery was conflated, thus no event shall be sent.
+     *
+     * \see Session::sendConflatedEvent(std::string_view)
+     */
+    bool conflateDelivery(zmq::Part& payload);
+
+    /**
+     * \brief Passes a delivery to the handler.
+     *
+     * The duration of the call is recorded, and
+     * it is counted when exceeding the budget.
+     *
+     * \param[in] t Delivered topic.
      */
-    bool acceptTopic(const zmq::Part& part);
+    void callDeliveryHandler(const TopicView& t) noexcept;
 
     /**
      * \brief Accepts a topic, for the specified worker.
@@ -141,7 +268,28 @@ protected:
     bool acceptTopic(const Uuid& worker, Topic::SeqN value);
 
     /**
-     * \brief To be called whenever state of connection changes.
+     * \brief Records the latency of an own topic.
+     *
+     * Latency is measured from the dispatch of the topic,
+     * until it's delivered back by the broker.
+     * Only the latest dispatched topics are tracked.
+     *
+     * \param[in] value Sequence number of the delivered topic.
+     * \param[in] conn Connection to notify with the latency, if not null.
+     */
+    void recordDeliveryLatency(Topic::SeqN value, ConnMachine* conn);
+
+    /**
+     * \brief Records the latencies between hops of a traced topic.
+     *
+     * \param[in] t Delivered topic.
+     */
+    void recordTrace(const Topic& t);
+
+    /**
+     * \brief To be called whenever state of connection of any path changes.
+     *
+     * The session is online when at least one path is stable.
      *
      * \param[in] newState New connection state, that is \ref ConnMachine::State.
      *
@@ -174,29 +322,67 @@ protected:
 
     /**
      * \brief Notifies for any change of current sequence number.
+     *
+     * Sequence number is published through the state shared with the runner.
      */
     void notifySequenceNumber() const;
 
 
 protected:
-    const std::unique_ptr<zmq::Socket> zsnapshot_; ///< ZMQ socket to receive snapshots.
-    const std::unique_ptr<zmq::Socket> zdelivery_; ///< ZMQ socket to receive data.
-    const std::unique_ptr<zmq::Socket> zdispatch_; ///< ZMQ socket to send data.
-    const std::unique_ptr<ConnMachine> conn_;      ///< Connection state machine.
-    const std::unique_ptr<SyncMachine> sync_;      ///< Connection sync machine.
-    zmq::Socket* const zseqs_;                     ///< ZMQ socket to send sequence number.
-
-    bool isOnline_;     ///< Whether the worker's connection is up.
-    bool isSnapshot_;   ///< Whether for workers is syncing its snapshot.
-    Uuid brokerUuid_;   ///< Broker which last sucessfully synced.
-    WorkerConfig conf_; ///< Configuration for running the asynchronous task.
+    /// Maximum number of sockets to race snapshot requests.
+    static constexpr size_t SnapshotSockets = 4;
+
+    std::array<std::unique_ptr<zmq::Socket>, SnapshotSockets> zsnapshot_; ///< ZMQ sockets to receive snapshots.
+
+    /**
+     * \brief Redundant path to broker(s).
+     *
+     * When there are as many delivery as dispatch endpoints,
+     * each pair of endpoints is a path, with its own sockets
+     * and liveness, so a failing path is reconnected alone.
+     * Otherwise, a single path connects to every endpoint.
+     */
+    struct Path
+    {
+        std::string name;                       ///< Name of path, used for logs and timers.
+        std::unique_ptr<zmq::Socket> zdelivery; ///< ZMQ socket to receive data.
+        std::unique_ptr<zmq::Socket> zdispatch; ///< ZMQ socket to send data.
+        std::unique_ptr<ConnMachine> conn;      ///< Connection state machine.
+        uint64_t hugzNonce = 0;                 ///< Nonce of the latest keepalive.
+    };
+
+    /// Maximum number of redundant paths.
+    static constexpr size_t PathSockets = 4;
+
+    std::array<Path, PathSockets> path_;      ///< Paths to broker(s).
+    size_t pathCount_;                        ///< Number of paths in use.
+    const std::unique_ptr<SyncMachine> sync_; ///< Connection sync machine.
+    WorkerMetrics* const metrics_;            ///< Metrics of this session.
+    TopicCache* const cache_;                 ///< Cache of state topics, if not null.
+    DeliveryConflater* const conflater_;      ///< Pending conflated deliveries.
+
+    const std::function<void(const TopicView&)> handler_; ///< Handler of deliveries, if any.
+    const std::chrono::nanoseconds handlerBudget_;        ///< Expected maximum duration of the handler.
+
+    bool isOnline_;      ///< Whether the worker's connection is up.
+    bool isSnapshot_;    ///< Whether for workers is syncing its snapshot.
+    uint64_t hugzNonce_; ///< Nonce of the latest keepalive, of any path.
+    Uuid brokerUuid_;    ///< Broker which last sucessfully synced.
+    WorkerConfig conf_;  ///< Configuration for running the asynchronous task.
 
     /// Alias for worker's uuid type.
     using WorkerUuid = Uuid;
 
     Topic::SeqN seqNum_;                             ///< Sequence number.
     LRUCache<Topic::Name, bool> subscrTopic_;        ///< Subscribed topics.
+    LRUCache<Topic::Name, bool> conflTopic_;         ///< Conflated topics.
     LRUCache<WorkerUuid, Topic::SeqN> workerSeqNum_; ///< Sequence numbers.
+
+    /// Dispatch time of a topic.
+    using DispatchTime = std::pair<Topic::SeqN, std::chrono::steady_clock::time_point>;
+
+    std::array<DispatchTime, 256> dispatchTime_;         ///< Latest dispatched topics.
+    std::chrono::steady_clock::time_point syncStarted_; ///< Start time of snapshot download.
 };
 
 } // namespace fuurin
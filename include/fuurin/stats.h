@@ -0,0 +1,467 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef FUURIN_STATS_H
+#define FUURIN_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace fuurin {
+
+/**
+ * \brief Monotonic counter of events.
+ *
+ * A counter is meant to be increased by a single thread, i.e. the
+ * session's one, and read by any other thread. Since there is only one
+ * writer, increment is a relaxed load followed by a relaxed store,
+ * so it doesn't need any locked instruction.
+ */
+class Counter final
+{
+public:
+    /**
+     * \brief Initializes the counter to zero.
+     */
+    Counter() noexcept
+        : val_{0}
+    {
+    }
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+    ///@}
+
+    /**
+     * \brief Increases the counter.
+     *
+     * This method shall be called by the writer thread only.
+     *
+     * \param[in] n Amount to add.
+     */
+    void add(uint64_t n = 1) noexcept
+    {
+        val_.store(val_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /**
+     * \return The current value.
+     *
+     * This method is thread-safe.
+     */
+    uint64_t value() const noexcept
+    {
+        return val_.load(std::memory_order_relaxed);
+    }
+
+
+private:
+    std::atomic<uint64_t> val_; ///< Value.
+};
+
+
+/**
+ * \brief Latest value of a quantity.
+ *
+ * Like \ref Counter, a gauge is set by a single thread
+ * and it can be read by any other thread.
+ */
+class Gauge final
+{
+public:
+    /**
+     * \brief Initializes the gauge to zero.
+     */
+    Gauge() noexcept
+        : val_{0}
+    {
+    }
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    Gauge(const Gauge&) = delete;
+    Gauge& operator=(const Gauge&) = delete;
+    ///@}
+
+    /**
+     * \brief Sets the value.
+     *
+     * This method shall be called by the writer thread only.
+     *
+     * \param[in] v New value.
+     */
+    void set(uint64_t v) noexcept
+    {
+        val_.store(v, std::memory_order_relaxed);
+    }
+
+    /**
+     * \return The current value.
+     *
+     * This method is thread-safe.
+     */
+    uint64_t value() const noexcept
+    {
+        return val_.load(std::memory_order_relaxed);
+    }
+
+
+private:
+    std::atomic<uint64_t> val_; ///< Value.
+};
+
+
+/**
+ * \brief Histogram of latencies.
+ *
+ * Buckets are distributed like in HDR histograms: values lower than
+ * \ref SubCount have a bucket each, while every greater power of two
+ * is split into \ref SubCount linear buckets. Thus the relative error
+ * of a recorded value is less than 1 / \ref SubCount, over the whole
+ * 64 bits range, with a fixed amount of memory.
+ *
+ * Like \ref Counter, a histogram is recorded by a single thread
+ * and it can be read by any other thread.
+ */
+class Histogram final
+{
+public:
+    static constexpr unsigned SubBits = 3;                               ///< Bits of linear buckets.
+    static constexpr size_t SubCount = size_t(1) << SubBits;             ///< Number of linear buckets.
+    static constexpr size_t BucketCount = (64 - SubBits + 1) * SubCount; ///< Number of buckets.
+
+    /**
+     * \brief Values of a histogram, at some point in time.
+     */
+    struct Snapshot
+    {
+        uint64_t count; ///< Number of recorded values.
+        uint64_t sum;   ///< Sum of recorded values.
+        uint64_t max;   ///< Maximum recorded value.
+
+        std::array<uint64_t, BucketCount> buckets; ///< Number of values in each bucket.
+
+        /**
+         * \brief Computes a percentile.
+         *
+         * \param[in] q Quantile, between 0 and 1.
+         *
+         * \return The highest value of the bucket where the quantile falls,
+         *      but not greater than \ref max, or 0 if no value was recorded.
+         */
+        uint64_t percentile(double q) const noexcept;
+
+        /**
+         * \return Average of recorded values, or 0 if no value was recorded.
+         */
+        double mean() const noexcept;
+    };
+
+
+public:
+    /**
+     * \brief Initializes an empty histogram.
+     */
+    Histogram() noexcept;
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+    ///@}
+
+    /**
+     * \brief Records a value.
+     *
+     * This method shall be called by the writer thread only.
+     *
+     * \param[in] value Value to record, durations are recorded in nanoseconds.
+     */
+    ///@{
+    void record(uint64_t value) noexcept
+    {
+        buckets_[bucketIndex(value)].add();
+        count_.add();
+        sum_.add(value);
+
+        if (value > max_.load(std::memory_order_relaxed))
+            max_.store(value, std::memory_order_relaxed);
+    }
+
+    void record(std::chrono::nanoseconds value) noexcept
+    {
+        record(value.count() > 0 ? uint64_t(value.count()) : 0);
+    }
+    ///@}
+
+    /**
+     * \return The current values.
+     *
+     * This method is thread-safe.
+     */
+    Snapshot snapshot() const noexcept;
+
+    /**
+     * \param[in] value A value.
+     * \return Index of the bucket where the value is recorded.
+     */
+    static constexpr size_t bucketIndex(uint64_t value) noexcept
+    {
+        if (value < SubCount)
+            return size_t(value);
+
+        const unsigned shift = highestBit(value) - SubBits;
+        return ((size_t(shift) + 1) << SubBits) + size_t((value >> shift) & (SubCount - 1));
+    }
+
+    /**
+     * \param[in] value A value, not zero.
+     * \return Position of the most significant bit set.
+     */
+    static constexpr unsigned highestBit(uint64_t value) noexcept
+    {
+        unsigned ret = 0;
+        for (unsigned n = 32; n > 0; n >>= 1) {
+            if (value >> n) {
+                value >>= n;
+                ret += n;
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * \param[in] index Index of a bucket.
+     * \return Lowest/highest value recorded by the bucket.
+     */
+    ///@{
+    static constexpr uint64_t bucketLowest(size_t index) noexcept
+    {
+        if (index < SubCount)
+            return uint64_t(index);
+
+        const size_t shift = (index >> SubBits) - 1;
+        return uint64_t(SubCount + (index & (SubCount - 1))) << shift;
+    }
+
+    static constexpr uint64_t bucketHighest(size_t index) noexcept
+    {
+        return index + 1 >= BucketCount ? UINT64_MAX : bucketLowest(index + 1) - 1;
+    }
+    ///@}
+
+
+private:
+    std::array<Counter, BucketCount> buckets_; ///< Buckets.
+    Counter count_;                            ///< Number of values.
+    Counter sum_;                              ///< Sum of values.
+    std::atomic<uint64_t> max_;                ///< Maximum value.
+};
+
+
+/**
+ * \brief Latencies between hops of traced topics, with the same name.
+ *
+ * \see Topic::Hop
+ */
+struct TraceStats
+{
+    std::string name; ///< Topic name.
+
+    Histogram::Snapshot local;      ///< Nanoseconds from creation to dispatch, i.e. the inproc hop.
+    Histogram::Snapshot upstream;   ///< Nanoseconds from dispatch to broker ingest.
+    Histogram::Snapshot broker;     ///< Nanoseconds from broker ingest to fan-out.
+    Histogram::Snapshot downstream; ///< Nanoseconds from broker fan-out to delivery.
+    Histogram::Snapshot total;      ///< Nanoseconds from creation to delivery.
+};
+
+
+/**
+ * \brief Statistics of a \ref Worker.
+ *
+ * Counters are cumulative since the worker was created.
+ */
+struct WorkerStats
+{
+    uint64_t dispatched;      ///< Topics dispatched to broker(s).
+    uint64_t delivered;       ///< Topics delivered from broker(s).
+    uint64_t discarded;       ///< Topics discarded, because already delivered.
+    uint64_t syncElements;    ///< Snapshot elements received.
+    uint64_t syncRetries;     ///< Snapshot requests sent again after a timeout.
+    uint64_t connTransitions; ///< Changes of connection state.
+    uint64_t conflated;       ///< Deliveries replaced by a newer one, before being read.
+    uint64_t dispatchBlocked; ///< Topics refused because the dispatch queue reached its high water mark.
+    uint64_t dispatchDropped; ///< Topics dropped because the worker was not running.
+    uint64_t handlerOverruns; ///< Calls of the delivery handler which exceeded their time budget.
+
+    Histogram::Snapshot deliveryLatency;  ///< Nanoseconds from dispatch to delivery of own topics.
+    Histogram::Snapshot syncLatency;      ///< Nanoseconds to download a snapshot.
+    Histogram::Snapshot keepaliveLatency; ///< Nanoseconds from keepalive to its echo by broker(s).
+    Histogram::Snapshot handlerLatency;   ///< Nanoseconds spent by every call of the delivery handler.
+
+    uint64_t brokerWorkers; ///< Workers connected to the latest broker which sent a keepalive.
+    uint64_t brokerLoad;    ///< Topics per second dispatched by that broker.
+    uint64_t brokerTopics;  ///< Topic names stored by that broker.
+};
+
+
+/**
+ * \brief Statistics of a \ref Broker.
+ *
+ * Counters are cumulative since the broker was created.
+ */
+struct BrokerStats
+{
+    uint64_t received;      ///< Topics received from workers.
+    uint64_t dispatched;    ///< Topics stored and dispatched to workers.
+    uint64_t discarded;     ///< Topics discarded, because already stored.
+    uint64_t syncRequests;  ///< Snapshot requests served.
+    uint64_t syncElements;  ///< Snapshot elements sent.
+    uint64_t syncAborts;    ///< Snapshot replies aborted, because send would block.
+    uint64_t dropped;       ///< Topics of workers lost before being received, by gaps of sequence numbers.
+    uint64_t peerReceived;  ///< Topics received from peers, either forwarded or by snapshot.
+    uint64_t storageErrors; ///< Errors of the persistent storage.
+
+    Histogram::Snapshot dispatchLatency; ///< Nanoseconds to store and dispatch a topic.
+    Histogram::Snapshot syncLatency;     ///< Nanoseconds to send a snapshot.
+};
+
+
+/**
+ * \brief Live metrics of a \ref WorkerSession.
+ *
+ * They are recorded by the session and read by the \ref Worker.
+ *
+ * \see WorkerStats
+ */
+struct WorkerMetrics
+{
+    Counter dispatched;      ///< \see WorkerStats::dispatched.
+    Counter delivered;       ///< \see WorkerStats::delivered.
+    Counter discarded;       ///< \see WorkerStats::discarded.
+    Counter syncElements;    ///< \see WorkerStats::syncElements.
+    Counter syncRetries;     ///< \see WorkerStats::syncRetries.
+    Counter connTransitions; ///< \see WorkerStats::connTransitions.
+    Counter conflated;       ///< \see WorkerStats::conflated.
+    Counter dispatchBlocked; ///< \see WorkerStats::dispatchBlocked, written by the worker.
+    Counter dispatchDropped; ///< \see WorkerStats::dispatchDropped, written by the worker.
+    Counter handlerOverruns; ///< \see WorkerStats::handlerOverruns.
+
+    Histogram deliveryLatency;  ///< \see WorkerStats::deliveryLatency.
+    Histogram syncLatency;      ///< \see WorkerStats::syncLatency.
+    Histogram keepaliveLatency; ///< \see WorkerStats::keepaliveLatency.
+    Histogram handlerLatency;   ///< \see WorkerStats::handlerLatency.
+
+    Gauge brokerWorkers; ///< \see WorkerStats::brokerWorkers.
+    Gauge brokerLoad;    ///< \see WorkerStats::brokerLoad.
+    Gauge brokerTopics;  ///< \see WorkerStats::brokerTopics.
+
+    /**
+     * \brief Live latencies of traced topics with the same name.
+     * \see TraceStats
+     */
+    struct Trace
+    {
+        Histogram local;      ///< \see TraceStats::local.
+        Histogram upstream;   ///< \see TraceStats::upstream.
+        Histogram broker;     ///< \see TraceStats::broker.
+        Histogram downstream; ///< \see TraceStats::downstream.
+        Histogram total;      ///< \see TraceStats::total.
+    };
+
+    /// Maximum number of traced topic names.
+    static constexpr size_t TraceCapacity = 256;
+
+    /**
+     * \return The current statistics.
+     *
+     * This method is thread-safe.
+     */
+    WorkerStats stats() const noexcept;
+
+    /**
+     * \brief Returns the latencies of a traced topic name.
+     *
+     * Latencies are created upon first access, so the lock is
+     * taken only for a topic name which was never traced before.
+     *
+     * This method shall be called by the writer thread only.
+     *
+     * \param[in] name Topic name.
+     *
+     * \return The latencies, or \c nullptr if \ref TraceCapacity was exceeded.
+     */
+    Trace* trace(std::string_view name);
+
+    /**
+     * \return The current latencies of every traced topic name.
+     *
+     * This method is thread-safe.
+     */
+    std::vector<TraceStats> traceStats() const;
+
+
+private:
+    mutable std::mutex traceMutex_;                                     ///< Guards insertion of traces.
+    std::map<std::string, std::unique_ptr<Trace>, std::less<>> traces_; ///< Traces by topic name.
+};
+
+
+/**
+ * \brief Live metrics of a \ref BrokerSession.
+ *
+ * They are recorded by the session and read by the \ref Broker.
+ *
+ * \see BrokerStats
+ */
+struct BrokerMetrics
+{
+    Counter received;      ///< \see BrokerStats::received.
+    Counter dispatched;    ///< \see BrokerStats::dispatched.
+    Counter discarded;     ///< \see BrokerStats::discarded.
+    Counter syncRequests;  ///< \see BrokerStats::syncRequests.
+    Counter syncElements;  ///< \see BrokerStats::syncElements.
+    Counter syncAborts;    ///< \see BrokerStats::syncAborts.
+    Counter dropped;       ///< \see BrokerStats::dropped.
+    Counter peerReceived;  ///< \see BrokerStats::peerReceived.
+    Counter storageErrors; ///< \see BrokerStats::storageErrors.
+
+    Histogram dispatchLatency; ///< \see BrokerStats::dispatchLatency.
+    Histogram syncLatency;     ///< \see BrokerStats::syncLatency.
+
+    /**
+     * \return The current statistics.
+     *
+     * This method is thread-safe.
+     */
+    BrokerStats stats() const noexcept;
+};
+
+} // namespace fuurin
+
+#endif // FUURIN_STATS_H
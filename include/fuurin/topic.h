@@ -15,10 +15,12 @@
 #include "fuurin/zmqpart.h"
 
 #include <array>
+#include <optional>
 #include <functional>
 #include <string>
 #include <string_view>
 #include <ostream>
+#include <type_traits>
 
 
 namespace fuurin {
@@ -44,6 +46,42 @@ public:
         Event, ///< Topic is delivered once.
     };
 
+    /**
+     * \brief Flag of the packed type field, set when the topic is traced.
+     *
+     * So a topic is known to be traced without unpacking it.
+     *
+     * \see isTraced(const zmq::Part&)
+     */
+    static constexpr uint8_t TracedFlag = 0x80;
+
+    /**
+     * \brief Hop of a traced topic.
+     *
+     * \see Trace
+     */
+    enum struct Hop : uint8_t
+    {
+        Created,    ///< Topic is created by \ref Worker::dispatch.
+        Dispatched, ///< Topic is sent by the worker session.
+        Ingested,   ///< Topic is received by the broker session.
+        FannedOut,  ///< Topic is sent by the broker session.
+        Delivered,  ///< Topic is received by the worker session.
+
+        COUNT, ///< Number of items.
+    };
+
+    /**
+     * \brief Timestamps of a traced topic, for every \ref Hop.
+     *
+     * Timestamps are nanoseconds since epoch, taken from the realtime clock,
+     * since hops may happen in different processes. A hop which was not
+     * reached yet has a zero timestamp.
+     *
+     * \see traceNow()
+     */
+    using Trace = std::array<uint64_t, size_t(Hop::COUNT)>;
+
     /**
      * \brief Payload name data type.
      *
@@ -107,6 +145,35 @@ public:
         bool operator!=(const Name& rhs) const;
         ///@}
 
+        /**
+         * \brief Comparison operator, without constructing a name.
+         * \param[in] rhs A string, which is compared as it was truncated.
+         */
+        ///@{
+        template<typename T, typename = std::enable_if_t<
+                                 std::is_convertible_v<const T&, std::string_view> &&
+                                 !std::is_same_v<T, Name>>>
+        bool operator==(const T& rhs) const
+        {
+            return equals(std::string_view(rhs));
+        }
+
+        template<typename T, typename = std::enable_if_t<
+                                 std::is_convertible_v<const T&, std::string_view> &&
+                                 !std::is_same_v<T, Name>>>
+        bool operator!=(const T& rhs) const
+        {
+            return !equals(std::string_view(rhs));
+        }
+        ///@}
+
+
+    private:
+        /**
+         * \brief Compares this name with a string, as it was truncated.
+         */
+        bool equals(std::string_view rhs) const noexcept;
+
 
     private:
         size_t sz_;                ///< Actual size of the name.
@@ -182,6 +249,11 @@ public:
     Data& data() noexcept;
     ///@}
 
+    /**
+     * \return Timestamps, if this topic is traced.
+     */
+    const std::optional<Trace>& trace() const noexcept;
+
     /**
      * \brief Modifies this topic with passed value.
      * \param[in] v Broker uuid.
@@ -230,8 +302,29 @@ public:
     Topic& withData(Data&& v);
     ///@}
 
+    /**
+     * \brief Modifies this topic with passed value.
+     *
+     * A traced topic is packed with its timestamps,
+     * otherwise no additional data is transferred.
+     *
+     * \param[in] v Timestamps, or none to disable tracing.
+     */
+    Topic& withTrace(const std::optional<Trace>& v);
+
+    /**
+     * \brief Modifies a timestamp of this topic, if it's traced.
+     *
+     * \param[in] hop Hop to mark.
+     * \param[in] v Timestamp.
+     */
+    Topic& withTraceStamp(Hop hop, uint64_t v);
+
     /**
      * \brief Comparison operator.
+     *
+     * Timestamps are not compared.
+     *
      * \param[in] rhs Another topic.
      */
     ///@{
@@ -273,6 +366,57 @@ public:
      */
     static zmq::Part& withSeqNum(zmq::Part& part, Topic::SeqN val);
 
+    /**
+     * \brief Reads the type of a Topic packed data, without unpacking it.
+     *
+     * \param[in] part Topic packed data.
+     *
+     * \return The type of topic.
+     *
+     * \exception ZMQPartAccessFailed Failed to access the field that represents the type.
+     */
+    static Type typeOf(const zmq::Part& part);
+
+    /**
+     * \brief Reads the name of a Topic packed data, without unpacking it.
+     *
+     * \param[in] part Topic packed data.
+     *
+     * \return The name of topic, which refers to the packed data.
+     *
+     * \exception ZMQPartAccessFailed Failed to access the fields preceding the name.
+     */
+    static std::string_view nameOf(const zmq::Part& part);
+
+    /**
+     * \brief Reads whether a Topic packed data is traced, without unpacking it.
+     *
+     * \param[in] part Topic packed data.
+     *
+     * \return Whether the topic is traced.
+     */
+    static bool isTraced(const zmq::Part& part) noexcept;
+
+    /**
+     * \brief Patches a Topic packed data with a timestamp, if it's traced.
+     *
+     * \param[in] part Topic packed data.
+     * \param[in] hop Hop to mark.
+     * \param[in] val Timestamp.
+     *
+     * \return Whether the topic is traced.
+     *
+     * \exception ZMQPartAccessFailed Failed to access the topic fields.
+     */
+    static bool withTraceStamp(zmq::Part& part, Hop hop, uint64_t val);
+
+    /**
+     * \return Current time to mark a traced topic.
+     *
+     * \see Trace
+     */
+    static uint64_t traceNow() noexcept;
+
 
 private:
     Uuid broker_; ///< Broker uuid.
@@ -281,6 +425,8 @@ private:
     Name name_;   ///< Topic name.
     Data data_;   ///< Topic data.
     Type type_;   ///< Topic type.
+
+    std::optional<Trace> trace_; ///< Topic timestamps.
 };
 
 
@@ -300,12 +446,21 @@ namespace std {
 
 /**
  * \brief Makes \ref fuurin::Topic::Name hashable.
+ *
+ * Hashing is transparent, so that names can be looked up
+ * by string, without constructing a \ref fuurin::Topic::Name.
  */
 template<>
 struct hash<fuurin::Topic::Name>
 {
+    ///< Enables heterogeneous lookup.
+    using is_transparent = void;
+
     /// Hashing operator.
+    ///@{
     size_t operator()(const fuurin::Topic::Name& n) const;
+    size_t operator()(std::string_view n) const;
+    ///@}
 };
 
 } // namespace std
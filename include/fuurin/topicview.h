@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef FUURIN_TOPICVIEW_H
+#define FUURIN_TOPICVIEW_H
+
+#include "fuurin/topic.h"
+#include "fuurin/uuid.h"
+
+#include <string_view>
+
+
+namespace fuurin {
+
+namespace zmq {
+class Part;
+} // namespace zmq
+
+
+/**
+ * \brief Read only view of a packed \ref Topic.
+ *
+ * Fields are accessed in place, so neither the name nor
+ * the data are copied. The view is valid as long as the
+ * packed topic it was created from.
+ *
+ * \see Topic::fromPart(const zmq::Part&)
+ */
+class TopicView final
+{
+public:
+    /**
+     * \brief Initializes a view of a packed topic.
+     *
+     * \param[in] part Packed topic, it must outlive this view.
+     *
+     * \exception ZMQPartAccessFailed The topic could not be unpacked.
+     *
+     * \see Topic::toPart()
+     */
+    explicit TopicView(const zmq::Part& part);
+
+    /**
+     * \return The broker uuid.
+     */
+    Uuid broker() const;
+
+    /**
+     * \return The worker uuid.
+     */
+    Uuid worker() const;
+
+    /**
+     * \return The sequence number.
+     */
+    Topic::SeqN seqNum() const noexcept;
+
+    /**
+     * \return The topic name.
+     */
+    std::string_view name() const noexcept;
+
+    /**
+     * \return The topic data.
+     */
+    std::string_view data() const noexcept;
+
+    /**
+     * \return The topic type.
+     */
+    Topic::Type type() const noexcept;
+
+    /**
+     * \return A copy of the viewed topic, which can outlive this view.
+     */
+    Topic toTopic() const;
+
+
+private:
+    const zmq::Part& part_; ///< Packed topic.
+    Topic::SeqN seqn_;      ///< Sequence number.
+    Topic::Type type_;      ///< Topic type.
+    Uuid::Bytes broker_;    ///< Broker uuid.
+    Uuid::Bytes worker_;    ///< Worker uuid.
+    std::string_view name_; ///< Topic name.
+    std::string_view data_; ///< Topic data.
+};
+
+} // namespace fuurin
+
+#endif // FUURIN_TOPICVIEW_H
@@ -14,19 +14,27 @@
 #include "fuurin/runner.h"
 #include "fuurin/event.h"
 #include "fuurin/topic.h"
+#include "fuurin/topicview.h"
 #include "fuurin/uuid.h"
+#include "fuurin/stats.h"
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <string_view>
 #include <vector>
 #include <tuple>
 #include <optional>
 #include <atomic>
+#include <type_traits>
 
 
 namespace fuurin {
 namespace zmq {
 class Part;
 } // namespace zmq
+class TopicCache;
+class DeliveryConflater;
 
 
 /**
@@ -37,6 +45,22 @@ class Part;
  */
 class Worker : public Runner
 {
+public:
+    /**
+     * \brief Result of a non-blocking dispatch.
+     * \see tryDispatch(Topic::Name, const Topic::Data&, Topic::Type)
+     */
+    enum class DispatchResult
+    {
+        Sent,       ///< Topic was queued to be sent.
+        WouldBlock, ///< Queue of topics reached the outbound high water mark.
+        NotRunning, ///< Worker is not running.
+    };
+
+    /// Function type of the delivery handler.
+    using DeliveryHandler = std::function<void(const TopicView&)>;
+
+
 public:
     /**
      * \brief Initializes this worker.
@@ -84,6 +108,190 @@ public:
      */
     std::tuple<bool, const std::vector<Topic::Name>&> topicsNames() const;
 
+    /**
+     * \brief Sets topics which deliveries are conflated.
+     *
+     * For every conflated name, at most one \ref Event::Type::Delivery
+     * event is pending to be read by \ref waitForEvent(), that is the
+     * latest delivered one, because any newer delivery replaces the
+     * pending one in place. So a slow reader gets the latest value
+     * only, instead of every intermediate one, and pending events
+     * don't grow with the delivery rate. Replaced deliveries are
+     * counted by \ref WorkerStats::conflated.
+     *
+     * Only topics of type \ref Topic::State are conflated.
+     * By default no topic is conflated.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] names List of topics names.
+     *
+     * \see topicsConflated()
+     */
+    void setTopicsConflated(const std::vector<Topic::Name>& names);
+
+    /**
+     * \return The topic names which deliveries are conflated.
+     *
+     * \see setTopicsConflated(const std::vector<Topic::Name>&)
+     */
+    const std::vector<Topic::Name>& topicsConflated() const;
+
+    /**
+     * \brief Sets tracing of dispatched topics.
+     *
+     * A traced topic carries the timestamps of every hop,
+     * from its creation to its delivery, see \ref Topic::Trace.
+     * Latencies between hops of the delivered traced topics
+     * are aggregated by topic name, see \ref traceStats().
+     * By default tracing is disabled.
+     *
+     * \param[in] enable Whether to trace topics.
+     *
+     * \see tracing()
+     */
+    void setTracing(bool enable);
+
+    /**
+     * \return Whether dispatched topics are traced.
+     *
+     * \see setTracing(bool)
+     */
+    bool tracing() const;
+
+    /**
+     * \brief Sets racing of snapshot requests.
+     *
+     * When enabled, a \ref sync() request is sent to every snapshot
+     * endpoint at once, and the first broker which replies is used
+     * to download the snapshot, while the others are cancelled.
+     * Otherwise only one endpoint is used.
+     * By default racing is disabled.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] enable Whether to race snapshot requests.
+     *
+     * \see syncRacing()
+     */
+    void setSyncRacing(bool enable);
+
+    /**
+     * \return Whether snapshot requests are raced.
+     *
+     * \see setSyncRacing(bool)
+     */
+    bool syncRacing() const;
+
+    /**
+     * \brief Sets timing of connection liveness.
+     *
+     * While connecting, announcements are sent every \c retry interval.
+     * Connection is lost when no keepalive (or data) is received from
+     * broker(s) within \c timeout.
+     *
+     * When \c keepalive is not zero, timeout adapts to the round trip time,
+     * which is measured from the dispatch of own topics to their delivery:
+     * it becomes \c keepalive plus a retransmission timeout estimated like
+     * in TCP, but never greater than \c timeout. Thus \c keepalive shall be
+     * the interval of broker's keepalives, that is 1 s.
+     *
+     * By default \c retry is 500 ms, \c timeout is 3 s and the
+     * adaptive timeout is disabled.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] retry Interval of announcements.
+     * \param[in] timeout Timeout, or maximum adaptive timeout.
+     * \param[in] keepalive Expected interval of keepalives, or zero to disable adaptive timeout.
+     *
+     * \see connectionTimeout()
+     */
+    void setConnectionTimeout(std::chrono::milliseconds retry, std::chrono::milliseconds timeout,
+        std::chrono::milliseconds keepalive = std::chrono::milliseconds::zero());
+
+    /**
+     * \return A tuple with retry, timeout and keepalive intervals.
+     *
+     * \see setConnectionTimeout(std::chrono::milliseconds, std::chrono::milliseconds, std::chrono::milliseconds)
+     */
+    std::tuple<std::chrono::milliseconds, std::chrono::milliseconds, std::chrono::milliseconds>
+    connectionTimeout() const;
+
+    /**
+     * \brief Sets whether to cache the latest value of state topics.
+     *
+     * When enabled, every delivered or synchronized topic of type
+     * \ref Topic::State is stored by the asynchronous task, and it
+     * can be read by \ref get() and \ref forEach(), without waiting
+     * for events. Cached topics are kept across restarts.
+     *
+     * By default the cache is disabled.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] enable Whether to enable the cache.
+     *
+     * \see stateCache()
+     */
+    void setStateCache(bool enable);
+
+    /**
+     * \return Whether the cache of state topics is enabled.
+     *
+     * \see setStateCache(bool)
+     */
+    bool stateCache() const;
+
+    /**
+     * \brief Sets a handler of deliveries, called by the asynchronous task.
+     *
+     * Every accepted delivery is passed to the handler by the asynchronous
+     * task, as soon as it's received, skipping the hop to the main thread:
+     * no \ref Event::Type::Delivery event is sent, thus deliveries are
+     * neither returned by \ref waitForEvent() nor conflated.
+     * The passed \ref TopicView is valid only during the call.
+     * Topics of a snapshot are still notified by events.
+     *
+     * The asynchronous task is stalled while the handler runs, that is
+     * no other topic is received or dispatched, and no keepalive is sent,
+     * so the handler shall do minimal work and it shall never block.
+     * The handler must be \c noexcept and it shall not call any method
+     * of this worker, but the thread-safe ones.
+     *
+     * The duration of every call is recorded by \ref WorkerStats::handlerLatency,
+     * while calls lasting longer than the budget are counted by
+     * \ref WorkerStats::handlerOverruns.
+     *
+     * By default no handler is set.
+     *
+     * The setting is applied upon \ref start().
+     *
+     * \param[in] f A \c noexcept callable taking a \ref TopicView, or \c nullptr to remove the handler.
+     * \param[in] budget Expected maximum duration of a call.
+     *
+     * \see hasDeliveryHandler()
+     */
+    template<typename F>
+    void setDeliveryHandler(F&& f, std::chrono::microseconds budget = std::chrono::microseconds(100))
+    {
+        if constexpr (std::is_null_pointer_v<std::decay_t<F>>) {
+            handler_ = nullptr;
+        } else {
+            static_assert(std::is_nothrow_invocable_v<std::decay_t<F>&, const TopicView&>,
+                "delivery handler must be noexcept");
+            handler_ = std::forward<F>(f);
+        }
+        handlerBudget_ = budget;
+    }
+
+    /**
+     * \return Whether a delivery handler is set.
+     *
+     * \see setDeliveryHandler(F&&, std::chrono::microseconds)
+     */
+    bool hasDeliveryHandler() const;
+
     /**
      * \brief Sends a message to the broker(s).
      *
@@ -114,6 +322,33 @@ public:
     void dispatch(Topic::Name name, Topic::Data&& data, Topic::Type type = Topic::State);
     ///@}
 
+    /**
+     * \brief Sends a message to the broker(s), without blocking or queueing beyond limits.
+     *
+     * Same as \ref dispatch(), but the topic is refused when the operations
+     * which are queued to the asynchronous task, and not yet received by it,
+     * reached the outbound high water mark. In such case the caller shall
+     * retry later, i.e. it's given backpressure. Without a limit, topics are
+     * never refused.
+     *
+     * Refused topics are counted by \ref WorkerStats::dispatchBlocked, while
+     * topics dispatched while not running are counted by \ref WorkerStats::dispatchDropped.
+     *
+     * \param[in] name Name of topic, no more than \ref Topic::Name::capacity() chars.
+     * \param[in] data Data of topic.
+     * \param[in] type Type of topic.
+     *
+     * \return Whether the topic was sent, or why it was not.
+     *
+     * \see dispatch(Topic::Name, const Topic::Data&, Topic::Type)
+     * \see Runner::setHighWaterMark(int, int)
+     * \see Runner::pendingOperations()
+     */
+    ///@{
+    DispatchResult tryDispatch(Topic::Name name, const Topic::Data& data, Topic::Type type = Topic::State);
+    DispatchResult tryDispatch(Topic::Name name, Topic::Data&& data, Topic::Type type = Topic::State);
+    ///@}
+
     /**
      * \brief Sends a synchronization request to the broker.
      *
@@ -186,6 +421,60 @@ public:
      */
     Topic::SeqN seqNumber() const;
 
+    /**
+     * \brief Returns the statistics of this worker.
+     *
+     * Statistics are recorded by the asynchronous task,
+     * without any locking, and they can be read at any time.
+     *
+     * This method is thread-safe.
+     *
+     * \return Current statistics.
+     */
+    WorkerStats stats() const;
+
+    /**
+     * \brief Returns the latencies of the delivered traced topics.
+     *
+     * This method is thread-safe.
+     *
+     * \return Latencies for every traced topic name.
+     *
+     * \see setTracing(bool)
+     */
+    std::vector<TraceStats> traceStats() const;
+
+    /**
+     * \brief Gets the latest value of a state topic.
+     *
+     * Reading never blocks the asynchronous task.
+     *
+     * This method is thread-safe.
+     *
+     * \param[in] name Name of topic.
+     *
+     * \return The cached topic, if any.
+     *
+     * \see setStateCache(bool)
+     */
+    std::optional<Topic> get(std::string_view name) const;
+
+    /**
+     * \brief Visits the latest value of every cached state topic.
+     *
+     * Topics are visited in no specific order, and the ones
+     * cached while visiting might be visited or not.
+     * Reading never blocks the asynchronous task.
+     *
+     * This method is thread-safe.
+     *
+     * \param[in] prefix Prefix of topic names, empty for every topic.
+     * \param[in] f Function called for every matching topic.
+     *
+     * \see setStateCache(bool)
+     */
+    void forEach(std::string_view prefix, const std::function<void(const Topic&)>& f) const;
+
 
 protected:
     /**
@@ -203,6 +492,14 @@ protected:
      */
     virtual std::unique_ptr<Session> createSession() const override;
 
+    /**
+     * \brief Takes a pending conflated delivery.
+     *
+     * \see Runner::takeConflatedEvent()
+     * \see setTopicsConflated(const std::vector<Topic::Name>&)
+     */
+    virtual std::optional<zmq::Part> takeConflatedEvent(SessionEnv::token_t token, std::string_view name) const override;
+
     /**
      * \brief Waits for specific events.
      *
@@ -210,16 +507,31 @@ protected:
      */
     Event waitForEvent(std::chrono::milliseconds timeout, EventMatchFunc match) const;
 
+    /**
+     * \return Whether a topic can be dispatched without exceeding the outbound high water mark.
+     *
+     * \see tryDispatch(Topic::Name, const Topic::Data&, Topic::Type)
+     */
+    DispatchResult canDispatch();
+
 
 protected:
 protected:
-    const std::unique_ptr<zmq::Socket> zseqs_; ///< ZMQ socket to send sequence number.
-    const std::unique_ptr<zmq::Socket> zseqr_; ///< ZMQ socket to receive sequence number.
-
-    mutable std::atomic<Topic::SeqN> seqNum_; ///< Worker sequence number.
+    const std::unique_ptr<WorkerMetrics> metrics_;   ///< Metrics recorded by the session.
+    const std::unique_ptr<TopicCache> cache_;        ///< Latest state topics.
+    const std::unique_ptr<DeliveryConflater> confl_; ///< Pending conflated deliveries.
 
-    bool subscrAll_;                       ///< Whether to subscribe to every topic.
-    std::vector<Topic::Name> subscrNames_; ///< List of topic names.
+    bool tracing_;                            ///< Whether to trace topics.
+    bool syncRacing_;                         ///< Whether to race snapshot requests.
+    bool stateCache_;                         ///< Whether to cache state topics.
+    std::chrono::milliseconds connRetry_;     ///< Interval of connection announcements.
+    std::chrono::milliseconds connTimeout_;   ///< Connection timeout.
+    std::chrono::milliseconds connKeepalive_; ///< Expected interval of keepalives.
+    bool subscrAll_;                          ///< Whether to subscribe to every topic.
+    std::vector<Topic::Name> subscrNames_;    ///< List of topic names.
+    std::vector<Topic::Name> conflNames_;     ///< List of conflated topic names.
+    DeliveryHandler handler_;                 ///< Handler of deliveries, if any.
+    std::chrono::microseconds handlerBudget_; ///< Expected maximum duration of the handler.
 };
 
 } // namespace fuurin
@@ -14,6 +14,7 @@
 #include "fuurin/uuid.h"
 #include "fuurin/topic.h"
 
+#include <chrono>
 #include <vector>
 #include <string>
 
@@ -49,6 +50,34 @@ struct WorkerConfig
     std::vector<std::string> endpSnapshot;
     ///@}
 
+    ///< Whether to race snapshot requests among every endpoint.
+    bool syncRacing = false;
+
+    ///< Intervals of connection liveness, \see Worker::setConnectionTimeout.
+    ///@{
+    std::chrono::milliseconds connRetry{500};
+    std::chrono::milliseconds connTimeout{3000};
+    std::chrono::milliseconds connKeepalive{0};
+    ///@}
+
+    ///< List of topic names which deliveries are conflated, \see Worker::setTopicsConflated.
+    std::vector<Topic::Name> topicsConflated{};
+
+    ///< High water marks of data sockets, zero means no limit, \see Runner::setHighWaterMark.
+    ///@{
+    int hwmSend = 0;
+    int hwmRecv = 0;
+    ///@}
+
+    ///< Kernel buffer sizes of data sockets, -1 means OS default, \see Runner::setBufferSize.
+    ///@{
+    int bufSend = -1;
+    int bufRecv = -1;
+    ///@}
+
+    ///< Maximum number of messages received per ready data socket, \see Runner::setDrainBatch.
+    int drainBatch = 32;
+
     /**
      * \brief Comparison operator.
      * \param[in] rhs Another config.
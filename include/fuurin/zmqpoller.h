@@ -321,6 +321,24 @@ public:
      * \see PollerWaiter::wait()
      */
     virtual PollerEvents wait() = 0;
+
+    /**
+     * \brief Waits for an event, busy polling at first.
+     *
+     * Sockets are polled without blocking, for up to the passed
+     * spin duration, until at least one socket is ready.
+     * Afterwards it waits like \ref wait(), for up to \ref timeout().
+     * So the latency to detect a ready socket is lowered,
+     * at the cost of keeping the CPU busy.
+     *
+     * \param[in] spin Duration of busy polling, a non positive value means no busy polling.
+     *
+     * \exception ZMQPollerWaitFailed Polling could not be performed.
+     * \return An iterable \ref PollerEvents object over the subset of ready sockets.
+     *
+     * \see wait()
+     */
+    PollerEvents busyWait(std::chrono::microseconds spin);
 };
 
 
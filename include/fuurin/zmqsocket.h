@@ -138,6 +138,27 @@ public:
      */
     std::tuple<int, int> highWaterMark() const noexcept;
 
+    /**
+     * \brief Sets \c ZMQ_SNDBUF and \c ZMQ_RCVBUF values to this socket.
+     * The buffer sizes are actually applied at connection/bind time.
+     *
+     * \remark A value of -1 means the OS default.
+     *
+     * \param[in] snd Size of the kernel transmit buffer, in bytes.
+     * \param[in] rcv Size of the kernel receive buffer, in bytes.
+     *
+     * \see bufferSize()
+     */
+    void setBufferSize(int snd, int rcv) noexcept;
+
+    /**
+     * \brief Returns the size of kernel transmit and receive buffers.
+     * \return A pair of the form <ZMQ_SNDBUF, ZMQ_RCVBUF>.
+     *
+     * \see setBufferSize(int, int)
+     */
+    std::tuple<int, int> bufferSize() const noexcept;
+
     /**
      * \brief Sets \c ZMQ_CONFLATE option to this socket.
      * \see conflate()
@@ -580,6 +601,8 @@ private:
     std::chrono::milliseconds linger_;     ///< Linger value.
     int hwmsnd_;                           ///< High water mark for outbound messages.
     int hwmrcv_;                           ///< High water mark for inbound messages.
+    int bufsnd_;                           ///< Size of kernel transmit buffer.
+    int bufrcv_;                           ///< Size of kernel receive buffer.
     bool conflate_;                        ///< Conflate option.
     std::list<std::string> subscriptions_; ///< List of subscriptions.
     std::list<std::string> groups_;        ///< List of groups.
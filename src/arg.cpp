@@ -28,6 +28,18 @@ Arg::Val::Val(int v) noexcept
 }
 
 
+Arg::Val::Val(int64_t v) noexcept
+    : i64_(v)
+{
+}
+
+
+Arg::Val::Val(uint64_t v) noexcept
+    : u64_(v)
+{
+}
+
+
 Arg::Val::Val(double v) noexcept
     : dbl_(v)
 {
@@ -67,6 +79,18 @@ Arg::Arg(int val) noexcept
 }
 
 
+Arg::Arg(int64_t val) noexcept
+    : Arg(std::string_view(), val)
+{
+}
+
+
+Arg::Arg(uint64_t val) noexcept
+    : Arg(std::string_view(), val)
+{
+}
+
+
 Arg::Arg(ec_t val) noexcept
     : Arg(std::string_view(), val)
 {
@@ -106,6 +130,24 @@ Arg::Arg(std::string_view key, int val) noexcept
 }
 
 
+Arg::Arg(std::string_view key, int64_t val) noexcept
+    : type_(Type::Int64)
+    , alloc_(Alloc::None)
+    , key_(key)
+    , val_(val)
+{
+}
+
+
+Arg::Arg(std::string_view key, uint64_t val) noexcept
+    : type_(Type::UInt64)
+    , alloc_(Alloc::None)
+    , key_(key)
+    , val_(val)
+{
+}
+
+
 Arg::Arg(std::string_view key, ec_t val) noexcept
     : type_(Type::Errno)
     , alloc_(Alloc::None)
@@ -210,12 +252,29 @@ void Arg::refAcquire() noexcept
 }
 
 
+namespace {
+/**
+ * \brief Decrements a reference count.
+ *
+ * When this is the last reference, no other owner can
+ * concurrently change the count, so the atomic decrement is skipped.
+ *
+ * \return Whether the data shall be released.
+ */
+inline bool refDecrement(std::atomic<size_t>& cnt) noexcept
+{
+    return cnt.load(std::memory_order_acquire) == 1 ||
+        cnt.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+} // namespace
+
+
 void Arg::refRelease() noexcept
 {
     if (alloc_ == Alloc::Heap) {
-        if (type_ == Type::String && --val_.str_->cnt_ == 0)
+        if (type_ == Type::String && refDecrement(val_.str_->cnt_))
             delete val_.str_;
-        else if (type_ == Type::Array && --val_.arr_->cnt_ == 0)
+        else if (type_ == Type::Array && refDecrement(val_.arr_->cnt_))
             delete val_.arr_;
     }
 }
@@ -245,6 +304,8 @@ size_t Arg::count() const noexcept
         return 0;
 
     case Type::Int:
+    case Type::Int64:
+    case Type::UInt64:
     case Type::Errno:
     case Type::Double:
     case Type::String:
@@ -263,6 +324,8 @@ size_t Arg::refCount() const noexcept
     switch (type_) {
     case Type::Invalid:
     case Type::Int:
+    case Type::Int64:
+    case Type::UInt64:
     case Type::Errno:
     case Type::Double:
         return 0;
@@ -302,6 +365,38 @@ int Arg::toInt() const noexcept
 }
 
 
+int64_t Arg::toInt64() const noexcept
+{
+    switch (type_) {
+    case Type::Int:
+    case Type::Errno:
+        return val_.int_;
+    case Type::Int64:
+        return val_.i64_;
+    case Type::UInt64:
+        return int64_t(val_.u64_);
+    default:
+        return 0;
+    }
+}
+
+
+uint64_t Arg::toUInt64() const noexcept
+{
+    switch (type_) {
+    case Type::Int:
+    case Type::Errno:
+        return uint64_t(val_.int_);
+    case Type::Int64:
+        return uint64_t(val_.i64_);
+    case Type::UInt64:
+        return val_.u64_;
+    default:
+        return 0;
+    }
+}
+
+
 double Arg::toDouble() const noexcept
 {
     if (type_ != Type::Double)
@@ -350,6 +445,12 @@ std::ostream& operator<<(std::ostream& os, const Arg::Type& type)
     case Arg::Type::Int:
         os << "int"sv;
         break;
+    case Arg::Type::Int64:
+        os << "int64"sv;
+        break;
+    case Arg::Type::UInt64:
+        os << "uint64"sv;
+        break;
     case Arg::Type::Errno:
         os << "errno"sv;
         break;
@@ -17,6 +17,12 @@ namespace fuurin {
 
 Broker::Broker(Uuid id, const std::string& name)
     : Runner(id, name)
+    , metrics_{std::make_unique<BrokerMetrics>()}
+    , storCompact_{std::chrono::seconds(10)}
+    , storFlush_{std::chrono::milliseconds(100)}
+    , storTopics_{1024}
+    , storVersions_{8}
+    , storWorkers_{64}
 {
 }
 
@@ -26,6 +32,73 @@ Broker::~Broker() noexcept
 }
 
 
+void Broker::setPeerEndpoints(const std::vector<std::string>& dispatch,
+    const std::vector<std::string>& snapshot)
+{
+    peerDispatch_ = dispatch;
+    peerSnapshot_ = snapshot;
+}
+
+
+const std::vector<std::string>& Broker::peerEndpointDispatch() const
+{
+    return peerDispatch_;
+}
+
+
+const std::vector<std::string>& Broker::peerEndpointSnapshot() const
+{
+    return peerSnapshot_;
+}
+
+
+void Broker::setStorageFile(const std::string& path, std::chrono::milliseconds compaction,
+    std::chrono::milliseconds flush)
+{
+    storFile_ = path;
+    storCompact_ = compaction;
+    storFlush_ = flush;
+}
+
+
+const std::string& Broker::storageFile() const
+{
+    return storFile_;
+}
+
+
+std::chrono::milliseconds Broker::storageCompaction() const
+{
+    return storCompact_;
+}
+
+
+std::chrono::milliseconds Broker::storageFlush() const
+{
+    return storFlush_;
+}
+
+
+void Broker::setStorageCapacity(size_t topics, size_t versions, size_t workers)
+{
+    storTopics_ = topics;
+    storVersions_ = versions;
+    storWorkers_ = workers;
+}
+
+
+std::tuple<size_t, size_t, size_t> Broker::storageCapacity() const
+{
+    return {storTopics_, storVersions_, storWorkers_};
+}
+
+
+BrokerStats Broker::stats() const
+{
+    return metrics_->stats();
+}
+
+
 zmq::Part Broker::prepareConfiguration() const
 {
     return BrokerConfig{
@@ -33,6 +106,16 @@ zmq::Part Broker::prepareConfiguration() const
         endpointDelivery(),
         endpointDispatch(),
         endpointSnapshot(),
+        peerDispatch_,
+        peerSnapshot_,
+        storFile_,
+        storCompact_,
+        storFlush_,
+        std::get<0>(highWaterMark()),
+        std::get<1>(highWaterMark()),
+        std::get<0>(bufferSize()),
+        std::get<1>(bufferSize()),
+        drainBatch(),
     }
         .toPart();
 }
@@ -40,7 +123,7 @@ zmq::Part Broker::prepareConfiguration() const
 
 std::unique_ptr<Session> Broker::createSession() const
 {
-    return makeSession<BrokerSession>();
+    return makeSession<BrokerSession>(metrics_.get(), storTopics_, storVersions_, storWorkers_);
 }
 
 
@@ -23,7 +23,17 @@ bool BrokerConfig::operator==(const BrokerConfig& rhs) const
     return uuid == rhs.uuid &&
         endpDelivery == rhs.endpDelivery &&
         endpDispatch == rhs.endpDispatch &&
-        endpSnapshot == rhs.endpSnapshot;
+        endpSnapshot == rhs.endpSnapshot &&
+        endpPeerDispatch == rhs.endpPeerDispatch &&
+        endpPeerSnapshot == rhs.endpPeerSnapshot &&
+        storageFile == rhs.storageFile &&
+        storageCompaction == rhs.storageCompaction &&
+        storageFlush == rhs.storageFlush &&
+        hwmSend == rhs.hwmSend &&
+        hwmRecv == rhs.hwmRecv &&
+        bufSend == rhs.bufSend &&
+        bufRecv == rhs.bufRecv &&
+        drainBatch == rhs.drainBatch;
 }
 
 
@@ -37,17 +47,38 @@ BrokerConfig BrokerConfig::fromPart(const zmq::Part& part)
 {
     BrokerConfig cc;
 
-    const auto [uuid, endp1, endp2, endp3] = zmq::PartMulti::unpack<
+    const auto [uuid, endp1, endp2, endp3, peer1, peer2, storFile, storCompact, storFlush,
+        hwmSnd, hwmRcv, bufSnd, bufRcv, drain] = zmq::PartMulti::unpack<
         Uuid::Bytes,
         zmq::Part,
         zmq::Part,
-        zmq::Part>(part);
+        zmq::Part,
+        zmq::Part,
+        zmq::Part,
+        std::string_view,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        uint32_t>(part);
 
     cc.uuid = Uuid::fromBytes(uuid);
+    cc.storageFile = storFile;
+    cc.storageCompaction = std::chrono::milliseconds(storCompact);
+    cc.storageFlush = std::chrono::milliseconds(storFlush);
+    cc.hwmSend = int(hwmSnd);
+    cc.hwmRecv = int(hwmRcv);
+    cc.bufSend = int(bufSnd);
+    cc.bufRecv = int(bufRcv);
+    cc.drainBatch = int(drain);
 
     zmq::PartMulti::unpack(endp1, std::inserter(cc.endpDelivery, cc.endpDelivery.begin()));
     zmq::PartMulti::unpack(endp2, std::inserter(cc.endpDispatch, cc.endpDispatch.begin()));
     zmq::PartMulti::unpack(endp3, std::inserter(cc.endpSnapshot, cc.endpSnapshot.begin()));
+    zmq::PartMulti::unpack(peer1, std::inserter(cc.endpPeerDispatch, cc.endpPeerDispatch.begin()));
+    zmq::PartMulti::unpack(peer2, std::inserter(cc.endpPeerSnapshot, cc.endpPeerSnapshot.begin()));
 
     return cc;
 }
@@ -58,7 +89,17 @@ zmq::Part BrokerConfig::toPart() const
     return zmq::PartMulti::pack(uuid.bytes(),
         zmq::PartMulti::pack(endpDelivery.begin(), endpDelivery.end()),
         zmq::PartMulti::pack(endpDispatch.begin(), endpDispatch.end()),
-        zmq::PartMulti::pack(endpSnapshot.begin(), endpSnapshot.end()));
+        zmq::PartMulti::pack(endpSnapshot.begin(), endpSnapshot.end()),
+        zmq::PartMulti::pack(endpPeerDispatch.begin(), endpPeerDispatch.end()),
+        zmq::PartMulti::pack(endpPeerSnapshot.begin(), endpPeerSnapshot.end()),
+        std::string_view(storageFile),
+        uint32_t(storageCompaction.count()),
+        uint32_t(storageFlush.count()),
+        uint32_t(hwmSend),
+        uint32_t(hwmRecv),
+        uint32_t(bufSend),
+        uint32_t(bufRecv),
+        uint32_t(drainBatch));
 }
 
 
@@ -80,7 +121,14 @@ std::ostream& operator<<(std::ostream& os, const BrokerConfig& cc)
     os << cc.uuid << ", ";
     putList(cc.endpDelivery) << ", ";
     putList(cc.endpDispatch) << ", ";
-    putList(cc.endpSnapshot);
+    putList(cc.endpSnapshot) << ", ";
+    putList(cc.endpPeerDispatch) << ", ";
+    putList(cc.endpPeerSnapshot) << ", ";
+    os << cc.storageFile << ", ";
+    os << cc.storageCompaction.count() << "/" << cc.storageFlush.count() << ", ";
+    os << cc.hwmSend << "/" << cc.hwmRecv << ", ";
+    os << cc.bufSend << "/" << cc.bufRecv << ", ";
+    os << cc.drainBatch;
     os << "]";
 
     return os;
@@ -132,3 +132,9 @@ bool CBroker_isRunning(CBroker* b)
 {
     return c::getPrivD(b)->b->isRunning();
 }
+
+
+CBrokerStats CBroker_stats(CBroker* b)
+{
+    return c::statsConvert(c::getPrivD(b)->b->stats());
+}
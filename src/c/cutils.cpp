@@ -41,6 +41,61 @@ Uuid uuidConvert(const CUuid& id)
 }
 
 
+CLatency statsConvert(const Histogram::Snapshot& s)
+{
+    return CLatency{
+        s.count,
+        s.mean(),
+        s.percentile(0.5),
+        s.percentile(0.99),
+        s.percentile(0.999),
+        s.max,
+    };
+}
+
+
+CWorkerStats statsConvert(const WorkerStats& s)
+{
+    return CWorkerStats{
+        s.dispatched,
+        s.delivered,
+        s.discarded,
+        s.syncElements,
+        s.syncRetries,
+        s.connTransitions,
+        s.conflated,
+        s.dispatchBlocked,
+        s.dispatchDropped,
+        s.handlerOverruns,
+        statsConvert(s.deliveryLatency),
+        statsConvert(s.syncLatency),
+        statsConvert(s.keepaliveLatency),
+        statsConvert(s.handlerLatency),
+        s.brokerWorkers,
+        s.brokerLoad,
+        s.brokerTopics,
+    };
+}
+
+
+CBrokerStats statsConvert(const BrokerStats& s)
+{
+    return CBrokerStats{
+        s.received,
+        s.dispatched,
+        s.discarded,
+        s.syncRequests,
+        s.syncElements,
+        s.syncAborts,
+        s.dropped,
+        s.peerReceived,
+        s.storageErrors,
+        statsConvert(s.dispatchLatency),
+        statsConvert(s.syncLatency),
+    };
+}
+
+
 void logError(std::string_view err) noexcept
 {
     log::Arg args[] = {log::Arg{"error"sv, err}};
@@ -13,7 +13,9 @@
 
 #include "fuurin/errors.h"
 #include "fuurin/uuid.h"
+#include "fuurin/stats.h"
 #include "fuurin/c/cuuid.h"
+#include "fuurin/c/cstats.h"
 
 #include <string_view>
 #include <type_traits>
@@ -38,6 +40,18 @@ CUuid uuidConvert(const Uuid& id);
 Uuid uuidConvert(const CUuid& id);
 
 
+/**
+ * \brief Converts statistics from C++ to C.
+ * \param[in] s C++ statistics.
+ * \return C statistics.
+ */
+///@{
+CLatency statsConvert(const Histogram::Snapshot& s);
+CWorkerStats statsConvert(const WorkerStats& s);
+CBrokerStats statsConvert(const BrokerStats& s);
+///@}
+
+
 /**
  * \brief Logs an error.
  *
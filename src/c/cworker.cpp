@@ -305,3 +305,9 @@ int CWorker_eventFD(CWorker* w)
             return int{};
         });
 }
+
+
+CWorkerStats CWorker_stats(CWorker* w)
+{
+    return c::statsConvert(c::getPrivD(w)->w->stats());
+}
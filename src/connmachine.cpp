@@ -14,6 +14,9 @@
 #include "fuurin/errors.h"
 #include "log.h"
 
+#include <algorithm>
+#include <utility>
+
 
 namespace fuurin {
 
@@ -29,6 +32,11 @@ ConnMachine::ConnMachine(std::string_view name, Uuid uuid, zmq::Context* zctx,
     , timerTry_{std::make_unique<zmq::Timer>(zctx, log::format("%s_conn_tmr_retry", name.data()))}
     , timerTmo_{std::make_unique<zmq::Timer>(zctx, log::format("%s_conn_tmr_timeout", name.data()))}
     , state_{State::Halted}
+    , timeoutMax_{timeout}
+    , keepalive_{0}
+    , rttSmooth_{0}
+    , rttVar_{0}
+    , isDataSent_{false}
 {
     timerTry_->setSingleShot(false);
     timerTmo_->setSingleShot(true);
@@ -72,6 +80,33 @@ zmq::Timer* ConnMachine::timerTimeout() const noexcept
 }
 
 
+void ConnMachine::setIntervals(std::chrono::milliseconds retry, std::chrono::milliseconds timeout)
+{
+    timeoutMax_ = timeout;
+    timerTry_->setInterval(retry);
+    adaptTimeout();
+}
+
+
+void ConnMachine::setKeepalive(std::chrono::milliseconds keepalive)
+{
+    keepalive_ = keepalive;
+    adaptTimeout();
+}
+
+
+std::chrono::nanoseconds ConnMachine::roundTrip() const noexcept
+{
+    return rttSmooth_;
+}
+
+
+std::chrono::milliseconds ConnMachine::timeout() const noexcept
+{
+    return timerTmo_->interval();
+}
+
+
 void ConnMachine::onStart()
 {
     if (state_ != State::Halted)
@@ -104,14 +139,63 @@ void ConnMachine::onPing()
     timerTry_->stop();
     timerTmo_->start();
 
+    const bool isStable = state_ == State::Stable;
     change(State::Stable);
 
+    // data already acts as a keepalive.
+    if (isStable && std::exchange(isDataSent_, false))
+        return;
+
     LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"action"sv, "pong"sv});
 
     doPong_();
 }
 
 
+void ConnMachine::onData()
+{
+    if (state_ != State::Stable)
+        return;
+
+    timerTmo_->start();
+}
+
+
+void ConnMachine::onDataSent()
+{
+    isDataSent_ = true;
+}
+
+
+void ConnMachine::onRoundTrip(std::chrono::nanoseconds rtt)
+{
+    if (rttSmooth_ == std::chrono::nanoseconds::zero()) {
+        rttSmooth_ = rtt;
+        rttVar_ = rtt / 2;
+    } else {
+        const auto delta = rttSmooth_ > rtt ? rttSmooth_ - rtt : rtt - rttSmooth_;
+        rttVar_ = (3 * rttVar_ + delta) / 4;
+        rttSmooth_ = (7 * rttSmooth_ + rtt) / 8;
+    }
+
+    adaptTimeout();
+}
+
+
+void ConnMachine::adaptTimeout()
+{
+    if (keepalive_ == std::chrono::milliseconds::zero() || rttSmooth_ == std::chrono::nanoseconds::zero()) {
+        timerTmo_->setInterval(timeoutMax_);
+        return;
+    }
+
+    const auto rto = std::max<std::chrono::nanoseconds>(RtoMin, rttSmooth_ + 4 * rttVar_);
+    const auto tmo = std::chrono::ceil<std::chrono::milliseconds>(keepalive_ + rto);
+
+    timerTmo_->setInterval(std::min(tmo, timeoutMax_));
+}
+
+
 void ConnMachine::onTimerRetryFired()
 {
     if (timerTry_->isExpired())
@@ -160,6 +244,11 @@ void ConnMachine::halt()
     timerTry_->stop();
     timerTmo_->stop();
 
+    isDataSent_ = false;
+    rttSmooth_ = std::chrono::nanoseconds::zero();
+    rttVar_ = std::chrono::nanoseconds::zero();
+    adaptTimeout();
+
     doClose_();
     change(State::Halted);
 }
@@ -44,8 +44,15 @@ class Timer;
  *   - \ref State::Stable.
  *      Replies are sent through \ref doPong_ function, upon request
  *      only, using \ref onPing() method and \ref timerTmo_ is restarted.
- *      A transition back to \ref State::Trying is performed if \ref timerTmo_
- *      expires.
+ *      A reply is skipped when data was sent since the last request,
+ *      see \ref onDataSent(), and data received restarts \ref timerTmo_ too,
+ *      see \ref onData(). A transition back to \ref State::Trying is
+ *      performed if \ref timerTmo_ expires.
+ *
+ * The timeout can be adapted to the measured round trip time, see
+ * \ref setKeepalive(std::chrono::milliseconds). In this case it's the expected
+ * interval of keepalives plus a retransmission timeout, which is estimated
+ * like in TCP (RFC 6298), using a smoothed round trip time and its variation.
  */
 class ConnMachine
 {
@@ -139,6 +146,38 @@ public:
      */
     zmq::Timer* timerTimeout() const noexcept;
 
+    /**
+     * \brief Sets the intervals of timers.
+     *
+     * The new intervals are applied the next time the timers are started.
+     *
+     * \param[in] retry Interval (in ms) for retry attempts.
+     * \param[in] timeout Timeout (in ms) for the connection,
+     *      it's the maximum value when timeout is adaptive.
+     */
+    void setIntervals(std::chrono::milliseconds retry, std::chrono::milliseconds timeout);
+
+    /**
+     * \brief Sets the expected interval of keepalives from the remote party.
+     *
+     * When not zero, the timeout is adapted to the measured round trip time,
+     * once the first sample was notified with \ref onRoundTrip(std::chrono::nanoseconds).
+     * By default it's zero, i.e. the timeout is fixed.
+     *
+     * \param[in] keepalive Interval (in ms) of keepalives.
+     */
+    void setKeepalive(std::chrono::milliseconds keepalive);
+
+    /**
+     * \return The smoothed round trip time, or zero if not yet measured.
+     */
+    std::chrono::nanoseconds roundTrip() const noexcept;
+
+    /**
+     * \return The current interval of \ref timerTimeout().
+     */
+    std::chrono::milliseconds timeout() const noexcept;
+
     /**
      * \brief Notifies that the connection shall be started.
      */
@@ -160,6 +199,36 @@ public:
      */
     void onPing();
 
+    /**
+     * \brief Notifies that data was received from remote party.
+     *
+     * When in \ref State::Stable, data counts as a keepalive,
+     * so \ref timerTimeout() is restarted.
+     */
+    void onData();
+
+    /**
+     * \brief Notifies that data was sent to remote party.
+     *
+     * Data counts as a keepalive, so the next reply
+     * sent by \ref onPing() is skipped.
+     */
+    void onDataSent();
+
+    /**
+     * \brief Notifies a sample of round trip time.
+     *
+     * The smoothed round trip time and its variation are updated.
+     * When timeout is adaptive, the interval of \ref timerTimeout() is
+     * changed and it's applied the next time the timer is started.
+     * Estimates are reset when the connection is halted.
+     *
+     * \param[in] rtt Round trip time.
+     *
+     * \see setKeepalive(std::chrono::milliseconds)
+     */
+    void onRoundTrip(std::chrono::nanoseconds rtt);
+
     /**
      * \brief Notifies \ref timerRetry() has fired.
      *
@@ -191,6 +260,13 @@ private:
      */
     void trigger();
 
+    /**
+     * \brief Updates the interval of \ref timerTmo_.
+     *
+     * \see setKeepalive(std::chrono::milliseconds)
+     */
+    void adaptTimeout();
+
     /**
      * \brief Halts the state machine.
      *
@@ -220,7 +296,15 @@ private:
     const std::unique_ptr<zmq::Timer> timerTry_; ///< Timer for announcements.
     const std::unique_ptr<zmq::Timer> timerTmo_; ///< Timer for connection timeout.
 
-    State state_; ///< Connection state.
+    /// Minimum retransmission timeout.
+    static constexpr std::chrono::milliseconds RtoMin{200};
+
+    State state_;                          ///< Connection state.
+    std::chrono::milliseconds timeoutMax_; ///< Maximum (or fixed) timeout.
+    std::chrono::milliseconds keepalive_;  ///< Expected interval of keepalives.
+    std::chrono::nanoseconds rttSmooth_;   ///< Smoothed round trip time.
+    std::chrono::nanoseconds rttVar_;      ///< Round trip time variation.
+    bool isDataSent_;                      ///< Whether data was sent since the last ping.
 };
 
 
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "deliveryconflater.h"
+
+
+namespace fuurin {
+
+
+DeliveryConflater::DeliveryConflater() = default;
+
+
+DeliveryConflater::~DeliveryConflater() noexcept = default;
+
+
+bool DeliveryConflater::put(SessionEnv::token_t token, const Topic::Name& name, zmq::Part&& payload)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (const auto it = pending_.find(name); it != pending_.list().end()) {
+        auto& [tok, pay] = it->second;
+        pay = std::move(payload);
+
+        // a stale notification won't take it, so notify again.
+        return std::exchange(tok, token) != token;
+    }
+
+    pending_.emplace(name, token, std::move(payload));
+    return true;
+}
+
+
+std::optional<zmq::Part> DeliveryConflater::take(SessionEnv::token_t token, std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    const auto it = pending_.find(name);
+    if (it == pending_.list().end() || it->second.first != token)
+        return {};
+
+    return {std::move(pending_.get(name)->second.second)};
+}
+
+} // namespace fuurin
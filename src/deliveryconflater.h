@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef DELIVERYCONFLATER_H
+#define DELIVERYCONFLATER_H
+
+#include "fuurin/topic.h"
+#include "fuurin/lrucache.h"
+#include "fuurin/sessionenv.h"
+#include "fuurin/zmqpart.h"
+
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+
+namespace fuurin {
+
+/**
+ * \brief Pending deliveries, conflated by topic name.
+ *
+ * The worker session puts a delivery, and notifies the main thread only
+ * when no delivery of the same name is already pending. Otherwise the
+ * pending delivery is replaced in place, so at most one delivery per name
+ * is queued, whatever is the rate of the reader. The main thread takes
+ * the pending delivery upon the notification.
+ *
+ * Deliveries are tagged with the session token, so a delivery put by
+ * a newer session is never taken by a stale notification.
+ */
+class DeliveryConflater
+{
+public:
+    /**
+     * \brief Initializes an empty set of deliveries.
+     */
+    DeliveryConflater();
+
+    /**
+     * \brief Destructor.
+     */
+    ~DeliveryConflater() noexcept;
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    DeliveryConflater(const DeliveryConflater&) = delete;
+    DeliveryConflater& operator=(const DeliveryConflater&) = delete;
+    ///@}
+
+    /**
+     * \brief Puts the latest delivery of a topic.
+     *
+     * \param[in] token Token of the session.
+     * \param[in] name Topic name.
+     * \param[in] payload Packed topic.
+     *
+     * \return \c true when a notification shall be sent,
+     *      \c false when a pending delivery was replaced.
+     */
+    bool put(SessionEnv::token_t token, const Topic::Name& name, zmq::Part&& payload);
+
+    /**
+     * \brief Takes the pending delivery of a topic.
+     *
+     * \param[in] token Token of the notification.
+     * \param[in] name Topic name.
+     *
+     * \return The packed topic, if pending for the same token.
+     */
+    std::optional<zmq::Part> take(SessionEnv::token_t token, std::string_view name);
+
+
+private:
+    std::mutex mtx_; ///< Lock for pending deliveries.
+
+    ///< Pending deliveries, with the token of the session which put them.
+    LRUCache<Topic::Name, std::pair<SessionEnv::token_t, zmq::Part>> pending_;
+};
+
+} // namespace fuurin
+
+#endif // DELIVERYCONFLATER_H
@@ -48,15 +48,37 @@ BOOST_PP_SEQ_FOR_EACH(LOG_LEVEL, _, (debug)(info)(warn)(error)(fatal))
 } // namespace fuurin
 
 
-#ifndef NDEBUG
-#define LOG_DEBUG(...) fuurin::log::debug({__FILE__, __LINE__}, __VA_ARGS__)
+/**
+ * \brief Logs a message, if its level is enabled.
+ *
+ * Arguments are not evaluated when the level is disabled.
+ *
+ * \see Logger::isEnabled(Level)
+ */
+#define LOG_LEVEL_IF(lvl, fn, ...) \
+    do { \
+        if (fuurin::log::Logger::isEnabled(fuurin::log::Level::lvl)) \
+            fuurin::log::fn({__FILE__, __LINE__}, __VA_ARGS__); \
+    } while (0)
+
+#if !defined(NDEBUG) && !defined(LOG_DISABLE_DEBUG_INFO)
+#define LOG_DEBUG(...) LOG_LEVEL_IF(Debug, debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) \
+    do { \
+    } while (0)
+#endif
+
+#if !defined(LOG_DISABLE_DEBUG_INFO)
+#define LOG_INFO(...) LOG_LEVEL_IF(Info, info, __VA_ARGS__)
 #else
-#define LOG_DEBUG(...)
+#define LOG_INFO(...) \
+    do { \
+    } while (0)
 #endif
 
-#define LOG_INFO(...) fuurin::log::info({__FILE__, __LINE__}, __VA_ARGS__)
-#define LOG_WARN(...) fuurin::log::warn({__FILE__, __LINE__}, __VA_ARGS__)
-#define LOG_ERROR(...) fuurin::log::error({__FILE__, __LINE__}, __VA_ARGS__)
+#define LOG_WARN(...) LOG_LEVEL_IF(Warn, warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_LEVEL_IF(Error, error, __VA_ARGS__)
 #define LOG_FATAL(...) fuurin::log::fatal({__FILE__, __LINE__}, __VA_ARGS__)
 
 #endif // LOG_H
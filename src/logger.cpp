@@ -71,6 +71,12 @@ std::ostream& operator<<(std::ostream& os, const Arg& arg)
     case Arg::Type::Int:
         printarg(os, arg.key(), arg.toInt());
         break;
+    case Arg::Type::Int64:
+        printarg(os, arg.key(), arg.toInt64());
+        break;
+    case Arg::Type::UInt64:
+        printarg(os, arg.key(), arg.toUInt64());
+        break;
     case Arg::Type::Double:
         printarg(os, arg.key(), arg.toDouble());
         break;
@@ -166,6 +172,7 @@ void SilentHandler::fatal(const Loc&, const Arg args[], size_t num) const
  */
 
 std::unique_ptr<Handler> Logger::handler_(new StandardHandler);
+std::atomic<Level> Logger::level_(Level::Debug);
 
 void Logger::installContentHandler(Handler* handler)
 {
@@ -175,6 +182,18 @@ void Logger::installContentHandler(Handler* handler)
 }
 
 
+void Logger::setLevel(Level lvl) noexcept
+{
+    level_.store(lvl, std::memory_order_relaxed);
+}
+
+
+Level Logger::level() noexcept
+{
+    return level_.load(std::memory_order_relaxed);
+}
+
+
 #define LOGGER_LEVEL(r, data, level) \
     void Logger::level(const Loc& loc, const Arg args[], size_t num) noexcept \
     { \
@@ -0,0 +1,610 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "fuurin/logger.h"
+#include "failure.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+
+
+namespace fuurin {
+namespace log {
+
+namespace {
+/// Size of a cache line, to avoid false sharing.
+constexpr size_t CacheLine = 64;
+
+/// Size of the header of a ring buffer entry.
+constexpr size_t EntryHeader = sizeof(uint32_t);
+
+/// Marker of a ring buffer entry which wraps around.
+constexpr uint32_t EntryWrap = std::numeric_limits<uint32_t>::max();
+
+
+/// Rounds up to the ring buffer entry alignment.
+constexpr size_t alignEntry(size_t v)
+{
+    return (v + 7) & ~size_t(7);
+}
+
+
+/// Rounds up to the next power of two.
+size_t roundPow2(size_t v)
+{
+    size_t ret = 64;
+    while (ret < v)
+        ret <<= 1;
+    return ret;
+}
+
+
+/**
+ * \brief Single producer single consumer ring buffer of variable sized entries.
+ *
+ * Every entry is contiguous in memory, when it doesn't fit
+ * at the end of the buffer, then a wrap marker is written and
+ * the entry is stored from the beginning.
+ */
+class Ring
+{
+public:
+    explicit Ring(size_t capacity)
+        : cap_{roundPow2(capacity)}
+        , buf_{new char[cap_]}
+    {
+    }
+
+    /**
+     * \brief Pushes an entry, called by the producer thread only.
+     * \return Whether there was room for the entry.
+     */
+    bool push(const char* data, size_t len) noexcept
+    {
+        const size_t need = alignEntry(EntryHeader + len);
+        if (need > cap_)
+            return false;
+
+        size_t h = head_.load(std::memory_order_relaxed);
+        const size_t t = tail_.load(std::memory_order_acquire);
+
+        const size_t pos = h & (cap_ - 1);
+        const size_t room = cap_ - pos;
+        const size_t total = need <= room ? need : room + need;
+
+        if (cap_ - (h - t) < total)
+            return false;
+
+        size_t at = pos;
+        if (need > room) {
+            std::memcpy(buf_.get() + pos, &EntryWrap, sizeof(EntryWrap));
+            h += room;
+            at = 0;
+        }
+
+        const uint32_t sz = uint32_t(len);
+        std::memcpy(buf_.get() + at, &sz, sizeof(sz));
+        std::memcpy(buf_.get() + at + EntryHeader, data, len);
+
+        head_.store(h + need, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * \brief Pops an entry, called by the consumer thread only.
+     * \param[in] f Function called with the entry data and size.
+     * \return Whether an entry was available.
+     */
+    template<typename F>
+    bool pop(F&& f)
+    {
+        size_t t = tail_.load(std::memory_order_relaxed);
+        if (t == head_.load(std::memory_order_acquire))
+            return false;
+
+        size_t pos = t & (cap_ - 1);
+        uint32_t sz;
+        std::memcpy(&sz, buf_.get() + pos, sizeof(sz));
+
+        if (sz == EntryWrap) {
+            t += cap_ - pos;
+            pos = 0;
+            std::memcpy(&sz, buf_.get(), sizeof(sz));
+        }
+
+        f(buf_.get() + pos + EntryHeader, size_t(sz));
+
+        tail_.store(t + alignEntry(EntryHeader + sz), std::memory_order_release);
+        return true;
+    }
+
+    /// \return Position of the producer.
+    size_t head() const noexcept
+    {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    /// \return Position of the consumer.
+    size_t tail() const noexcept
+    {
+        return tail_.load(std::memory_order_acquire);
+    }
+
+
+public:
+    alignas(CacheLine) std::atomic<size_t> dropped_{0}; ///< Dropped records.
+    std::atomic<bool> released_{false};                 ///< Whether the producer thread exited.
+
+
+private:
+    const size_t cap_;                 ///< Capacity of the buffer.
+    const std::unique_ptr<char[]> buf_; ///< Buffer.
+
+    alignas(CacheLine) std::atomic<size_t> head_{0}; ///< Producer position.
+    alignas(CacheLine) std::atomic<size_t> tail_{0}; ///< Consumer position.
+};
+
+
+/**
+ * \brief Binary encoding of log records.
+ *
+ * Record: file pointer, line, level, number of arguments, arguments.
+ * Argument: type, key size, key, value.
+ * Value: int32 for Int and Errno, int64 for Int64 and UInt64, double for Double,
+ *   size and chars for String, number and arguments for Array.
+ */
+template<typename T>
+inline void put(std::vector<char>& buf, T v)
+{
+    const auto sz = buf.size();
+    buf.resize(sz + sizeof(T));
+    std::memcpy(buf.data() + sz, &v, sizeof(T));
+}
+
+
+inline void putString(std::vector<char>& buf, std::string_view s)
+{
+    put(buf, uint32_t(s.size()));
+    buf.insert(buf.end(), s.begin(), s.end());
+}
+
+
+void putArg(std::vector<char>& buf, const Arg& a)
+{
+    put(buf, a.type());
+    putString(buf, a.key());
+
+    switch (a.type()) {
+    case Arg::Type::Invalid:
+        break;
+    case Arg::Type::Int:
+    case Arg::Type::Errno:
+        put(buf, int32_t(a.toInt()));
+        break;
+    case Arg::Type::Int64:
+        put(buf, a.toInt64());
+        break;
+    case Arg::Type::UInt64:
+        put(buf, a.toUInt64());
+        break;
+    case Arg::Type::Double:
+        put(buf, a.toDouble());
+        break;
+    case Arg::Type::String:
+        putString(buf, a.toString());
+        break;
+    case Arg::Type::Array:
+        put(buf, uint32_t(a.count()));
+        for (size_t i = 0; i < a.count(); ++i)
+            putArg(buf, a.toArray()[i]);
+        break;
+    }
+}
+
+
+template<typename T>
+inline T get(const char*& p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+
+inline std::string_view getString(const char*& p)
+{
+    const auto sz = get<uint32_t>(p);
+    const std::string_view ret{p, sz};
+    p += sz;
+    return ret;
+}
+
+
+/// Generator of handlers identifiers.
+std::atomic<uint64_t> handlerId{0};
+
+/**
+ * \brief Rings of the calling thread, for every handler identifier.
+ *
+ * Rings are released upon thread exit, so they can be reused by other threads.
+ */
+struct ThreadRings
+{
+    ~ThreadRings() noexcept
+    {
+        for (const auto& el : list)
+            el.second->released_.store(true, std::memory_order_release);
+    }
+
+    std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> list; ///< Rings by handler identifier.
+};
+
+/// Rings of the calling thread.
+thread_local ThreadRings tlsRings;
+
+/// Scratch buffer for encoding.
+thread_local std::vector<char> tlsBuffer;
+} // namespace
+
+
+struct AsyncHandler::Impl
+{
+    Impl(Handler* sink, Overflow policy, size_t capacity)
+        : id_{handlerId.fetch_add(1, std::memory_order_relaxed)}
+        , sink_{sink != nullptr ? sink : new StandardHandler}
+        , policy_{policy}
+        , capacity_{capacity}
+        , written_{0}
+        , pending_{false}
+        , stop_{false}
+    {
+    }
+
+    /**
+     * \brief Returns the ring buffer of the calling thread.
+     *
+     * A ring released by an exited thread is reused, if any,
+     * so the number of rings is bounded by the number of
+     * threads which are logging at the same time.
+     *
+     * \return The ring buffer of the calling thread.
+     */
+    Ring* ring()
+    {
+        for (const auto& [owner, r] : tlsRings.list) {
+            if (owner == id_)
+                return r.get();
+        }
+
+        std::lock_guard<std::mutex> lk(mutex_);
+
+        for (const auto& r : rings_) {
+            // the previous producer has exited, so it won't push anymore.
+            if (r->released_.load(std::memory_order_acquire)) {
+                r->released_.store(false, std::memory_order_relaxed);
+                tlsRings.list.emplace_back(id_, r);
+                return r.get();
+            }
+        }
+
+        rings_.emplace_back(std::make_shared<Ring>(capacity_));
+        tlsRings.list.emplace_back(id_, rings_.back());
+        return rings_.back().get();
+    }
+
+    /**
+     * \brief Wakes up the background thread, unless already pending.
+     */
+    void wakeUp()
+    {
+        // pairs with the fence of the background thread, so either the pushed
+        // record is seen by the thread, or the flag is seen as cleared.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pending_.load(std::memory_order_relaxed))
+            return;
+
+        if (pending_.exchange(true, std::memory_order_acq_rel))
+            return;
+
+        std::lock_guard<std::mutex> lk(mutex_);
+        cond_.notify_one();
+    }
+
+    /**
+     * \brief Encodes and pushes a record.
+     */
+    void push(Level lvl, const Loc& loc, const Arg args[], size_t num)
+    {
+        auto& buf = tlsBuffer;
+        buf.clear();
+
+        put(buf, loc.file);
+        put(buf, loc.line);
+        put(buf, lvl);
+        put(buf, uint32_t(num));
+        for (size_t i = 0; i < num; ++i)
+            putArg(buf, args[i]);
+
+        Ring* const r = ring();
+
+        while (!r->push(buf.data(), buf.size())) {
+            if (policy_ == Overflow::Drop || stop_.load(std::memory_order_relaxed)) {
+                r->dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wakeUp();
+            std::this_thread::yield();
+        }
+
+        wakeUp();
+    }
+
+    /**
+     * \brief Decodes a record and passes it to the sink.
+     */
+    void write(const char* p, size_t)
+    {
+        const char* file = get<const char*>(p);
+        const auto line = get<unsigned int>(p);
+        const auto lvl = get<Level>(p);
+        const auto num = get<uint32_t>(p);
+
+        auto& args = args_;
+        args.clear();
+        for (uint32_t i = 0; i < num; ++i)
+            args.push_back(getArg(p));
+
+        const Loc loc{file, line};
+
+        try {
+            switch (lvl) {
+            case Level::Debug:
+                sink_->debug(loc, args.data(), args.size());
+                break;
+            case Level::Info:
+                sink_->info(loc, args.data(), args.size());
+                break;
+            case Level::Warn:
+                sink_->warn(loc, args.data(), args.size());
+                break;
+            case Level::Error:
+            case Level::Fatal:
+                sink_->error(loc, args.data(), args.size());
+                break;
+            }
+        } catch (...) {
+            ASSERT(false, "AsyncHandler: unexpected exception caught!");
+        }
+
+        written_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Decodes an argument.
+     *
+     * Strings are referring to the record data.
+     */
+    static Arg getArg(const char*& p)
+    {
+        const auto type = get<Arg::Type>(p);
+        const auto key = getString(p);
+
+        switch (type) {
+        case Arg::Type::Invalid:
+            break;
+        case Arg::Type::Int:
+            return Arg{key, int(get<int32_t>(p))};
+        case Arg::Type::Int64:
+            return Arg{key, get<int64_t>(p)};
+        case Arg::Type::UInt64:
+            return Arg{key, get<uint64_t>(p)};
+        case Arg::Type::Errno:
+            return Arg{key, ec_t{int(get<int32_t>(p))}};
+        case Arg::Type::Double:
+            return Arg{key, get<double>(p)};
+        case Arg::Type::String:
+            return Arg{key, getString(p)};
+        case Arg::Type::Array: {
+            const auto num = get<uint32_t>(p);
+            std::vector<Arg> arr;
+            arr.reserve(num);
+            for (uint32_t i = 0; i < num; ++i)
+                arr.push_back(getArg(p));
+            return Arg{key, arr.data(), arr.size()};
+        }
+        }
+
+        return Arg{};
+    }
+
+    /**
+     * \return A copy of the list of rings.
+     */
+    std::vector<Ring*> rings()
+    {
+        std::vector<Ring*> ret;
+
+        std::lock_guard<std::mutex> lk(mutex_);
+        ret.reserve(rings_.size());
+        for (const auto& el : rings_)
+            ret.push_back(el.get());
+
+        return ret;
+    }
+
+    /**
+     * \brief Background thread loop.
+     */
+    void run()
+    {
+        const auto writeFn = [this](const char* p, size_t sz) { write(p, sz); };
+
+        for (;;) {
+            // records pushed from now on will wake up again.
+            pending_.store(false, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            bool any = false;
+
+            // round robin among threads rings.
+            for (auto r : rings())
+                any |= r->pop(writeFn);
+
+            if (any)
+                continue;
+
+            if (stop_.load(std::memory_order_acquire))
+                break;
+
+            std::unique_lock<std::mutex> lk(mutex_);
+            cond_.wait_for(lk, std::chrono::milliseconds(10), [this]() {
+                return pending_.load(std::memory_order_acquire) ||
+                    stop_.load(std::memory_order_acquire);
+            });
+        }
+    }
+
+    /**
+     * \brief Waits for every pushed record to be written.
+     */
+    void flush()
+    {
+        std::vector<std::pair<Ring*, size_t>> target;
+        for (auto r : rings())
+            target.emplace_back(r, r->head());
+
+        for (const auto& [r, h] : target) {
+            while (r->tail() < h) {
+                wakeUp();
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    const uint64_t id_;                   ///< Handler identifier.
+    const std::unique_ptr<Handler> sink_; ///< Sink handler.
+    const Overflow policy_;               ///< Overflow policy.
+    const size_t capacity_;               ///< Capacity of rings.
+
+    std::mutex mutex_;                         ///< Rings list mutex.
+    std::condition_variable cond_;             ///< Wake up the thread.
+    std::vector<std::shared_ptr<Ring>> rings_; ///< Threads rings, shared with threads.
+
+    std::vector<Arg> args_;       ///< Decoded arguments.
+    std::atomic<size_t> written_; ///< Written records.
+    std::atomic<bool> pending_;   ///< Whether records were pushed since the thread woke up.
+    std::atomic<bool> stop_;      ///< Stop request.
+    std::thread thread_;          ///< Background thread.
+};
+
+
+AsyncHandler::AsyncHandler(Handler* sink, Overflow policy, size_t capacity)
+    : d_{std::make_unique<Impl>(sink, policy, capacity)}
+{
+    d_->thread_ = std::thread(&Impl::run, d_.get());
+}
+
+
+AsyncHandler::~AsyncHandler() noexcept
+{
+    d_->stop_.store(true, std::memory_order_release);
+    d_->wakeUp();
+    d_->thread_.join();
+
+    // forget any reference of the calling thread.
+    auto& tl = tlsRings.list;
+    for (auto it = tl.begin(); it != tl.end();) {
+        if (it->first == d_->id_)
+            it = tl.erase(it);
+        else
+            ++it;
+    }
+}
+
+
+void AsyncHandler::debug(const Loc& loc, const Arg args[], size_t num) const
+{
+    d_->push(Level::Debug, loc, args, num);
+}
+
+
+void AsyncHandler::info(const Loc& loc, const Arg args[], size_t num) const
+{
+    d_->push(Level::Info, loc, args, num);
+}
+
+
+void AsyncHandler::warn(const Loc& loc, const Arg args[], size_t num) const
+{
+    d_->push(Level::Warn, loc, args, num);
+}
+
+
+void AsyncHandler::error(const Loc& loc, const Arg args[], size_t num) const
+{
+    d_->push(Level::Error, loc, args, num);
+}
+
+
+void AsyncHandler::fatal(const Loc& loc, const Arg args[], size_t num) const
+{
+    d_->flush();
+    d_->sink_->fatal(loc, args, num);
+}
+
+
+void AsyncHandler::flush() const
+{
+    d_->flush();
+}
+
+
+AsyncHandler::Overflow AsyncHandler::overflow() const noexcept
+{
+    return d_->policy_;
+}
+
+
+size_t AsyncHandler::dropped() const noexcept
+{
+    size_t ret = 0;
+
+    std::lock_guard<std::mutex> lk(d_->mutex_);
+    for (const auto& el : d_->rings_)
+        ret += el->dropped_.load(std::memory_order_relaxed);
+
+    return ret;
+}
+
+
+size_t AsyncHandler::rings() const noexcept
+{
+    std::lock_guard<std::mutex> lk(d_->mutex_);
+    return d_->rings_.size();
+}
+
+
+size_t AsyncHandler::written() const noexcept
+{
+    return d_->written_.load(std::memory_order_relaxed);
+}
+
+} // namespace log
+} // namespace fuurin
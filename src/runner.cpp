@@ -10,6 +10,7 @@
 
 #include "fuurin/runner.h"
 #include "fuurin/session.h"
+#include "fuurin/sessionstate.h"
 #include "fuurin/zmqcontext.h"
 #include "fuurin/zmqsocket.h"
 #include "fuurin/zmqpoller.h"
@@ -17,20 +18,57 @@
 #include "fuurin/zmqpartmulti.h"
 #include "fuurin/zmqcancel.h"
 #include "failure.h"
+#include "types.h"
 #include "log.h"
 
 #include <zmq.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include <boost/scope_exit.hpp>
 
+#include <algorithm>
 #include <cstring>
+#include <string_view>
 
 
 #define GROUP_EVENTS "EVN"
+#define GROUP_CONFLATED "EVC"
+
+
+using namespace std::literals::string_view_literals;
 
 
 namespace fuurin {
 
+namespace {
+/**
+ * \brief Pins the calling thread to some CPUs.
+ *
+ * \param[in] cpus List of CPU indexes.
+ *
+ * \return Whether affinity was set.
+ */
+bool setThreadAffinity(const std::vector<int>& cpus)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (const auto cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+            return false;
+        CPU_SET(cpu, &set);
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    UNUSED(cpus);
+    return false;
+#endif
+}
+} // namespace
+
 
 Runner::Runner(Uuid id, const std::string& name)
     : name_{name}
@@ -40,14 +78,18 @@ Runner::Runner(Uuid id, const std::string& name)
     , zopr_(std::make_unique<zmq::Socket>(zctx_.get(), zmq::Socket::PAIR))
     , zevs_(std::make_unique<zmq::Socket>(zctx_.get(), zmq::Socket::RADIO))
     , zevr_(std::make_unique<zmq::Socket>(zctx_.get(), zmq::Socket::DISH))
-    , zfins_{std::make_unique<zmq::Socket>(zctx_.get(), zmq::Socket::PUSH)}
-    , zfinr_{std::make_unique<zmq::Socket>(zctx_.get(), zmq::Socket::PULL)}
+    , state_{std::make_unique<SessionState>()}
     , zevpoll_{std::make_unique<zmq::PollerAuto<zmq::Socket>>(zmq::PollerEvents::Read, 0ms, zevr_.get())}
-    , running_(false)
     , token_(0)
     , endpDelivery_{{"ipc:///tmp/worker_delivery"}}
     , endpDispatch_{{"ipc:///tmp/worker_dispatch"}}
     , endpSnapshot_{{"ipc:///tmp/broker_snapshot"}}
+    , hwmSend_{0}
+    , hwmRecv_{0}
+    , bufSend_{-1}
+    , bufRecv_{-1}
+    , drain_{32}
+    , busyPoll_{0}
 {
     zops_->setEndpoints({"inproc://runner-loop"});
     zopr_->setEndpoints({"inproc://runner-loop"});
@@ -55,7 +97,7 @@ Runner::Runner(Uuid id, const std::string& name)
     zevs_->setEndpoints({"inproc://runner-events"});
     zevr_->setEndpoints({"inproc://runner-events"});
 
-    zevr_->setGroups({GROUP_EVENTS});
+    zevr_->setGroups({GROUP_EVENTS, GROUP_CONFLATED});
 
     zopr_->bind();
     zops_->connect();
@@ -63,19 +105,6 @@ Runner::Runner(Uuid id, const std::string& name)
     zevs_->bind();
     zevr_->connect();
 
-    // MUST be inproc in order to get instant delivery of messages.
-    zfins_->setEndpoints({"inproc://runner-terminate"});
-    zfinr_->setEndpoints({"inproc://runner-terminate"});
-
-    zfins_->setHighWaterMark(1, 1);
-    zfinr_->setHighWaterMark(1, 1);
-
-    zfins_->setConflate(true);
-    zfinr_->setConflate(true);
-
-    zfinr_->bind();
-    zfins_->connect();
-
     // FIXME: to be removed.
     zevpoll_->wait();
 }
@@ -127,18 +156,86 @@ const std::vector<std::string>& Runner::endpointSnapshot() const
 }
 
 
+void Runner::setHighWaterMark(int snd, int rcv)
+{
+    hwmSend_ = snd;
+    hwmRecv_ = rcv;
+}
+
+
+std::tuple<int, int> Runner::highWaterMark() const
+{
+    return {hwmSend_, hwmRecv_};
+}
+
+
+void Runner::setBufferSize(int snd, int rcv)
+{
+    bufSend_ = snd;
+    bufRecv_ = rcv;
+}
+
+
+std::tuple<int, int> Runner::bufferSize() const
+{
+    return {bufSend_, bufRecv_};
+}
+
+
+void Runner::setDrainBatch(int n)
+{
+    drain_ = std::max(n, 1);
+}
+
+
+int Runner::drainBatch() const
+{
+    return drain_;
+}
+
+
+void Runner::setBusyPoll(std::chrono::microseconds spin)
+{
+    busyPoll_ = std::max(spin, std::chrono::microseconds(0));
+}
+
+
+std::chrono::microseconds Runner::busyPoll() const
+{
+    return busyPoll_;
+}
+
+
+void Runner::setCpuAffinity(const std::vector<int>& cpus)
+{
+    cpus_ = cpus;
+}
+
+
+const std::vector<int>& Runner::cpuAffinity() const
+{
+    return cpus_;
+}
+
+
 bool Runner::isRunning() const noexcept
 {
-    // latest message is always available
-    // over the socket, because we are using
-    // inproc transport.
-    zmq::Part r;
-    if (zfinr_->tryRecv(&r) != -1) {
-        if (r.toUint8() == token_)
-            running_ = false;
-    }
+    return state_->token.load(std::memory_order_acquire) !=
+        state_->finished.load(std::memory_order_acquire);
+}
+
 
-    return running_;
+uint64_t Runner::pendingOperations() const noexcept
+{
+    // received is read first, so it's never greater than sent.
+    const auto recv = state_->opsReceived.load(std::memory_order_acquire);
+    return state_->opsSent.load(std::memory_order_acquire) - recv;
+}
+
+
+SessionState* Runner::sessionState() const noexcept
+{
+    return state_.get();
 }
 
 
@@ -160,23 +257,36 @@ std::unique_ptr<Session> Runner::createSession() const
 }
 
 
+std::optional<zmq::Part> Runner::takeConflatedEvent(SessionEnv::token_t, std::string_view) const
+{
+    return {};
+}
+
+
 std::future<void> Runner::start()
 {
     if (isRunning())
         return std::future<void>();
 
     ++token_;
-    running_ = true;
+    state_->token.store(token_, std::memory_order_release);
 
     bool commit = false;
     BOOST_SCOPE_EXIT(this, &commit)
     {
         if (!commit)
-            running_ = false;
+            state_->finished.store(token_, std::memory_order_release);
     };
 
+    auto session = createSession();
+    session->setBusyPoll(busyPoll_);
+
     auto ret = std::async(std::launch::async,
-        [s = createSession()]() {
+        [s = std::move(session), cpus = cpus_, name = name_, id = uuid_.toShortString()]() {
+            if (!cpus.empty() && !setThreadAffinity(cpus)) {
+                LOG_WARN(log::Arg{name, id},
+                    log::Arg{"could not set cpu affinity"sv});
+            }
             s->run();
         });
 
@@ -223,7 +333,7 @@ Event Runner::waitForEvent(zmq::Pollable* canc, EventMatchFunc match) const
     zmq::Poller pw{zmq::PollerEvents::Read, zevr_.get(), canc};
 
     for (;;) {
-        for (auto s : pw.wait()) {
+        for (auto s : pw.busyWait(busyPoll_)) {
             if (s == canc)
                 return {Event::Type::Invalid, Event::Notification::Timeout};
 
@@ -261,10 +371,22 @@ Event Runner::recvEvent() const
         return {Event::Type::Invalid, Event::Notification::Timeout};
     }
 
-    ASSERT(std::strncmp(r.group(), GROUP_EVENTS, sizeof(GROUP_EVENTS)) == 0, "bad event group");
-
     auto [tok, ev] = zmq::PartMulti::unpack<SessionEnv::token_t, std::string_view>(r);
 
+    if (std::strncmp(r.group(), GROUP_CONFLATED, sizeof(GROUP_CONFLATED)) == 0) {
+        auto pay = takeConflatedEvent(tok, ev);
+        if (!pay)
+            return {Event::Type::Invalid, Event::Notification::Timeout};
+
+        return Event{Event::Type::Delivery,
+            tok == token_
+                ? Event::Notification::Success
+                : Event::Notification::Discard,
+            std::move(*pay)};
+    }
+
+    ASSERT(std::strncmp(r.group(), GROUP_EVENTS, sizeof(GROUP_EVENTS)) == 0, "bad event group");
+
     return Event::fromPart(ev)
         .withNotification(tok == token_
                 ? Event::Notification::Success
@@ -280,6 +402,8 @@ void Runner::sendOperation(Operation::Type oper) noexcept
 
 void Runner::sendOperation(Operation::Type oper, zmq::Part&& payload) noexcept
 {
+    // counted before sending, so the task never receives more than sent.
+    state_->opsSent.store(state_->opsSent.load(std::memory_order_relaxed) + 1, std::memory_order_release);
     sendOperation(zops_.get(), token_, oper, std::move(payload));
 }
 
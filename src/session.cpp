@@ -9,6 +9,7 @@
  */
 
 #include "fuurin/session.h"
+#include "fuurin/sessionstate.h"
 #include "fuurin/zmqcontext.h"
 #include "fuurin/zmqsocket.h"
 #include "fuurin/zmqpoller.h"
@@ -23,6 +24,7 @@
 
 
 #define GROUP_EVENTS "EVN"
+#define GROUP_CONFLATED "EVC"
 
 
 using namespace std::literals::string_view_literals;
@@ -31,14 +33,15 @@ using namespace std::literals::string_view_literals;
 namespace fuurin {
 
 Session::Session(const std::string& name, Uuid id, SessionEnv::token_t token,
-    zmq::Context* zctx, zmq::Socket* zfin, zmq::Socket* zoper, zmq::Socket* zevent)
+    zmq::Context* zctx, SessionState* state, zmq::Socket* zoper, zmq::Socket* zevent)
     : name_{name}
     , uuid_{id}
     , token_{token}
     , zctx_{zctx}
-    , zfins_{zfin}
+    , state_{state}
     , zopr_{zoper}
     , zevs_{zevent}
+    , busyPoll_{0}
 {
 }
 
@@ -50,18 +53,13 @@ void Session::run()
 {
     BOOST_SCOPE_EXIT(this)
     {
-        try {
-            zfins_->send(zmq::Part{token_});
-        } catch (...) {
-            LOG_FATAL(log::Arg{"runner"sv},
-                log::Arg{"session on complete action threw exception"sv});
-        }
+        state_->finished.store(token_, std::memory_order_release);
     };
 
     auto poll = createPoller();
 
     for (;;) {
-        for (auto s : poll->wait()) {
+        for (auto s : poll->busyWait(busyPoll_)) {
             if (s != zopr_) {
                 socketReady(s);
                 continue;
@@ -69,6 +67,10 @@ void Session::run()
 
             auto oper = recvOperation();
 
+            // old operations are counted as well, since they are no more pending.
+            state_->opsReceived.store(state_->opsReceived.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+
             // filter out old operations
             if (oper.notification() == Operation::Notification::Discard)
                 continue;
@@ -82,6 +84,12 @@ void Session::run()
 }
 
 
+void Session::setBusyPoll(std::chrono::microseconds spin) noexcept
+{
+    busyPoll_ = spin;
+}
+
+
 std::unique_ptr<zmq::PollerWaiter> Session::createPoller()
 {
     auto poll = new zmq::Poller{zmq::PollerEvents::Type::Read, zopr_};
@@ -113,6 +121,13 @@ void Session::sendEvent(Event::Type ev, zmq::Part&& pay)
 }
 
 
+void Session::sendConflatedEvent(std::string_view name)
+{
+    zevs_->send(zmq::PartMulti::pack(token_, name)
+                    .withGroup(GROUP_CONFLATED));
+}
+
+
 Operation Session::recvOperation(zmq::Socket* sock, SessionEnv::token_t token) noexcept
 {
     try {
@@ -15,33 +15,54 @@
 #include "fuurin/zmqpartmulti.h"
 #include "fuurin/zmqtimer.h"
 #include "fuurin/workerconfig.h"
+#include "fuurin/stats.h"
+#include "fuurin/errors.h"
 #include "syncmachine.h"
+#include "topiclog.h"
 #include "failure.h"
 #include "types.h"
 #include "log.h"
 
 #include <cstring>
+#include <chrono>
 #include <string_view>
 #include <type_traits>
 #include <string>
 #include <algorithm>
+#include <utility>
 
 
 namespace fuurin {
 
 
 BrokerSession::BrokerSession(const std::string& name, Uuid id, SessionEnv::token_t token,
-    zmq::Context* zctx, zmq::Socket* zfin, zmq::Socket* zoper, zmq::Socket* zevent)
-    : Session(name, id, token, zctx, zfin, zoper, zevent)
+    zmq::Context* zctx, SessionState* state, zmq::Socket* zoper, zmq::Socket* zevent,
+    BrokerMetrics* metrics, size_t storTopics, size_t storVersions, size_t storWorkers)
+    : Session(name, id, token, zctx, state, zoper, zevent)
     , zsnapshot_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::SERVER)}
     , zdelivery_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::DISH)}
     , zdispatch_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::RADIO)}
     , zhugz_{std::make_unique<zmq::Timer>(zctx, "hugz")}
-    , storTopic_{1024} // TODO: configure capacity.
-    , storWorker_{64}  // TODO: configure capacity.
+    , zpeerdisp_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::RADIO)}
+    , zpeersnap_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::CLIENT)}
+    , zcompact_{std::make_unique<zmq::Timer>(zctx, "compact")}
+    , zflush_{std::make_unique<zmq::Timer>(zctx, "flush")}
+    , metrics_{metrics}
+    , storTopic_{storTopics}
+    , storWorker_{storWorkers}
+    , storVersions_{storVersions}
+    , hugzData_{false}
+    , hugzAnnounce_{false}
+    , hugzFiltered_{false}
+    , hugzWorker_{1024} // TODO: configure capacity.
+    , hugzPeer_{64}     // TODO: configure capacity.
+    , hugzDispatched_{0}
+    , hugzLoad_{0}
 {
     zhugz_->setInterval(1s);
     zhugz_->setSingleShot(false);
+    zcompact_->setSingleShot(false);
+    zflush_->setSingleShot(false);
 }
 
 
@@ -51,7 +72,8 @@ BrokerSession::~BrokerSession() noexcept = default;
 std::unique_ptr<zmq::PollerWaiter> BrokerSession::createPoller()
 {
     return std::unique_ptr<zmq::PollerWaiter>{new zmq::PollerAuto{zmq::PollerEvents::Type::Read,
-        zopr_, zsnapshot_.get(), zdelivery_.get(), zhugz_.get()}};
+        zopr_, zsnapshot_.get(), zdelivery_.get(), zhugz_.get(), zpeersnap_.get(), zcompact_.get(),
+        zflush_.get()}};
 }
 
 
@@ -67,11 +89,30 @@ void BrokerSession::openSockets()
     zdispatch_->setEndpoints({conf_.endpDelivery.begin(), conf_.endpDelivery.end()});
     zsnapshot_->setEndpoints({conf_.endpSnapshot.begin(), conf_.endpSnapshot.end()});
 
-    zdelivery_->setGroups({SessionEnv::WorkerHugz.data(), SessionEnv::WorkerUpdt.data()});
+    zdelivery_->setGroups({SessionEnv::WorkerHugz.data(), SessionEnv::WorkerUpdt.data(),
+        SessionEnv::BrokerPeerUpdt.data(), SessionEnv::BrokerPeerHugz.data()});
+
+    for (auto* s : {zdelivery_.get(), zdispatch_.get(), zsnapshot_.get(), zpeerdisp_.get(), zpeersnap_.get()}) {
+        s->setHighWaterMark(conf_.hwmSend, conf_.hwmRecv);
+        s->setBufferSize(conf_.bufSend, conf_.bufRecv);
+    }
 
     zdelivery_->bind();
     zdispatch_->bind();
     zsnapshot_->bind();
+
+    if (!conf_.endpPeerDispatch.empty()) {
+        zpeerdisp_->setEndpoints({conf_.endpPeerDispatch.begin(), conf_.endpPeerDispatch.end()});
+        zpeerdisp_->connect();
+    }
+    if (!conf_.endpPeerSnapshot.empty()) {
+        zpeersnap_->setEndpoints({conf_.endpPeerSnapshot.begin(), conf_.endpPeerSnapshot.end()});
+        zpeersnap_->connect();
+    }
+
+    // peers are kept alive regardless of workers.
+    if ((zpeerdisp_->isOpen() || zpeersnap_->isOpen()) && !zhugz_->isActive())
+        zhugz_->start();
 }
 
 
@@ -80,6 +121,8 @@ void BrokerSession::closeSockets()
     zdelivery_->close();
     zdispatch_->close();
     zsnapshot_->close();
+    zpeerdisp_->close();
+    zpeersnap_->close();
 }
 
 
@@ -89,12 +132,22 @@ void BrokerSession::operationReady(Operation* oper)
     case Operation::Type::Start:
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"started"sv});
         saveConfiguration(oper->payload());
+        hugzData_ = false;
+        hugzAnnounce_ = false;
+        hugzFiltered_ = false;
+        hugzWorker_.clear();
+        hugzPeer_.clear();
+        hugzDispatched_ = metrics_->dispatched.value();
+        hugzLoad_ = 0;
+        openStorage();
         openSockets();
+        requestPeerSnapshot();
         break;
 
     case Operation::Type::Stop:
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"stopped"sv});
         closeSockets();
+        closeStorage();
         break;
 
     default:
@@ -117,16 +170,39 @@ void BrokerSession::socketReady(zmq::Pollable* pble)
         receiveWorkerCommand(std::move(payload));
 
     } else if (pble == zdelivery_.get()) {
+        // a batch is drained, then other ready sockets are served in turn.
+        for (int n = 0; n < conf_.drainBatch; ++n) {
+            zmq::Part payload;
+            if (zdelivery_->tryRecv(&payload) == -1)
+                break;
+
+            LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"delivery"sv},
+                log::Arg{"size"sv, int(payload.size())});
+
+            collectWorkerMessage(std::move(payload));
+        }
+
+    } else if (pble == zpeersnap_.get()) {
         zmq::Part payload;
-        zdelivery_->recv(&payload);
-        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"delivery"sv},
+        zpeersnap_->recv(&payload);
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"peer"sv},
             log::Arg{"size"sv, int(payload.size())});
 
-        collectWorkerMessage(std::move(payload));
+        collectPeerSnapshot(std::move(payload));
 
     } else if (pble == zhugz_.get()) {
         zhugz_->consume();
+        updateStatus();
         sendHugz();
+        sendPeerHugz();
+
+    } else if (pble == zcompact_.get()) {
+        zcompact_->consume();
+        compactStorage();
+
+    } else if (pble == zflush_.get()) {
+        zflush_->consume();
+        flushStorage();
 
     } else {
         LOG_FATAL(log::Arg{name_, uuid_.toShortString()},
@@ -139,36 +215,34 @@ void BrokerSession::socketReady(zmq::Pollable* pble)
 void BrokerSession::collectWorkerMessage(zmq::Part&& payload)
 {
     if (std::strncmp(payload.group(), SessionEnv::WorkerHugz.data(), SessionEnv::WorkerHugz.size()) == 0) {
-        // TODO: extract the message
+        // workers which don't tell their flags are handled conservatively.
+        uint8_t flags = SessionEnv::WorkerHugzAnnounce | SessionEnv::WorkerHugzFiltered;
+
+        if (!payload.empty()) {
+            const auto [fl, worker, nonce, stamp] = zmq::PartMulti::unpack<uint8_t,
+                Uuid::Bytes, uint64_t, uint64_t>(payload);
+
+            flags = fl;
+            hugzWorker_.put(Uuid::fromBytes(worker), std::chrono::steady_clock::now());
+
+            // echo back, so the worker can measure the round trip time.
+            sendHugz(worker, nonce, stamp);
+        }
+
+        hugzAnnounce_ |= (flags & SessionEnv::WorkerHugzAnnounce) != 0;
+        hugzFiltered_ |= (flags & SessionEnv::WorkerHugzFiltered) != 0;
+
         if (!zhugz_->isActive())
             zhugz_->start();
 
     } else if (std::strncmp(payload.group(), SessionEnv::WorkerUpdt.data(), SessionEnv::WorkerUpdt.size()) == 0) {
-        const auto t = Topic::fromPart(payload).withBroker(uuid_);
+        collectTopic(payload, false);
 
-        if (!storeTopic(t)) {
-            LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"discard"sv},
-                log::Arg{"from"sv, t.worker().toShortString()},
-                log::Arg{"name"sv, std::string_view(t.name())},
-                log::Arg{"seqn"sv, int(t.seqNum())}, // FIXME: fix cast to int.
-                log::Arg{"size"sv, int(t.data().size())});
-            return;
-        }
+    } else if (std::strncmp(payload.group(), SessionEnv::BrokerPeerUpdt.data(), SessionEnv::BrokerPeerUpdt.size()) == 0) {
+        collectTopic(payload, true);
 
-        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"dispatch"sv},
-            log::Arg{"from"sv, t.worker().toShortString()},
-            log::Arg{"name"sv, std::string_view(t.name())},
-            log::Arg{"seqn"sv, int(t.seqNum())}, // FIXME: fix cast to int.
-            log::Arg{"size"sv, int(t.data().size())});
-
-        /**
-         * Topic is sent twice, both to the global group
-         * and to the topic name group (topic name is
-         * a null terminated string).
-         */
-        // TODO: Is it possible to avoid sending topic twice?
-        zdispatch_->send(t.toPart().withGroup(std::string_view(t.name()).data()));
-        zdispatch_->send(t.toPart().withGroup(SessionEnv::BrokerUpdt.data()));
+    } else if (std::strncmp(payload.group(), SessionEnv::BrokerPeerHugz.data(), SessionEnv::BrokerPeerHugz.size()) == 0) {
+        collectPeerHugz(Uuid::fromPart(payload));
 
     } else {
         LOG_WARN(log::Arg{name_, uuid_.toShortString()},
@@ -179,14 +253,80 @@ void BrokerSession::collectWorkerMessage(zmq::Part&& payload)
 }
 
 
+void BrokerSession::collectTopic(const zmq::Part& payload, bool fromPeer)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    auto t = Topic::fromPart(payload);
+    const auto origin = t.broker();
+
+    if (fromPeer) {
+        // a topic which was forwarded by this broker is never stored again.
+        if (origin == uuid_)
+            return;
+
+        metrics_->peerReceived.add();
+
+    } else {
+        metrics_->received.add();
+        hugzWorker_.put(t.worker(), t0);
+
+        // sequence numbers of a worker are contiguous, unless topics were dropped.
+        if (const auto it = storWorker_.find(t.worker()); it != storWorker_.list().end() && t.seqNum() > it->second + 1)
+            metrics_->dropped.add(t.seqNum() - it->second - 1);
+    }
+
+    t.withBroker(uuid_);
+    if (t.trace())
+        t.withTraceStamp(Topic::Hop::Ingested, Topic::traceNow());
+
+    if (!storeTopic(t)) {
+        metrics_->discarded.add();
+
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"discard"sv},
+            log::Arg{"from"sv, t.worker().toShortString()},
+            log::Arg{"name"sv, std::string_view(t.name())},
+            log::Arg{"seqn"sv, t.seqNum()},
+            log::Arg{"size"sv, int(t.data().size())});
+        return;
+    }
+
+    persistTopic(t);
+
+    LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"dispatch"sv},
+        log::Arg{"from"sv, t.worker().toShortString()},
+        log::Arg{"origin"sv, origin.toShortString()},
+        log::Arg{"name"sv, std::string_view(t.name())},
+        log::Arg{"seqn"sv, t.seqNum()},
+        log::Arg{"size"sv, int(t.data().size())});
+
+    if (t.trace())
+        t.withTraceStamp(Topic::Hop::FannedOut, Topic::traceNow());
+
+    /**
+     * Topic is sent twice, both to the global group
+     * and to the topic name group (topic name is
+     * a null terminated string).
+     */
+    // TODO: Is it possible to avoid sending topic twice?
+    zdispatch_->send(t.toPart().withGroup(std::string_view(t.name()).data()));
+    zdispatch_->send(t.toPart().withGroup(SessionEnv::BrokerUpdt.data()));
+
+    // only the origin broker forwards, so peers never loop topics.
+    if (!fromPeer)
+        forwardTopic(t);
+
+    hugzData_ = true;
+    metrics_->dispatched.add();
+    metrics_->dispatchLatency.record(std::chrono::steady_clock::now() - t0);
+}
+
+
 bool BrokerSession::storeTopic(const Topic& t)
 {
     auto it = storTopic_.find(t.name());
 
-    if (it == storTopic_.list().end()) {
-        // TODO: configure capacity.
-        it = storTopic_.put(t.name(), LRUCache<WorkerUuid, Topic>{8});
-    }
+    if (it == storTopic_.list().end())
+        it = storTopic_.emplace(t.name(), storVersions_);
 
     ASSERT(it != storTopic_.list().end(), "broker storage topic cache is null");
 
@@ -208,10 +348,260 @@ bool BrokerSession::storeTopic(const Topic& t)
 }
 
 
+void BrokerSession::openStorage()
+{
+    if (conf_.storageFile.empty())
+        return;
+
+    try {
+        storLog_ = std::make_unique<TopicLog>(conf_.storageFile);
+
+        const auto cnt = storLog_->load([this](Topic&& t) {
+            storeTopic(t.withBroker(uuid_));
+        });
+
+        LOG_INFO(log::Arg{name_, uuid_.toShortString()}, log::Arg{"storage"sv, "load"sv},
+            log::Arg{"records"sv, int(cnt)},
+            log::Arg{"elements"sv, int(storTopic_.size())});
+
+        storLog_->open();
+
+    } catch (const err::Error& e) {
+        storageFailed(e);
+        storLog_.reset();
+        return;
+    }
+
+    zcompact_->setInterval(conf_.storageCompaction);
+    zcompact_->start();
+    zflush_->setInterval(conf_.storageFlush);
+    zflush_->start();
+}
+
+
+void BrokerSession::closeStorage()
+{
+    if (!storLog_)
+        return;
+
+    zcompact_->stop();
+    zflush_->stop();
+
+    try {
+        storLog_->waitCompaction();
+        if (storLog_->appended() > 0)
+            compactStorage();
+        storLog_->waitCompaction();
+
+    } catch (const err::Error& e) {
+        storageFailed(e);
+    }
+
+    storLog_.reset();
+}
+
+
+void BrokerSession::compactStorage()
+{
+    if (!storLog_ || storLog_->isCompacting() || storLog_->appended() == 0)
+        return;
+
+    try {
+        storLog_->compact([this](const TopicLog::WriteFunc& write) {
+            for (const auto& el : storTopic_.list()) {
+                for (const auto& it : el.second.list()) {
+                    if (it.second.type() == Topic::State)
+                        write(it.second);
+                }
+            }
+        });
+
+    } catch (const err::Error& e) {
+        storageFailed(e);
+        return;
+    }
+
+    LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"storage"sv, "compact"sv},
+        log::Arg{"elements"sv, int(storTopic_.size())});
+}
+
+
+void BrokerSession::flushStorage()
+{
+    if (!storLog_)
+        return;
+
+    try {
+        storLog_->flush();
+
+        if (!storLog_->isCompacting())
+            storLog_->waitCompaction();
+
+    } catch (const err::Error& e) {
+        storageFailed(e);
+    }
+}
+
+
+void BrokerSession::persistTopic(const Topic& t)
+{
+    if (!storLog_ || t.type() != Topic::State)
+        return;
+
+    try {
+        storLog_->append(t);
+    } catch (const err::Error& e) {
+        storageFailed(e);
+    }
+}
+
+
+void BrokerSession::storageFailed(const err::Error& e)
+{
+    metrics_->storageErrors.add();
+
+    LOG_ERROR(log::Arg{name_, uuid_.toShortString()}, log::Arg{"storage"sv, "error"sv},
+        log::Arg{std::string_view(e.what())}, e.arg());
+}
+
+
+void BrokerSession::forwardTopic(const Topic& t)
+{
+    if (!zpeerdisp_->isOpen())
+        return;
+
+    zpeerdisp_->send(t.toPart().withGroup(SessionEnv::BrokerPeerUpdt.data()));
+}
+
+
+void BrokerSession::requestPeerSnapshot()
+{
+    if (!zpeersnap_->isOpen())
+        return;
+
+    // request the whole storage, sequence number is not used by the broker.
+    const auto params = WorkerConfig{uuid_, 0, true, {}, {}, {}, {}}.toPart();
+
+    // client socket distributes requests among peers in round robin.
+    for (size_t i = 0; i < conf_.endpPeerSnapshot.size(); ++i) {
+        if (zpeersnap_->trySend(zmq::PartMulti::pack(SessionEnv::BrokerSyncReqst,
+                                    SyncMachine::seqn_t(0), zmq::Part{params})) == -1) {
+            LOG_WARN(log::Arg{name_, uuid_.toShortString()},
+                log::Arg{"peer"sv, "request"sv},
+                log::Arg{"reason"sv, "send would block"sv});
+        }
+    }
+}
+
+
+void BrokerSession::sendPeerHugz()
+{
+    if (!zpeerdisp_->isOpen())
+        return;
+
+    zpeerdisp_->send(uuid_.toPart().withGroup(SessionEnv::BrokerPeerHugz.data()));
+}
+
+
+void BrokerSession::collectPeerHugz(const Uuid& peer)
+{
+    if (peer == uuid_)
+        return;
+
+    const bool isKnown = hugzPeer_.find(peer) != hugzPeer_.list().end();
+    hugzPeer_.put(peer, std::chrono::steady_clock::now());
+
+    if (isKnown)
+        return;
+
+    // topics forwarded while the peer was unreachable were lost.
+    LOG_INFO(log::Arg{name_, uuid_.toShortString()}, log::Arg{"peer"sv, "online"sv},
+        log::Arg{"from"sv, peer.toShortString()});
+
+    requestPeerSnapshot();
+}
+
+
+void BrokerSession::collectPeerSnapshot(zmq::Part&& payload)
+{
+    auto [reply, syncseq, params] = zmq::PartMulti::unpack<std::string_view, SyncMachine::seqn_t, zmq::Part>(payload);
+
+    if (reply == SessionEnv::BrokerSyncBegin || reply == SessionEnv::BrokerSyncCompl) {
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"peer"sv, reply},
+            log::Arg{"from"sv, Uuid::fromPart(params).toShortString()});
+
+    } else if (reply == SessionEnv::BrokerSyncElemn) {
+        const auto t = Topic::fromPart(params).withBroker(uuid_);
+
+        metrics_->peerReceived.add();
+
+        if (!storeTopic(t)) {
+            metrics_->discarded.add();
+            return;
+        }
+
+        persistTopic(t);
+
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"peer"sv, "store"sv},
+            log::Arg{"from"sv, t.worker().toShortString()},
+            log::Arg{"name"sv, std::string_view(t.name())},
+            log::Arg{"seqn"sv, t.seqNum()},
+            log::Arg{"size"sv, int(t.data().size())});
+
+    } else {
+        LOG_WARN(log::Arg{name_, uuid_.toShortString()},
+            log::Arg{"peer"sv, "recv"sv},
+            log::Arg{"reply"sv, reply},
+            log::Arg{"syncseq"sv, syncseq},
+            log::Arg{"unknown reply"sv});
+    }
+}
+
+
 void BrokerSession::sendHugz()
 {
-    // TODO: send network status update.
-    zdispatch_->send(zmq::Part{}.withGroup(SessionEnv::BrokerHugz.data()));
+    const bool isData = std::exchange(hugzData_, false);
+    const bool isAnnounce = std::exchange(hugzAnnounce_, false);
+
+    /**
+     * Data already acts as a keepalive, unless a worker is waiting
+     * for a reply to its announcement, or any worker filters topics,
+     * because it might not receive the data which was dispatched.
+     */
+    if (isData && !isAnnounce && !hugzFiltered_)
+        return;
+
+    sendHugz(Uuid{}.bytes(), 0, 0);
+}
+
+
+void BrokerSession::sendHugz(const Uuid::Bytes& worker, uint64_t nonce, uint64_t stamp)
+{
+    zdispatch_->send(zmq::PartMulti::pack(uint32_t(hugzWorker_.size()), hugzLoad_,
+        uint64_t(storTopic_.size()), worker, nonce, stamp)
+                         .withGroup(SessionEnv::BrokerHugz.data()));
+}
+
+
+void BrokerSession::updateStatus()
+{
+    const auto now = std::chrono::steady_clock::now();
+    const auto expiry = WorkerExpiry * zhugz_->interval();
+
+    // workers are sorted from the least recently seen.
+    while (!hugzWorker_.empty() && now - hugzWorker_.list().front().second > expiry) {
+        const auto worker = hugzWorker_.list().front().first;
+        hugzWorker_.get(worker);
+    }
+
+    while (!hugzPeer_.empty() && now - hugzPeer_.list().front().second > expiry) {
+        const auto peer = hugzPeer_.list().front().first;
+        hugzPeer_.get(peer);
+    }
+
+    const auto dispatched = metrics_->dispatched.value();
+    hugzLoad_ = (dispatched - std::exchange(hugzDispatched_, dispatched)) * 1000 /
+        std::max<uint64_t>(1, zhugz_->interval().count());
 }
 
 
@@ -242,6 +632,9 @@ void BrokerSession::replySnapshot(uint32_t rouID, uint8_t syncseq, zmq::Part&& p
         log::Arg{"elements"sv, int(storTopic_.size())});
 
     const WorkerConfig conf = WorkerConfig::fromPart(params);
+    const auto t0 = std::chrono::steady_clock::now();
+
+    metrics_->syncRequests.add();
 
     try {
         const auto& errWouldBlock = ERROR(ZMQSocketSendFailed, "",
@@ -263,11 +656,15 @@ void BrokerSession::replySnapshot(uint32_t rouID, uint8_t syncseq, zmq::Part&& p
                                         .withRoutingID(rouID)) == -1) {
                 throw errWouldBlock;
             }
+
+            metrics_->syncElements.add();
         }
         if (zsnapshot_->trySend(zmq::PartMulti::pack(SessionEnv::BrokerSyncCompl, syncseq, uuid_.toPart())
                                     .withRoutingID(rouID)) == -1) {
             throw errWouldBlock;
         }
+
+        metrics_->syncLatency.record(std::chrono::steady_clock::now() - t0);
     }
     // check whether the peer has disappeared.
     catch (const err::ZMQSocketSendFailed& e) {
@@ -279,6 +676,7 @@ void BrokerSession::replySnapshot(uint32_t rouID, uint8_t syncseq, zmq::Part&& p
             break;
 
         case EAGAIN:
+            metrics_->syncAborts.add();
             LOG_WARN(log::Arg{name_, uuid_.toShortString()},
                 log::Arg{"sync"sv, "abort"sv},
                 log::Arg{"reason"sv, "send would block"sv});
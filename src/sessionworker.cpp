@@ -9,18 +9,24 @@
  */
 
 #include "fuurin/sessionworker.h"
+#include "fuurin/sessionstate.h"
 #include "fuurin/zmqsocket.h"
 #include "fuurin/zmqpoller.h"
 #include "fuurin/zmqpart.h"
 #include "fuurin/zmqpartmulti.h"
 #include "fuurin/zmqtimer.h"
 #include "fuurin/errors.h"
+#include "fuurin/stats.h"
+#include "fuurin/topicview.h"
 #include "connmachine.h"
 #include "syncmachine.h"
+#include "topiccache.h"
+#include "deliveryconflater.h"
 #include "types.h"
 #include "log.h"
 
 #include <algorithm>
+#include <chrono>
 #include <utility>
 #include <list>
 #include <set>
@@ -36,41 +42,57 @@ namespace fuurin {
 
 
 WorkerSession::WorkerSession(const std::string& name, Uuid id, SessionEnv::token_t token,
-    zmq::Context* zctx, zmq::Socket* zfin, zmq::Socket* zoper, zmq::Socket* zevent,
-    zmq::Socket* zseqs)
-    : Session(name, id, token, zctx, zfin, zoper, zevent)
-    , zsnapshot_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::CLIENT)}
-    , zdelivery_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::DISH)}
-    , zdispatch_{std::make_unique<zmq::Socket>(zctx, zmq::Socket::RADIO)}
-    , conn_{
-          std::make_unique<ConnMachine>(name_, id, zctx,
-              500ms,  // TODO: make configurable
-              3000ms, // TODO: make configurable
-
-              std::bind(&WorkerSession::connClose, this),    //
-              std::bind(&WorkerSession::connOpen, this),     //
-              std::bind(&WorkerSession::sendAnnounce, this), //
-              [this](ConnMachine::State s) {
-                  onConnChanged(std::underlying_type_t<ConnMachine::State>(s));
-              }),
+    zmq::Context* zctx, SessionState* state, zmq::Socket* zoper, zmq::Socket* zevent,
+    WorkerMetrics* metrics, TopicCache* cache, DeliveryConflater* conflater,
+    std::function<void(const TopicView&)> handler, std::chrono::nanoseconds handlerBudget)
+    : Session(name, id, token, zctx, state, zoper, zevent)
+    , zsnapshot_{
+          std::make_unique<zmq::Socket>(zctx, zmq::Socket::CLIENT),
+          std::make_unique<zmq::Socket>(zctx, zmq::Socket::CLIENT),
+          std::make_unique<zmq::Socket>(zctx, zmq::Socket::CLIENT),
+          std::make_unique<zmq::Socket>(zctx, zmq::Socket::CLIENT),
       }
+    , pathCount_{1}
     , sync_{
           std::make_unique<SyncMachine>(name_, id, zctx,
-              0,      // TODO: depends on number of endpoints
+              0,      // depends on number of endpoints, see Start.
               1,      // TODO: make configurable
               3000ms, // TODO: make configurable
 
-              std::bind(&WorkerSession::snapClose, this),                       //
-              std::bind(&WorkerSession::snapOpen, this),                        //
-              std::bind(&WorkerSession::sendSync, this, std::placeholders::_2), //
+              std::bind(&WorkerSession::snapClose, this, std::placeholders::_1),                         //
+              std::bind(&WorkerSession::snapOpen, this, std::placeholders::_1),                          //
+              std::bind(&WorkerSession::sendSync, this, std::placeholders::_1, std::placeholders::_2), //
               [this](SyncMachine::State s) {
                   onSyncChanged(std::underlying_type_t<SyncMachine::State>(s));
               }),
       }
-    , zseqs_{zseqs}
+    , metrics_{metrics}
+    , cache_{cache}
+    , conflater_{conflater}
+    , handler_{std::move(handler)}
+    , handlerBudget_{handlerBudget}
     , isOnline_{false}
     , isSnapshot_{false}
+    , hugzNonce_{0}
+    , dispatchTime_{}
 {
+    for (size_t i = 0; i < path_.size(); ++i) {
+        auto& p = path_[i];
+
+        p.name = i == 0 ? name_ : log::format("%s_path%d", name_.data(), int(i));
+        p.zdelivery = std::make_unique<zmq::Socket>(zctx, zmq::Socket::DISH);
+        p.zdispatch = std::make_unique<zmq::Socket>(zctx, zmq::Socket::RADIO);
+        p.conn = std::make_unique<ConnMachine>(p.name, id, zctx,
+            WorkerConfig{}.connRetry,   // see Start.
+            WorkerConfig{}.connTimeout, // see Start.
+
+            std::bind(&WorkerSession::connClose, this, i),    //
+            std::bind(&WorkerSession::connOpen, this, i),     //
+            std::bind(&WorkerSession::sendAnnounce, this, i), //
+            [this](ConnMachine::State s) {
+                onConnChanged(std::underlying_type_t<ConnMachine::State>(s));
+            });
+    }
 }
 
 
@@ -85,10 +107,21 @@ bool WorkerSession::isOnline() const noexcept
 
 std::unique_ptr<zmq::PollerWaiter> WorkerSession::createPoller()
 {
-    return std::unique_ptr<zmq::PollerWaiter>{new zmq::PollerAuto{zmq::PollerEvents::Type::Read,
-        zopr_, zsnapshot_.get(), zdelivery_.get(),
-        conn_->timerRetry(), conn_->timerTimeout(),
-        sync_->timerTimeout()}};
+    return std::unique_ptr<zmq::PollerWaiter>{createPoller(
+        std::make_index_sequence<SnapshotSockets>{},
+        std::make_index_sequence<PathSockets>{})};
+}
+
+
+template<size_t... S, size_t... P>
+zmq::PollerWaiter* WorkerSession::createPoller(std::index_sequence<S...>, std::index_sequence<P...>)
+{
+    return new zmq::PollerAuto{zmq::PollerEvents::Type::Read,
+        zopr_, zsnapshot_[S].get()...,
+        path_[P].zdelivery.get()...,
+        path_[P].conn->timerRetry()...,
+        path_[P].conn->timerTimeout()...,
+        sync_->timerTimeout()};
 }
 
 
@@ -101,12 +134,23 @@ void WorkerSession::operationReady(Operation* oper)
     case Operation::Type::Start:
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"started"sv});
         saveConfiguration(oper->payload());
+        pathCount_ = conf_.endpDelivery.size() != conf_.endpDispatch.size()
+            ? 1
+            : std::clamp(conf_.endpDelivery.size(), size_t(1), PathSockets);
+        sync_->setMaxIndex(!conf_.syncRacing ? 0
+                                              : int(std::clamp(conf_.endpSnapshot.size(), size_t(1), SnapshotSockets)) - 1);
+        sync_->setRacing(conf_.syncRacing);
         sendEvent(Event::Type::Started, std::move(oper->payload()));
-        conn_->onStart();
+        for (size_t i = 0; i < pathCount_; ++i) {
+            path_[i].conn->setIntervals(conf_.connRetry, conf_.connTimeout);
+            path_[i].conn->setKeepalive(conf_.connKeepalive);
+            path_[i].conn->onStart();
+        }
         break;
 
     case Operation::Type::Stop:
-        conn_->onStop();
+        for (auto& p : path_)
+            p.conn->onStop();
         sync_->onHalt();
         sendEvent(Event::Type::Stopped, std::move(oper->payload()));
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"stopped"sv});
@@ -116,11 +160,16 @@ void WorkerSession::operationReady(Operation* oper)
         ++seqNum_;
         notifySequenceNumber();
 
-        // FIXME: log::Arg shoud support int64 type, int(seqNum_) is not correct.
+        metrics_->dispatched.add();
+        dispatchTime_[seqNum_ % dispatchTime_.size()] = {seqNum_, std::chrono::steady_clock::now()};
+
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"dispatch"sv},
-            log::Arg{"size"sv, int(paysz)}, log::Arg{"seqn"sv, int(seqNum_)});
+            log::Arg{"size"sv, uint64_t(paysz)}, log::Arg{"seqn"sv, seqNum_});
+
+        if (Topic::isTraced(oper->payload()))
+            Topic::withTraceStamp(oper->payload(), Topic::Hop::Dispatched, Topic::traceNow());
 
-        zdispatch_->send(std::move(
+        sendDispatch(std::move(
             Topic::withSeqNum(oper->payload(), seqNum_)
                 .withGroup(SessionEnv::WorkerUpdt.data())));
         break;
@@ -142,32 +191,51 @@ void WorkerSession::operationReady(Operation* oper)
 
 void WorkerSession::socketReady(zmq::Pollable* pble)
 {
-    if (pble == zsnapshot_.get()) {
-        zmq::Part payload;
-        zsnapshot_->recv(&payload);
-        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"snapshot"sv},
-            log::Arg{"size"sv, int(payload.size())});
+    const auto snap = std::find_if(zsnapshot_.begin(), zsnapshot_.end(),
+        [pble](const auto& s) { return s.get() == pble; });
 
-        recvBrokerSnapshot(std::move(payload));
+    if (snap != zsnapshot_.end()) {
+        const int idx = int(std::distance(zsnapshot_.begin(), snap));
 
-    } else if (pble == zdelivery_.get()) {
         zmq::Part payload;
-        zdelivery_->recv(&payload);
-        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"delivery"sv},
-            log::Arg{"size"sv, int(payload.size())});
-
-        collectBrokerMessage(std::move(payload));
-
-    } else if (pble == conn_->timerRetry()) {
-        conn_->onTimerRetryFired();
+        (*snap)->recv(&payload);
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"snapshot"sv},
+            log::Arg{"index"sv, idx}, log::Arg{"size"sv, int(payload.size())});
 
-    } else if (pble == conn_->timerTimeout()) {
-        conn_->onTimerTimeoutFired();
+        recvBrokerSnapshot(idx, std::move(payload));
 
     } else if (pble == sync_->timerTimeout()) {
         sync_->onTimerTimeoutFired();
 
     } else {
+        for (size_t i = 0; i < path_.size(); ++i) {
+            auto& p = path_[i];
+
+            if (pble == p.zdelivery.get()) {
+                // a batch is drained, then other ready sockets are served in turn,
+                // unless the path was closed meanwhile.
+                for (int n = 0; n < conf_.drainBatch && p.zdelivery->isOpen(); ++n) {
+                    zmq::Part payload;
+                    if (p.zdelivery->tryRecv(&payload) == -1)
+                        break;
+
+                    LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"delivery"sv},
+                        log::Arg{"path"sv, int(i)}, log::Arg{"size"sv, int(payload.size())});
+
+                    collectBrokerMessage(i, std::move(payload));
+                }
+                return;
+
+            } else if (pble == p.conn->timerRetry()) {
+                p.conn->onTimerRetryFired();
+                return;
+
+            } else if (pble == p.conn->timerTimeout()) {
+                p.conn->onTimerTimeoutFired();
+                return;
+            }
+        }
+
         LOG_FATAL(log::Arg{name_, uuid_.toShortString()},
             log::Arg{"could not read ready socket"sv},
             log::Arg{"unknown socket"sv});
@@ -175,19 +243,36 @@ void WorkerSession::socketReady(zmq::Pollable* pble)
 }
 
 
-void WorkerSession::connClose()
+std::list<std::string> WorkerSession::sliceEndpoints(const std::vector<std::string>& endp,
+    size_t idx, size_t count)
+{
+    const auto first = endp.begin() + std::min(idx, endp.size());
+    const auto last = idx + 1 < count ? std::next(first, first != endp.end()) : endp.end();
+
+    return {first, last};
+}
+
+
+void WorkerSession::connClose(size_t idx)
 {
     // close
-    zdelivery_->close();
-    zdispatch_->close();
+    path_[idx].zdelivery->close();
+    path_[idx].zdispatch->close();
 }
 
 
-void WorkerSession::connOpen()
+void WorkerSession::connOpen(size_t idx)
 {
+    auto& p = path_[idx];
+
     // configure
-    zdelivery_->setEndpoints({conf_.endpDelivery.begin(), conf_.endpDelivery.end()});
-    zdispatch_->setEndpoints({conf_.endpDispatch.begin(), conf_.endpDispatch.end()});
+    p.zdelivery->setEndpoints(sliceEndpoints(conf_.endpDelivery, idx, pathCount_));
+    p.zdispatch->setEndpoints(sliceEndpoints(conf_.endpDispatch, idx, pathCount_));
+
+    for (auto* s : {p.zdelivery.get(), p.zdispatch.get()}) {
+        s->setHighWaterMark(conf_.hwmSend, conf_.hwmRecv);
+        s->setBufferSize(conf_.bufSend, conf_.bufRecv);
+    }
 
     std::set<std::string> groups{{SessionEnv::BrokerHugz.data(), SessionEnv::BrokerHugz.size()}};
 
@@ -203,46 +288,114 @@ void WorkerSession::connOpen()
         groups.insert(SessionEnv::BrokerUpdt.data());
     }
 
-    zdelivery_->setGroups({groups.begin(), groups.end()});
+    p.zdelivery->setGroups({groups.begin(), groups.end()});
 
     // connect
-    zdelivery_->connect();
-    zdispatch_->connect();
+    p.zdelivery->connect();
+    p.zdispatch->connect();
 }
 
 
-void WorkerSession::snapClose()
+void WorkerSession::snapClose(int idx)
 {
-    zsnapshot_->close();
+    zsnapshot_[idx]->close();
 }
 
 
-void WorkerSession::snapOpen()
+void WorkerSession::snapOpen(int idx)
 {
-    zsnapshot_->setEndpoints({conf_.endpSnapshot.begin(), conf_.endpSnapshot.end()});
-    zsnapshot_->connect();
+    zsnapshot_[idx]->setEndpoints(sliceEndpoints(conf_.endpSnapshot, idx, sync_->maxIndex() + 1));
+    zsnapshot_[idx]->setHighWaterMark(conf_.hwmSend, conf_.hwmRecv);
+    zsnapshot_[idx]->setBufferSize(conf_.bufSend, conf_.bufRecv);
+    zsnapshot_[idx]->connect();
 }
 
 
-void WorkerSession::sendAnnounce()
+void WorkerSession::sendAnnounce(size_t idx)
 {
-    zdispatch_->send(zmq::Part{}.withGroup(SessionEnv::WorkerHugz.data()));
+    uint8_t flags = 0;
+    if (path_[idx].conn->state() != ConnMachine::State::Stable)
+        flags |= SessionEnv::WorkerHugzAnnounce;
+    if (!conf_.topicsAll)
+        flags |= SessionEnv::WorkerHugzFiltered;
+
+    auto& p = path_[idx];
+    p.hugzNonce = ++hugzNonce_;
+
+    const auto stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+
+    p.zdispatch->send(zmq::PartMulti::pack(flags, conf_.uuid.bytes(), p.hugzNonce, uint64_t(stamp.count()))
+                          .withGroup(SessionEnv::WorkerHugz.data()));
 }
 
 
-void WorkerSession::sendSync(uint8_t syncseq)
+void WorkerSession::sendDispatch(zmq::Part&& part)
+{
+    const auto isStable = [](const Path& p) {
+        return p.conn->state() == ConnMachine::State::Stable;
+    };
+
+    std::array<Path*, PathSockets> dest;
+    auto last = dest.begin();
+
+    for (size_t i = 0; i < pathCount_; ++i) {
+        if (isStable(path_[i]))
+            *last++ = &path_[i];
+    }
+
+    // dispatch through every path, when none of them is stable.
+    const bool any = last != dest.begin();
+    if (!any) {
+        for (size_t i = 0; i < pathCount_; ++i)
+            *last++ = &path_[i];
+    }
+
+    // lower round trip time first, not yet measured paths last.
+    const auto rank = [](const Path* p) {
+        const auto rtt = p->conn->roundTrip();
+        return rtt == std::chrono::nanoseconds::zero() ? std::chrono::nanoseconds::max() : rtt;
+    };
+    std::stable_sort(dest.begin(), last, [&rank](const Path* a, const Path* b) {
+        return rank(a) < rank(b);
+    });
+
+    // last path gets the original message, the others a copy.
+    for (auto it = dest.begin(); it != last; ++it) {
+        if (std::next(it) != last)
+            (*it)->zdispatch->send(zmq::Part{part});
+        else
+            (*it)->zdispatch->send(std::move(part));
+
+        // data sent through a path which is not stable doesn't prove it.
+        if (any)
+            (*it)->conn->onDataSent();
+    }
+}
+
+
+void WorkerSession::sendSync(int idx, uint8_t syncseq)
 {
     static_assert(std::is_same_v<SyncMachine::seqn_t, decltype(syncseq)>);
 
     LOG_DEBUG(log::Arg{name_, uuid_.toShortString()},
         log::Arg{"snapshot"sv, "request"sv},
+        log::Arg{"index"sv, idx},
         log::Arg{"status"sv, Event::toString(Event::Type::SyncRequest)});
 
     auto conf = conf_;
     conf.seqNum = seqNum_;
     auto params = conf.toPart();
 
-    zsnapshot_->trySend(zmq::PartMulti::pack(SessionEnv::BrokerSyncReqst, syncseq, zmq::Part{params}));
+    zsnapshot_[idx]->trySend(zmq::PartMulti::pack(SessionEnv::BrokerSyncReqst, syncseq, zmq::Part{params}));
+
+    // a raced request is sent to every socket, starting from the first one.
+    if (idx != 0)
+        return;
+
+    if (sync_->retryCount() > 0)
+        metrics_->syncRetries.add();
+
     sendEvent(Event::Type::SyncRequest, std::move(params));
 }
 
@@ -263,22 +416,45 @@ void WorkerSession::saveConfiguration(const zmq::Part& part)
         }
     }
 
+    conflTopic_.clear();
+    for (const auto& name : conf_.topicsConflated)
+        conflTopic_.put(name, true);
+
     seqNum_ = conf_.seqNum;
 }
 
 
-void WorkerSession::collectBrokerMessage(zmq::Part&& payload)
+void WorkerSession::collectBrokerMessage(size_t idx, zmq::Part&& payload)
 {
     const std::string_view group(payload.group());
 
     if (group == SessionEnv::BrokerHugz) {
-        // TODO: check whether payload corresponds to the dispatched probe.
-        //       in this case we are sure the full round trip works.
-        conn_->onPing();
+        collectBrokerHugz(idx, payload);
 
     } else if (group == SessionEnv::BrokerUpdt || subscrTopic_.find(group) != subscrTopic_.list().end()) {
-        if (acceptTopic(payload))
-            sendEvent(Event::Type::Delivery, std::move(payload));
+        path_[idx].conn->onData();
+
+        if (!acceptTopic(payload, path_[idx].conn.get())) {
+            metrics_->discarded.add();
+            return;
+        }
+
+        if (Topic::isTraced(payload)) {
+            Topic::withTraceStamp(payload, Topic::Hop::Delivered, Topic::traceNow());
+            recordTrace(Topic::fromPart(payload));
+        }
+
+        metrics_->delivered.add();
+
+        if (handler_) {
+            callDeliveryHandler(TopicView{payload});
+            return;
+        }
+
+        if (conflateDelivery(payload))
+            return;
+
+        sendEvent(Event::Type::Delivery, std::move(payload));
 
     } else {
         LOG_WARN(log::Arg{name_, uuid_.toShortString()},
@@ -289,11 +465,55 @@ void WorkerSession::collectBrokerMessage(zmq::Part&& payload)
 }
 
 
-void WorkerSession::recvBrokerSnapshot(zmq::Part&& payload)
+void WorkerSession::collectBrokerHugz(size_t idx, const zmq::Part& payload)
+{
+    auto& p = path_[idx];
+
+    if (payload.empty()) {
+        p.conn->onPing();
+        return;
+    }
+
+    const auto [workers, load, topics, worker, nonce, stamp] = zmq::PartMulti::unpack<uint32_t,
+        uint64_t, uint64_t, Uuid::Bytes, uint64_t, uint64_t>(payload);
+
+    metrics_->brokerWorkers.set(workers);
+    metrics_->brokerLoad.set(load);
+    metrics_->brokerTopics.set(topics);
+
+    const auto echo = Uuid::fromBytes(worker);
+
+    if (echo.isNull()) {
+        p.conn->onPing();
+        return;
+    }
+
+    if (echo != conf_.uuid || nonce != p.hugzNonce) {
+        p.conn->onData();
+        return;
+    }
+
+    const auto rtt = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::nanoseconds(stamp);
+
+    metrics_->keepaliveLatency.record(rtt);
+    p.conn->onRoundTrip(rtt);
+
+    // echo of an announcement proves the round trip, too.
+    if (p.conn->state() != ConnMachine::State::Stable)
+        p.conn->onPing();
+    else
+        p.conn->onData();
+}
+
+
+void WorkerSession::recvBrokerSnapshot(int idx, zmq::Part&& payload)
 {
     auto [reply, syncseq, params] = zmq::PartMulti::unpack<std::string_view, SyncMachine::seqn_t, zmq::Part>(payload);
 
     if (reply == SessionEnv::BrokerSyncBegin) {
+        if (sync_->onReply(idx, syncseq, SyncMachine::ReplyType::Begin) != SyncMachine::ReplyResult::Accepted)
+            return;
+
         brokerUuid_ = Uuid::fromPart(params);
 
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()},
@@ -304,28 +524,36 @@ void WorkerSession::recvBrokerSnapshot(zmq::Part&& payload)
         sendEvent(Event::Type::SyncBegin, brokerUuid_.toPart());
 
     } else if (reply == SessionEnv::BrokerSyncElemn) {
+        if (sync_->onReply(idx, syncseq, SyncMachine::ReplyType::Snapshot) != SyncMachine::ReplyResult::Accepted)
+            return;
+
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()},
             log::Arg{"snapshot"sv, "recv"sv},
             log::Arg{"broker", brokerUuid_.toShortString()},
             log::Arg{"status"sv, Event::toString(Event::Type::SyncElement)});
 
-        acceptTopic(params);
+        metrics_->syncElements.add();
+        acceptTopic(params, nullptr);
         sendEvent(Event::Type::SyncElement, std::move(params));
-        sync_->onReply(0, syncseq, SyncMachine::ReplyType::Snapshot);
 
     } else if (reply == SessionEnv::BrokerSyncCompl) {
-        if (const auto uuid = Uuid::fromPart(params); uuid != brokerUuid_) {
+        // broker uuid must be updated before the transition to synced.
+        const auto uuid = Uuid::fromPart(params);
+        const auto prev = std::exchange(brokerUuid_, uuid);
+
+        if (sync_->onReply(idx, syncseq, SyncMachine::ReplyType::Complete) != SyncMachine::ReplyResult::Accepted) {
+            brokerUuid_ = prev;
+            return;
+        }
+
+        if (uuid != prev) {
             LOG_WARN(log::Arg{name_, uuid_.toShortString()},
                 log::Arg{"snapshot"sv, "recv"sv},
-                log::Arg{"old", brokerUuid_.toShortString()},
+                log::Arg{"old", prev.toShortString()},
                 log::Arg{"new", uuid.toShortString()},
                 log::Arg{"err"sv, "broker uuid has changed"sv});
-
-            brokerUuid_ = uuid;
         }
 
-        sync_->onReply(0, syncseq, SyncMachine::ReplyType::Complete);
-
     } else {
         LOG_WARN(log::Arg{name_, uuid_.toShortString()},
             log::Arg{"snapshot"sv, "recv"sv},
@@ -335,15 +563,23 @@ void WorkerSession::recvBrokerSnapshot(zmq::Part&& payload)
 }
 
 
-bool WorkerSession::acceptTopic(const zmq::Part& part)
+bool WorkerSession::acceptTopic(const zmq::Part& part, ConnMachine* conn)
 {
     // TODO: seq num and uuid might be extracted from params without constructing a full Topic.
     const auto t = Topic::fromPart(part);
+    const bool accepted = acceptTopic(t.worker(), t.seqNum());
+
+    cacheTopic(t, accepted, conn == nullptr);
 
-    if (!acceptTopic(t.worker(), t.seqNum()))
+    if (!accepted)
         return false;
 
-    if (t.worker() != conf_.uuid || t.seqNum() <= seqNum_)
+    if (t.worker() != conf_.uuid)
+        return true;
+
+    recordDeliveryLatency(t.seqNum(), conn);
+
+    if (t.seqNum() <= seqNum_)
         return true;
 
     seqNum_ = t.seqNum();
@@ -369,15 +605,100 @@ bool WorkerSession::acceptTopic(const Uuid& worker, Topic::SeqN value)
 }
 
 
+void WorkerSession::cacheTopic(const Topic& t, bool accepted, bool snapshot)
+{
+    if (cache_ == nullptr || t.type() != Topic::State)
+        return;
+
+    if (!accepted && (!snapshot || cache_->contains(std::string_view(t.name()))))
+        return;
+
+    cache_->put(t);
+}
+
+
+bool WorkerSession::conflateDelivery(zmq::Part& payload)
+{
+    if (conflTopic_.empty() || Topic::typeOf(payload) != Topic::State)
+        return false;
+
+    const auto name = Topic::nameOf(payload);
+    if (conflTopic_.find(name) == conflTopic_.list().end())
+        return false;
+
+    // name is copied before moving the payload which owns it.
+    const Topic::Name tn{name};
+
+    if (conflater_->put(token_, tn, std::move(payload)))
+        sendConflatedEvent(std::string_view(tn));
+    else
+        metrics_->conflated.add();
+
+    return true;
+}
+
+
+void WorkerSession::callDeliveryHandler(const TopicView& t) noexcept
+{
+    const auto start = std::chrono::steady_clock::now();
+    handler_(t);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    metrics_->handlerLatency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+
+    if (elapsed > handlerBudget_)
+        metrics_->handlerOverruns.add();
+}
+
+
+void WorkerSession::recordDeliveryLatency(Topic::SeqN value, ConnMachine* conn)
+{
+    auto& [seqn, tp] = dispatchTime_[value % dispatchTime_.size()];
+    if (seqn != value)
+        return;
+
+    const auto latency = std::chrono::steady_clock::now() - tp;
+    metrics_->deliveryLatency.record(latency);
+    seqn = 0;
+
+    if (conn != nullptr)
+        conn->onRoundTrip(latency);
+}
+
+
+void WorkerSession::recordTrace(const Topic& t)
+{
+    auto* const tr = metrics_->trace(std::string_view(t.name()));
+    if (tr == nullptr)
+        return;
+
+    const auto& ts = *t.trace();
+    const auto hop = [&ts](Topic::Hop from, Topic::Hop to) {
+        return std::chrono::nanoseconds(int64_t(ts[size_t(to)] - ts[size_t(from)]));
+    };
+
+    tr->local.record(hop(Topic::Hop::Created, Topic::Hop::Dispatched));
+    tr->upstream.record(hop(Topic::Hop::Dispatched, Topic::Hop::Ingested));
+    tr->broker.record(hop(Topic::Hop::Ingested, Topic::Hop::FannedOut));
+    tr->downstream.record(hop(Topic::Hop::FannedOut, Topic::Hop::Delivered));
+    tr->total.record(hop(Topic::Hop::Created, Topic::Hop::Delivered));
+}
+
+
 void WorkerSession::onConnChanged(int newState)
 {
     static_assert(std::is_same_v<decltype(newState), std::underlying_type_t<ConnMachine::State>>,
         "invalid type of parameter");
 
+    metrics_->connTransitions.add();
+
     switch (ConnMachine::State(newState)) {
     case ConnMachine::State::Halted:
     case ConnMachine::State::Trying:
-        notifyConnectionUpdate(false);
+        // other paths might still be stable.
+        notifyConnectionUpdate(std::any_of(path_.begin(), path_.begin() + pathCount_, [](const Path& p) {
+            return p.conn && p.conn->state() == ConnMachine::State::Stable;
+        }));
         break;
 
     case ConnMachine::State::Stable:
@@ -412,6 +733,7 @@ void WorkerSession::onSyncChanged(int newState)
             log::Arg{"broker", brokerUuid_.toShortString()},
             log::Arg{"status"sv, Event::toString(Event::Type::SyncSuccess)});
 
+        metrics_->syncLatency.record(std::chrono::steady_clock::now() - syncStarted_);
         sendEvent(Event::Type::SyncSuccess, brokerUuid_.toPart());
         notifySnapshotDownload(false);
         break;
@@ -427,6 +749,7 @@ void WorkerSession::onSyncChanged(int newState)
         break;
 
     case SyncMachine::State::Download:
+        syncStarted_ = std::chrono::steady_clock::now();
         notifySnapshotDownload(true);
         break;
     };
@@ -461,14 +784,7 @@ void WorkerSession::notifySnapshotDownload(bool isSync)
 
 void WorkerSession::notifySequenceNumber() const
 {
-    try {
-        if (zseqs_->trySend(zmq::Part{seqNum_}) == -1)
-            throw ERROR(ZMQSocketSendFailed, "socket send would block");
-
-    } catch (const std::exception& e) {
-        LOG_FATAL(log::Arg{"runner"sv}, log::Arg{"could not notify sequence number"sv},
-            log::Arg{std::string_view(e.what())});
-    }
+    state_->seqNum.store(seqNum_, std::memory_order_release);
 }
 
 } // namespace fuurin
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "fuurin/stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace fuurin {
+
+static_assert(Histogram::highestBit(1) == 0);
+static_assert(Histogram::highestBit(UINT64_MAX) == 63);
+static_assert(Histogram::highestBit(1000) == 9);
+static_assert(Histogram::bucketIndex(UINT64_MAX) == Histogram::BucketCount - 1);
+static_assert(Histogram::bucketLowest(Histogram::bucketIndex(1000)) <= 1000);
+static_assert(Histogram::bucketHighest(Histogram::bucketIndex(1000)) >= 1000);
+
+
+uint64_t Histogram::Snapshot::percentile(double q) const noexcept
+{
+    uint64_t total = 0;
+    for (const auto n : buckets)
+        total += n;
+
+    if (total == 0)
+        return 0;
+
+    const uint64_t rank = std::max(uint64_t(1),
+        uint64_t(std::ceil(std::clamp(q, 0.0, 1.0) * double(total))));
+
+    uint64_t acc = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        acc += buckets[i];
+        if (acc >= rank)
+            return std::min(bucketHighest(i), max);
+    }
+
+    return max;
+}
+
+
+double Histogram::Snapshot::mean() const noexcept
+{
+    return count == 0 ? 0.0 : double(sum) / double(count);
+}
+
+
+Histogram::Histogram() noexcept
+    : max_{0}
+{
+}
+
+
+Histogram::Snapshot Histogram::snapshot() const noexcept
+{
+    Snapshot ret;
+
+    ret.count = count_.value();
+    ret.sum = sum_.value();
+    ret.max = max_.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < BucketCount; ++i)
+        ret.buckets[i] = buckets_[i].value();
+
+    return ret;
+}
+
+
+WorkerStats WorkerMetrics::stats() const noexcept
+{
+    return WorkerStats{
+        dispatched.value(),
+        delivered.value(),
+        discarded.value(),
+        syncElements.value(),
+        syncRetries.value(),
+        connTransitions.value(),
+        conflated.value(),
+        dispatchBlocked.value(),
+        dispatchDropped.value(),
+        handlerOverruns.value(),
+        deliveryLatency.snapshot(),
+        syncLatency.snapshot(),
+        keepaliveLatency.snapshot(),
+        handlerLatency.snapshot(),
+        brokerWorkers.value(),
+        brokerLoad.value(),
+        brokerTopics.value(),
+    };
+}
+
+
+WorkerMetrics::Trace* WorkerMetrics::trace(std::string_view name)
+{
+    // only the writer thread modifies the map, so lookup is lock free.
+    if (auto it = traces_.find(name); it != traces_.end())
+        return it->second.get();
+
+    if (traces_.size() >= TraceCapacity)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    return traces_.emplace(std::string(name), std::make_unique<Trace>()).first->second.get();
+}
+
+
+std::vector<TraceStats> WorkerMetrics::traceStats() const
+{
+    std::lock_guard<std::mutex> lock(traceMutex_);
+
+    std::vector<TraceStats> ret;
+    ret.reserve(traces_.size());
+
+    for (const auto& [name, tr] : traces_) {
+        ret.push_back(TraceStats{
+            name,
+            tr->local.snapshot(),
+            tr->upstream.snapshot(),
+            tr->broker.snapshot(),
+            tr->downstream.snapshot(),
+            tr->total.snapshot(),
+        });
+    }
+
+    return ret;
+}
+
+
+BrokerStats BrokerMetrics::stats() const noexcept
+{
+    return BrokerStats{
+        received.value(),
+        dispatched.value(),
+        discarded.value(),
+        syncRequests.value(),
+        syncElements.value(),
+        syncAborts.value(),
+        dropped.value(),
+        peerReceived.value(),
+        storageErrors.value(),
+        dispatchLatency.snapshot(),
+        syncLatency.snapshot(),
+    };
+}
+
+} // namespace fuurin
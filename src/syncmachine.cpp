@@ -39,6 +39,8 @@ SyncMachine::SyncMachine(std::string_view name, Uuid uuid, zmq::Context* zctx,
     , indexNext_{0}
     , retryCurr_{0}
     , seqNum_{0}
+    , racing_{false}
+    , racePend_{false}
 {
     ASSERT(indexMax_ >= 0, "SyncMachine max index cannot be negative");
     ASSERT(retryMax_ >= 0, "SyncMachine max retry cannot be negative");
@@ -94,6 +96,29 @@ int SyncMachine::maxIndex() const noexcept
 }
 
 
+void SyncMachine::setMaxIndex(int index)
+{
+    ASSERT(state_ == State::Halted, "SyncMachine max index changed while not halted");
+    ASSERT(index >= 0, "SyncMachine max index cannot be negative");
+    ASSERT(index < std::numeric_limits<int>::max(), "SyncMachine max index too big");
+
+    indexMax_ = index;
+    setNextIndex(indexCurr_ + 1);
+}
+
+
+void SyncMachine::setRacing(bool enable) noexcept
+{
+    racing_ = enable;
+}
+
+
+bool SyncMachine::isRacing() const noexcept
+{
+    return racing_;
+}
+
+
 void SyncMachine::setNextIndex(int index) noexcept
 {
     if (index < 0)
@@ -141,7 +166,7 @@ void SyncMachine::onHalt()
 
     case State::Download:
     case State::Synced:
-        halt(indexCurr_);
+        halt(indexActive());
         break;
 
     default:
@@ -161,16 +186,21 @@ void SyncMachine::onSync()
 
     switch (state_) {
     case State::Failed:
-        indexCurr_ = indexNext_;
-        setNextIndex(indexCurr_ + 1);
+        if (!racing_) {
+            indexCurr_ = indexNext_;
+            setNextIndex(indexCurr_ + 1);
+        }
         // fallthrough
 
     case State::Halted:
-        sync(-1, indexCurr_);
+        sync(-1, racing_ ? IndexAll : indexCurr_);
         break;
 
     case State::Synced:
-        sync(-1, -1);
+        if (racing_)
+            sync(indexCurr_, IndexAll);
+        else
+            sync(-1, -1);
         break;
 
     default:
@@ -184,10 +214,35 @@ SyncMachine::ReplyResult SyncMachine::onReply(int index, seqn_t seqn, ReplyType
     if (state_ != State::Download)
         return ReplyResult::Unexpected;
 
-    if (index != indexCurr_ || seqn != seqNum_)
+    if (seqn != seqNum_ || index < 0 || index > indexMax_)
+        return ReplyResult::Discarded;
+
+    if (racePend_) {
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"event"sv, "race"sv},
+            log::Arg{"index"sv, index}, log::Arg{"seqn"sv, seqn});
+
+        racePend_ = false;
+        indexCurr_ = index;
+        setNextIndex(indexCurr_ + 1);
+
+        for (int idx = 0; idx <= indexMax_; ++idx) {
+            if (idx != indexCurr_)
+                close(idx);
+        }
+    }
+
+    if (index != indexCurr_)
         return ReplyResult::Discarded;
 
     switch (reply) {
+    case ReplyType::Begin:
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"event"sv, "reply"sv},
+            log::Arg{"index"sv, index}, log::Arg{"seqn"sv, seqn},
+            log::Arg{"type"sv, "begin"sv});
+
+        timerTmo_->start();
+        break;
+
     case ReplyType::Snapshot:
         LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"event"sv, "reply"sv},
             log::Arg{"index"sv, index}, log::Arg{"seqn"sv, seqn},
@@ -221,12 +276,18 @@ void SyncMachine::onTimerTimeoutFired()
     LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"event"sv, "timeout"sv});
 
     if (retryCurr_ + 1 > retryMax_) {
-        fail(indexCurr_);
+        fail(indexActive());
         return;
     }
 
     ++retryCurr_;
-    const auto indexPrev = indexCurr_;
+    const auto indexPrev = indexActive();
+
+    if (racing_) {
+        sync(indexPrev, IndexAll);
+        return;
+    }
+
     indexCurr_ = indexNext_;
     setNextIndex(indexCurr_ + 1);
 
@@ -234,6 +295,12 @@ void SyncMachine::onTimerTimeoutFired()
 }
 
 
+int SyncMachine::indexActive() const noexcept
+{
+    return racePend_ ? IndexAll : indexCurr_;
+}
+
+
 void SyncMachine::halt(int indexClose)
 {
     timerTmo_->stop();
@@ -241,6 +308,7 @@ void SyncMachine::halt(int indexClose)
     seqNum_ = 0;
     retryCurr_ = 0;
     indexCurr_ = 0;
+    racePend_ = false;
     setNextIndex(1);
 
     close(indexClose);
@@ -251,6 +319,7 @@ void SyncMachine::halt(int indexClose)
 void SyncMachine::fail(int indexClose)
 {
     timerTmo_->stop();
+    racePend_ = false;
 
     close(indexClose);
     change(State::Failed);
@@ -262,20 +331,37 @@ void SyncMachine::sync(int indexClose, int indexOpen)
     timerTmo_->start();
 
     ++seqNum_;
+    racePend_ = indexOpen == IndexAll;
 
     change(State::Download);
     close(indexClose);
     open(indexOpen);
 
-    LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"action"sv, "sync"sv},
-        log::Arg{"index"sv, indexCurr_}, log::Arg{"seqn"sv, seqNum_});
+    if (!racePend_) {
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"action"sv, "sync"sv},
+            log::Arg{"index"sv, indexCurr_}, log::Arg{"seqn"sv, seqNum_});
 
-    doSync_(indexCurr_, seqNum_);
+        doSync_(indexCurr_, seqNum_);
+        return;
+    }
+
+    for (int idx = 0; idx <= indexMax_; ++idx) {
+        LOG_DEBUG(log::Arg{name_, uuid_.toShortString()}, log::Arg{"action"sv, "sync"sv},
+            log::Arg{"index"sv, idx}, log::Arg{"seqn"sv, seqNum_});
+
+        doSync_(idx, seqNum_);
+    }
 }
 
 
 void SyncMachine::close(int index)
 {
+    if (index == IndexAll) {
+        for (int idx = 0; idx <= indexMax_; ++idx)
+            close(idx);
+        return;
+    }
+
     if (index < 0)
         return;
 
@@ -288,6 +374,12 @@ void SyncMachine::close(int index)
 
 void SyncMachine::open(int index)
 {
+    if (index == IndexAll) {
+        for (int idx = 0; idx <= indexMax_; ++idx)
+            open(idx);
+        return;
+    }
+
     if (index < 0)
         return;
 
@@ -349,6 +441,9 @@ std::ostream& operator<<(std::ostream& os, const SyncMachine::State& en)
 std::ostream& operator<<(std::ostream& os, const SyncMachine::ReplyType& en)
 {
     switch (en) {
+    case SyncMachine::ReplyType::Begin:
+        os << "begin"sv;
+        break;
     case SyncMachine::ReplyType::Snapshot:
         os << "snapshot"sv;
         break;
@@ -38,6 +38,12 @@ class Timer;
  * the connection is impossible. In this case the next socket
  * is used, by rotating the index value.
  *
+ * In racing mode, see \ref setRacing(bool), a request is sent
+ * to every socket at once. The first socket which replies to the
+ * current request wins the race, it becomes the \ref currentIndex()
+ * and every other socket is closed, so that their replies are
+ * discarded. A retry races again every socket.
+ *
  * The state machine has three states:
  *
  *   - \ref State::Halted.
@@ -71,6 +77,7 @@ public:
      */
     enum struct ReplyType
     {
+        Begin,    ///< Reply of beginning.
         Snapshot, ///< Reply of snapshot.
         Complete, ///< Reply of completion.
     };
@@ -164,6 +171,37 @@ public:
      */
     int maxIndex() const noexcept;
 
+    /**
+     * \brief Sets the maximum value of sockets' index.
+     *
+     * It shall be called only in \ref State::Halted,
+     * the next index is reset accordingly.
+     *
+     * \param[in] index Maximum index of sockets (must NOT be negative).
+     *
+     * \see maxIndex()
+     */
+    void setMaxIndex(int index);
+
+    /**
+     * \brief Enables or disables the racing mode.
+     *
+     * The mode is applied starting from the next request.
+     * By default racing mode is disabled.
+     *
+     * \param[in] enable Whether requests are raced among every socket.
+     *
+     * \see isRacing()
+     */
+    void setRacing(bool enable) noexcept;
+
+    /**
+     * \return Whether racing mode is enabled.
+     *
+     * \see setRacing(bool)
+     */
+    bool isRacing() const noexcept;
+
     /**
      * \brief Sets the next socket index to be used for a request.
      *
@@ -223,6 +261,7 @@ public:
      *
      * The index \ref nextIndex() is used to perform synchronization,
      * and then it becomes the \ref currentIndex().
+     * In racing mode, every index is used instead.
      *
      * \see nextIndex()
      * \see currentIndex()
@@ -237,6 +276,8 @@ public:
      *     which doesn't match \ref currentIndex().
      *   - A reply is discarded if its sequence number
      *     doesn't match \ref sequenceNumber().
+     *   - In racing mode, the first accepted reply sets the
+     *     \ref currentIndex() and every other socket is closed.
      *   - Time \ref timerTimeout() is restarted when
      *     synchronization is not yet completed.
      *   - A transition to \ref State::Synced when
@@ -260,13 +301,19 @@ public:
      *   - A transition to \ref State::Halted happens,
      *     if \ref maxRetry() exceeded.
      *   - the \ref currentIndex() is moved to
-     *     \ref nextIndex()
+     *     \ref nextIndex(), unless in racing mode.
      *   - Synchronization is restarted.
      */
     void onTimerTimeoutFired();
 
 
 private:
+    /**
+     * \return The index to close in order to stop the current request,
+     *      that is \ref IndexAll while racing, otherwise \ref currentIndex().
+     */
+    int indexActive() const noexcept;
+
     /**
      * \brief Halts the state machine.
      *
@@ -289,7 +336,7 @@ private:
      * \brief Sends a synchronization request.
      *
      * \param[in] indexClose Index to close.
-     * \param[in] indexOpen Index to open.
+     * \param[in] indexOpen Index to open, if \ref IndexAll then the request is raced.
      *
      * \see close(int)
      * \see open(int)
@@ -300,7 +347,8 @@ private:
     /**
      * \brief Closes a socket index.
      *
-     * \param[in] index If not -1, then it is closed.
+     * \param[in] index If not negative, then it is closed.
+     *      If \ref IndexAll, then every index is closed.
      *
      * \see doClose_
      */
@@ -309,7 +357,8 @@ private:
     /**
      * \brief Opens a socket index.
      *
-     * \param[in] index If not -1, then it is opened.
+     * \param[in] index If not negative, then it is opened.
+     *      If \ref IndexAll, then every index is opened.
      *
      * \see doOpen_
      */
@@ -326,9 +375,11 @@ private:
 
 
 private:
+    static constexpr int IndexAll = -2; ///< Special index to refer every socket.
+
     const std::string_view name_; ///< Name to identify this state machine.
     const Uuid uuid_;             ///< Uuid to identify this state machine.
-    const int indexMax_;          ///< Maximum sockets' index value.
+    int indexMax_;                ///< Maximum sockets' index value.
     const int retryMax_;          ///< Maximum number of retry attempts.
 
     const CloseFunc doClose_;   ///< Function to close sockets.
@@ -343,6 +394,8 @@ private:
     int indexNext_; ///< Index of current request.
     int retryCurr_; ///< Retry number.
     seqn_t seqNum_; ///< Sequence number of request.
+    bool racing_;   ///< Whether racing mode is enabled.
+    bool racePend_; ///< Whether the current request is being raced.
 };
 
 
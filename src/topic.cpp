@@ -18,6 +18,7 @@
 
 #include <string_view>
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <type_traits>
 
@@ -84,7 +85,8 @@ Topic::Name::operator std::string() const
 
 bool Topic::Name::operator==(const Name& rhs) const
 {
-    return sz_ == rhs.sz_ && dd_ == rhs.dd_;
+    // trailing characters are always zero.
+    return sz_ == rhs.sz_ && std::memcmp(dd_.data(), rhs.dd_.data(), sz_) == 0;
 }
 
 
@@ -94,6 +96,15 @@ bool Topic::Name::operator!=(const Name& rhs) const
 }
 
 
+bool Topic::Name::equals(std::string_view rhs) const noexcept
+{
+    static_assert(std::tuple_size<decltype(dd_)>::value == ZMQ_GROUP_MAX_LENGTH + 1,
+        "topic name capacity differs from ZMQ_GROUP_MAX_LENGTH");
+
+    return std::string_view(dd_.data(), sz_) == rhs.substr(0, capacity());
+}
+
+
 Topic::Topic()
     : seqn_{0}
     , type_{State}
@@ -174,6 +185,12 @@ Topic::Name& Topic::name() noexcept
 }
 
 
+const std::optional<Topic::Trace>& Topic::trace() const noexcept
+{
+    return trace_;
+}
+
+
 const Topic::Data& Topic::data() const noexcept
 {
     return data_;
@@ -256,6 +273,22 @@ Topic& Topic::withData(Data&& v)
 }
 
 
+Topic& Topic::withTrace(const std::optional<Trace>& v)
+{
+    trace_ = v;
+    return *this;
+}
+
+
+Topic& Topic::withTraceStamp(Hop hop, uint64_t v)
+{
+    if (trace_)
+        (*trace_)[size_t(hop)] = v;
+
+    return *this;
+}
+
+
 bool Topic::operator==(const Topic& rhs) const
 {
     return broker_ == rhs.broker_ &&
@@ -272,18 +305,57 @@ bool Topic::operator!=(const Topic& rhs) const
 }
 
 
+namespace {
+/// Size of the packed timestamps of a traced topic.
+constexpr size_t TraceSize = sizeof(Topic::Trace);
+
+/**
+ * \brief Finds the packed timestamps of a topic.
+ *
+ * Timestamps are packed after the topic data, so a topic
+ * which is not traced has no additional trailing data.
+ *
+ * \param[in] part Topic packed data.
+ *
+ * \return Offset of the timestamps, or 0 if the topic is not traced.
+ */
+size_t traceOffset(const zmq::Part& part)
+{
+    const auto data = std::get<5>(zmq::PartMulti::unpack<Topic::SeqN,
+        std::underlying_type_t<Topic::Type>, Uuid::Bytes, Uuid::Bytes,
+        std::string_view, std::string_view>(part));
+
+    const size_t offset = size_t(data.data() + data.size() - part.data());
+    return part.size() == offset + TraceSize ? offset : 0;
+}
+} // namespace
+
+
 Topic Topic::fromPart(const zmq::Part& part)
 {
     auto [seqn, type, brok, work, name, data] = zmq::PartMulti::unpack<SeqN,
         std::underlying_type_t<Type>, Uuid::Bytes, Uuid::Bytes,
         std::string_view, zmq::Part>(part);
 
+    const bool traced = (type & TracedFlag) != 0;
+    type &= ~TracedFlag;
+
     ASSERT(type >= toIntegral(Type::State) &&
             type <= toIntegral(Type::Event),
         "Topic::fromPart: bad topic type");
 
-    return Topic{Uuid::fromBytes(brok), Uuid::fromBytes(work),
+    Topic t{Uuid::fromBytes(brok), Uuid::fromBytes(work),
         std::move(seqn), std::move(name), std::move(data), Type(type)};
+
+    if (const size_t offset = traced ? traceOffset(part) : 0; offset != 0) {
+        Trace trace;
+        for (size_t i = 0; i < trace.size(); ++i)
+            trace[i] = zmq::Part{part.data() + offset + i * sizeof(uint64_t), sizeof(uint64_t)}.toUint64();
+
+        t.trace_ = trace;
+    }
+
+    return t;
 }
 
 
@@ -295,8 +367,16 @@ zmq::Part Topic::toPart() const
             type <= toIntegral(Type::Event),
         "Topic::toPart: bad topic type");
 
-    return zmq::PartMulti::pack(seqn_, type, broker_.bytes(), worker_.bytes(),
-        std::string_view(name_), data_);
+    if (!trace_) {
+        return zmq::PartMulti::pack(seqn_, type, broker_.bytes(), worker_.bytes(),
+            std::string_view(name_), data_);
+    }
+
+    const auto& tr = *trace_;
+    static_assert(std::tuple_size_v<Trace> == 5);
+
+    return zmq::PartMulti::pack(seqn_, uint8_t(type | TracedFlag), broker_.bytes(), worker_.bytes(),
+        std::string_view(name_), data_, tr[0], tr[1], tr[2], tr[3], tr[4]);
 }
 
 
@@ -314,6 +394,74 @@ zmq::Part& Topic::withSeqNum(zmq::Part& part, SeqN val)
 }
 
 
+Topic::Type Topic::typeOf(const zmq::Part& part)
+{
+    // type follows the sequence number.
+    constexpr size_t offset = sizeof(SeqN);
+
+    if (part.size() < offset + sizeof(Type)) {
+        throw ERROR(ZMQPartAccessFailed, "could not access topic multi part type field",
+            log::Arg{std::string_view("reason"), "out of bound access"sv});
+    }
+
+    const auto type = uint8_t(part.data()[offset] & ~TracedFlag);
+
+    ASSERT(type >= toIntegral(Type::State) &&
+            type <= toIntegral(Type::Event),
+        "Topic::typeOf: bad topic type");
+
+    return Type(type);
+}
+
+
+std::string_view Topic::nameOf(const zmq::Part& part)
+{
+    const auto [seqn, type, brok, work, name] = zmq::PartMulti::unpack<SeqN,
+        std::underlying_type_t<Type>, Uuid::Bytes, Uuid::Bytes,
+        std::string_view>(part);
+
+    UNUSED(seqn);
+    UNUSED(type);
+    UNUSED(brok);
+    UNUSED(work);
+
+    return name;
+}
+
+
+bool Topic::isTraced(const zmq::Part& part) noexcept
+{
+    // type follows the sequence number.
+    constexpr size_t offset = sizeof(SeqN);
+
+    return part.size() > offset && (uint8_t(part.data()[offset]) & TracedFlag) != 0;
+}
+
+
+bool Topic::withTraceStamp(zmq::Part& part, Hop hop, uint64_t val)
+{
+    if (!isTraced(part))
+        return false;
+
+    const size_t offset = traceOffset(part);
+    if (offset == 0)
+        return false;
+
+    const zmq::Part buf{val};
+    std::copy_n(buf.data(), buf.size(), part.data() + offset + size_t(hop) * sizeof(uint64_t));
+
+    return true;
+}
+
+
+uint64_t Topic::traceNow() noexcept
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+                        .count());
+}
+
+
 std::ostream& operator<<(std::ostream& os, Topic::Type v)
 {
     switch (v) {
@@ -361,4 +509,10 @@ size_t hash<fuurin::Topic::Name>::operator()(const fuurin::Topic::Name& n) const
     return std::hash<std::string_view>{}(n);
 }
 
+
+size_t hash<fuurin::Topic::Name>::operator()(std::string_view n) const
+{
+    return std::hash<std::string_view>{}(n.substr(0, ZMQ_GROUP_MAX_LENGTH));
+}
+
 } // namespace std
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "topiccache.h"
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace fuurin {
+
+
+TopicCache::TopicCache()
+{
+    static_assert((Shards & (Shards - 1)) == 0, "number of shards must be a power of two");
+
+    shards_.reserve(Shards);
+    for (size_t i = 0; i < Shards; ++i)
+        shards_.emplace_back(std::make_shared<const Map>());
+}
+
+
+TopicCache::~TopicCache() noexcept = default;
+
+
+std::shared_ptr<const TopicCache::Map>& TopicCache::shard(std::string_view name)
+{
+    // high bits, since low bits select the bucket within the shard.
+    const uint64_t h = uint64_t(std::hash<Topic::Name>{}(name)) * 0x9e3779b97f4a7c15ull;
+    return shards_[size_t(h >> 58)];
+}
+
+
+const std::shared_ptr<const TopicCache::Map>& TopicCache::shard(std::string_view name) const
+{
+    return const_cast<TopicCache*>(this)->shard(name);
+}
+
+
+void TopicCache::put(const Topic& t)
+{
+    auto& sh = shard(std::string_view(t.name()));
+    auto topic = std::make_shared<const Topic>(t);
+
+    // writer is the only one which replaces the map.
+    if (const auto it = sh->find(t.name()); it != sh->list().end()) {
+        std::atomic_store(&it->second->topic, std::move(topic));
+        return;
+    }
+
+    auto map = std::make_shared<Map>(*sh);
+    map->put(t.name(), std::make_shared<Slot>(Slot{std::move(topic)}));
+
+    std::atomic_store(&sh, std::shared_ptr<const Map>{std::move(map)});
+}
+
+
+bool TopicCache::contains(std::string_view name) const
+{
+    const auto map = std::atomic_load(&shard(name));
+    return map->find(name) != map->list().end();
+}
+
+
+std::optional<Topic> TopicCache::get(std::string_view name) const
+{
+    const auto map = std::atomic_load(&shard(name));
+
+    const auto it = map->find(name);
+    if (it == map->list().end())
+        return {};
+
+    return {*std::atomic_load(&it->second->topic)};
+}
+
+
+void TopicCache::forEach(std::string_view prefix, const VisitFunc& f) const
+{
+    for (const auto& sh : shards_) {
+        const auto map = std::atomic_load(&sh);
+
+        for (const auto& [name, slot] : map->list()) {
+            if (std::string_view(name).substr(0, prefix.size()) != prefix)
+                continue;
+
+            const auto topic = std::atomic_load(&slot->topic);
+            f(*topic);
+        }
+    }
+}
+
+
+size_t TopicCache::size() const
+{
+    size_t ret = 0;
+    for (const auto& sh : shards_)
+        ret += std::atomic_load(&sh)->size();
+
+    return ret;
+}
+
+} // namespace fuurin
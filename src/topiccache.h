@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef TOPICCACHE_H
+#define TOPICCACHE_H
+
+#include "fuurin/topic.h"
+#include "fuurin/lrucache.h"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+
+namespace fuurin {
+
+/**
+ * \brief Last value cache of topics, by name.
+ *
+ * The cache is written by a single thread, i.e. the worker session,
+ * and it can be read by any thread, without ever blocking the writer.
+ *
+ * Names are partitioned into shards. Every shard is an immutable map,
+ * from name to a slot holding the latest topic. Updating an existing
+ * name atomically replaces the topic of its slot, while adding a new
+ * name copies the shard map and atomically publishes it, RCU style.
+ * Readers only take a reference to the current map and topic, so they
+ * always see a consistent topic, which stays valid after an update.
+ */
+class TopicCache
+{
+public:
+    ///< Function type to visit a topic.
+    using VisitFunc = std::function<void(const Topic&)>;
+
+
+public:
+    /**
+     * \brief Initializes an empty cache.
+     */
+    TopicCache();
+
+    /**
+     * \brief Destructor.
+     */
+    ~TopicCache() noexcept;
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    TopicCache(const TopicCache&) = delete;
+    TopicCache& operator=(const TopicCache&) = delete;
+    ///@}
+
+    /**
+     * \brief Stores the latest value of a topic.
+     *
+     * This method shall be called by the writer thread only.
+     *
+     * \param[in] t Topic to store.
+     */
+    void put(const Topic& t);
+
+    /**
+     * \brief Whether a topic name is stored.
+     *
+     * \param[in] name Topic name.
+     */
+    bool contains(std::string_view name) const;
+
+    /**
+     * \brief Gets the latest value of a topic.
+     *
+     * This method is thread-safe.
+     *
+     * \param[in] name Topic name.
+     *
+     * \return A copy of the topic, if stored.
+     */
+    std::optional<Topic> get(std::string_view name) const;
+
+    /**
+     * \brief Visits every topic which name starts with a prefix.
+     *
+     * This method is thread-safe.
+     * Topics are not visited in any specific order.
+     *
+     * \param[in] prefix Prefix of topic names, empty for every topic.
+     * \param[in] f Function called for every matching topic.
+     */
+    void forEach(std::string_view prefix, const VisitFunc& f) const;
+
+    /**
+     * \return Number of stored topic names.
+     *
+     * This method is thread-safe.
+     */
+    size_t size() const;
+
+
+private:
+    ///< Number of shards, a power of two.
+    static constexpr size_t Shards = 64;
+
+    ///< Holder of the latest topic of a name.
+    struct Slot
+    {
+        std::shared_ptr<const Topic> topic; ///< Latest topic, atomically accessed.
+    };
+
+    ///< Immutable map of a shard.
+    using Map = LRUCache<Topic::Name, std::shared_ptr<Slot>>;
+
+    /**
+     * \return The shard of a name.
+     */
+    ///@{
+    std::shared_ptr<const Map>& shard(std::string_view name);
+    const std::shared_ptr<const Map>& shard(std::string_view name) const;
+    ///@}
+
+
+private:
+    std::vector<std::shared_ptr<const Map>> shards_; ///< Shards, atomically accessed.
+};
+
+} // namespace fuurin
+
+#endif // TOPICCACHE_H
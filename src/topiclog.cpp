@@ -0,0 +1,426 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "topiclog.h"
+#include "fuurin/topic.h"
+#include "fuurin/zmqpart.h"
+#include "fuurin/zmqpartmulti.h"
+#include "fuurin/errors.h"
+#include "types.h"
+#include "log.h"
+
+#include <boost/scope_exit.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+
+using namespace std::literals::string_view_literals;
+
+
+namespace fuurin {
+
+namespace {
+/// Header of the snapshot file.
+constexpr std::string_view SnapshotMagic = "FUURINS1"sv;
+
+/// Type of the size of a record.
+using recsize_t = uint32_t;
+
+
+/**
+ * \brief Parses a topic record.
+ *
+ * \param[in] data Record data.
+ * \param[in] len Record size.
+ *
+ * \return The topic, or nothing if the record is corrupt.
+ */
+std::optional<Topic> parseRecord(const char* data, recsize_t len)
+{
+    const zmq::Part part{data, len};
+
+    try {
+        const auto [seqn, type, brok, work, name, payload] = zmq::PartMulti::unpack<Topic::SeqN,
+            std::underlying_type_t<Topic::Type>, Uuid::Bytes, Uuid::Bytes,
+            std::string_view, std::string_view>(part);
+
+        if ((type & ~Topic::TracedFlag) > toIntegral(Topic::Event))
+            return {};
+
+    } catch (const err::ZMQPartAccessFailed&) {
+        return {};
+    }
+
+    return Topic::fromPart(part);
+}
+
+
+/**
+ * \brief Reads every record from a memory mapped file.
+ *
+ * \param[in] path Path of the file.
+ * \param[in] magic Expected header of the file, it may be empty.
+ * \param[in] onTopic Function called for every topic.
+ *
+ * \exception StorageReadFailed The file could not be read.
+ * \return Number of records, a missing file has no records.
+ */
+size_t readRecords(const std::string& path, std::string_view magic, const TopicLog::LoadFunc& onTopic)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        if (errno == ENOENT)
+            return 0;
+
+        throw ERROR(StorageReadFailed, "could not open file",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{errno}},
+                log::Arg{"path"sv, path},
+            });
+    }
+    BOOST_SCOPE_EXIT(fd)
+    {
+        ::close(fd);
+    };
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1) {
+        throw ERROR(StorageReadFailed, "could not stat file",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{errno}},
+                log::Arg{"path"sv, path},
+            });
+    }
+
+    const size_t size = size_t(st.st_size);
+    if (size <= magic.size())
+        return 0;
+
+    void* const map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        throw ERROR(StorageReadFailed, "could not map file",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{errno}},
+                log::Arg{"path"sv, path},
+            });
+    }
+    BOOST_SCOPE_EXIT(map, size)
+    {
+        ::munmap(map, size);
+    };
+
+    ::madvise(map, size, MADV_SEQUENTIAL);
+
+    const char* const data = static_cast<const char*>(map);
+    size_t count = 0;
+
+    if (std::string_view(data, magic.size()) != magic) {
+        throw ERROR(StorageReadFailed, "could not read file",
+            log::Arg{
+                log::Arg{"reason"sv, "bad header"sv},
+                log::Arg{"path"sv, path},
+            });
+    }
+
+    for (size_t pos = magic.size(); pos + sizeof(recsize_t) <= size;) {
+        recsize_t len;
+        std::memcpy(&len, data + pos, sizeof(len));
+        pos += sizeof(len);
+
+        // ignore truncated record.
+        if (pos + len > size)
+            break;
+
+        // a corrupt length is detected by the record content.
+        auto t = parseRecord(data + pos, len);
+        if (!t) {
+            LOG_WARN(log::Arg{"storage"sv, "load"sv}, log::Arg{"reason"sv, "corrupt record"sv},
+                log::Arg{"path"sv, std::string_view(path)},
+                log::Arg{"offset"sv, uint64_t(pos - sizeof(len))});
+            break;
+        }
+
+        onTopic(std::move(*t));
+        pos += len;
+        ++count;
+    }
+
+    return count;
+}
+
+
+/**
+ * \brief Writes a topic record.
+ *
+ * \param[in] fp File to write to.
+ * \param[in] t Topic to write.
+ *
+ * \return Whether the record was written.
+ */
+bool writeRecord(std::FILE* fp, const Topic& t)
+{
+    const auto& part = t.toPart();
+    const recsize_t len = recsize_t(part.size());
+
+    return std::fwrite(&len, sizeof(len), 1, fp) == 1 &&
+        std::fwrite(part.data(), 1, len, fp) == len;
+}
+
+
+/**
+ * \brief Flushes a file to disk.
+ *
+ * \param[in] fp File to flush.
+ *
+ * \return Whether the file was flushed.
+ */
+bool syncFile(std::FILE* fp)
+{
+    return std::fflush(fp) == 0 && ::fsync(::fileno(fp)) == 0;
+}
+
+
+/**
+ * \brief Serializes a topic record.
+ *
+ * \param[out] buf Buffer to append to.
+ * \param[in] t Topic to write.
+ */
+void writeRecord(std::string* buf, const Topic& t)
+{
+    const auto& part = t.toPart();
+    const recsize_t len = recsize_t(part.size());
+
+    buf->append(reinterpret_cast<const char*>(&len), sizeof(len));
+    buf->append(part.data(), len);
+}
+
+
+/**
+ * \brief Writes a snapshot file.
+ *
+ * The file is written to a temporary path, synced
+ * and then it atomically replaces the old one.
+ *
+ * \param[in] path Path of the snapshot file.
+ * \param[in] buf Whole content of the snapshot.
+ *
+ * \exception StorageWriteFailed The file could not be written.
+ */
+void writeSnapshot(const std::string& path, const std::string& buf)
+{
+    const std::string pathTmp = path + ".tmp";
+
+    std::FILE* fp = std::fopen(pathTmp.c_str(), "wb");
+    if (fp == nullptr) {
+        throw ERROR(StorageWriteFailed, "could not open file",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{errno}},
+                log::Arg{"path"sv, pathTmp},
+            });
+    }
+
+    bool ok = std::fwrite(buf.data(), 1, buf.size(), fp) == buf.size();
+    ok = syncFile(fp) && ok;
+    std::fclose(fp);
+
+    if (!ok || std::rename(pathTmp.c_str(), path.c_str()) == -1) {
+        const int ec = errno;
+        std::remove(pathTmp.c_str());
+
+        throw ERROR(StorageWriteFailed, "could not write snapshot",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{ec}},
+                log::Arg{"path"sv, path},
+            });
+    }
+}
+} // namespace
+
+
+TopicLog::TopicLog(const std::string& path)
+    : path_{path}
+    , pathLog_{path + ".log"}
+    , pathLogOld_{path + ".log.old"}
+    , log_{nullptr}
+    , appended_{0}
+{
+}
+
+
+TopicLog::~TopicLog() noexcept
+{
+    try {
+        waitCompaction();
+    } catch (const std::exception& e) {
+        LOG_ERROR(log::Arg{"storage"sv, "compact"sv}, log::Arg{std::string_view(e.what())});
+    }
+
+    close();
+}
+
+
+const std::string& TopicLog::path() const noexcept
+{
+    return path_;
+}
+
+
+size_t TopicLog::load(const LoadFunc& onTopic)
+{
+    return readRecords(path_, SnapshotMagic, onTopic) +
+        readRecords(pathLogOld_, {}, onTopic) +
+        readRecords(pathLog_, {}, onTopic);
+}
+
+
+void TopicLog::open()
+{
+    if (log_ != nullptr)
+        return;
+
+    log_ = std::fopen(pathLog_.c_str(), "ab");
+    if (log_ == nullptr) {
+        throw ERROR(StorageWriteFailed, "could not open file",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{errno}},
+                log::Arg{"path"sv, pathLog_},
+            });
+    }
+
+    std::setvbuf(log_, nullptr, _IOFBF, BufferSize);
+}
+
+
+void TopicLog::close() noexcept
+{
+    if (log_ == nullptr)
+        return;
+
+    std::fclose(log_);
+    log_ = nullptr;
+}
+
+
+bool TopicLog::isOpen() const noexcept
+{
+    return log_ != nullptr;
+}
+
+
+void TopicLog::append(const Topic& t)
+{
+    if (!writeRecord(log_, t)) {
+        throw ERROR(StorageWriteFailed, "could not append topic",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{errno}},
+                log::Arg{"path"sv, pathLog_},
+            });
+    }
+
+    ++appended_;
+}
+
+
+void TopicLog::flush()
+{
+    if (log_ == nullptr || std::fflush(log_) == 0)
+        return;
+
+    throw ERROR(StorageWriteFailed, "could not flush log",
+        log::Arg{
+            log::Arg{"reason"sv, log::ec_t{errno}},
+            log::Arg{"path"sv, pathLog_},
+        });
+}
+
+
+size_t TopicLog::appended() const noexcept
+{
+    return appended_;
+}
+
+
+void TopicLog::compact(const VisitFunc& visit)
+{
+    waitCompaction();
+
+    std::string buf{SnapshotMagic};
+    visit([&buf](const Topic& t) {
+        writeRecord(&buf, t);
+    });
+
+    rotate();
+
+    compact_ = std::async(std::launch::async, [path = path_, pathOld = pathLogOld_, buf = std::move(buf)]() {
+        writeSnapshot(path, buf);
+
+        // snapshot is committed, rotated log can be discarded.
+        std::remove(pathOld.c_str());
+    });
+}
+
+
+bool TopicLog::isCompacting() const
+{
+    return compact_.valid() &&
+        compact_.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+
+void TopicLog::waitCompaction()
+{
+    if (!compact_.valid())
+        return;
+
+    // future is reset also in case of exception.
+    compact_.get();
+}
+
+
+void TopicLog::rotate()
+{
+    flush();
+    appended_ = 0;
+
+    // a previous compaction failed, so its log is still needed.
+    if (::access(pathLogOld_.c_str(), F_OK) == 0)
+        return;
+
+    const bool wasOpen = isOpen();
+    close();
+
+    if (std::rename(pathLog_.c_str(), pathLogOld_.c_str()) == -1 && errno != ENOENT) {
+        const int ec = errno;
+        if (wasOpen)
+            open();
+
+        throw ERROR(StorageWriteFailed, "could not rotate log",
+            log::Arg{
+                log::Arg{"reason"sv, log::ec_t{ec}},
+                log::Arg{"path"sv, pathLog_},
+            });
+    }
+
+    if (wasOpen)
+        open();
+}
+
+} // namespace fuurin
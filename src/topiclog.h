@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef TOPICLOG_H
+#define TOPICLOG_H
+
+#include <functional>
+#include <future>
+#include <string>
+#include <cstdio>
+
+
+namespace fuurin {
+
+class Topic;
+
+
+/**
+ * \brief Persistent storage of topics.
+ *
+ * Storage is made of two files:
+ *
+ *   - the snapshot file, which contains the compacted state,
+ *     that is the latest topic for every name and worker.
+ *     It's loaded through a memory mapping, so it can be read
+ *     with a single sequential pass and without any buffering.
+ *
+ *   - the log file, i.e. the same path with \c .log suffix,
+ *     where every stored topic is appended to, since the
+ *     latest compaction. Appended topics are buffered,
+ *     until the log is explicitly flushed.
+ *
+ *   - the rotated log file, i.e. the same path with \c .log.old suffix,
+ *     which holds the topics appended before a compaction in progress.
+ *
+ * Every record is made of its size, followed by the packed topic.
+ * A truncated or corrupt record at the end of the log, e.g. after
+ * a crash, is ignored upon loading, together with the following bytes.
+ *
+ * Compaction serializes the state, it rotates the log and then,
+ * in a background thread, it writes a new snapshot file, which
+ * atomically replaces the old one, and it removes the rotated log.
+ * Loading is idempotent with respect to a crash in between, because
+ * topics replayed from the logs are filtered by their sequence number.
+ */
+class TopicLog
+{
+public:
+    ///< Function type to collect a loaded topic.
+    using LoadFunc = std::function<void(Topic&&)>;
+    ///< Function type to write a topic into snapshot.
+    using WriteFunc = std::function<void(const Topic&)>;
+    ///< Function type to visit every topic to compact.
+    using VisitFunc = std::function<void(const WriteFunc&)>;
+
+
+public:
+    /**
+     * \brief Initializes the storage.
+     *
+     * Files are not opened.
+     *
+     * \param[in] path Path of the snapshot file.
+     */
+    explicit TopicLog(const std::string& path);
+
+    /**
+     * \brief Waits for compaction and closes the log file.
+     */
+    ~TopicLog() noexcept;
+
+    /**
+     * Disable copy.
+     */
+    ///@{
+    TopicLog(const TopicLog&) = delete;
+    TopicLog& operator=(const TopicLog&) = delete;
+    ///@}
+
+    /**
+     * \return Path of the snapshot file.
+     */
+    const std::string& path() const noexcept;
+
+    /**
+     * \brief Loads topics from snapshot file and then from log files.
+     *
+     * Missing files are not considered an error.
+     *
+     * \param[in] onTopic Function called for every loaded topic.
+     *
+     * \exception StorageReadFailed Any file could not be read.
+     * \return Number of loaded records.
+     */
+    size_t load(const LoadFunc& onTopic);
+
+    /**
+     * \brief Opens the log file for appending.
+     *
+     * \exception StorageWriteFailed The file could not be opened.
+     */
+    void open();
+
+    /**
+     * \brief Flushes and closes the log file.
+     */
+    void close() noexcept;
+
+    /**
+     * \return Whether the log file is open.
+     */
+    bool isOpen() const noexcept;
+
+    /**
+     * \brief Appends a topic to the log file.
+     *
+     * The record is buffered, so it might not be written
+     * to the file until the next \ref flush().
+     *
+     * \param[in] t Topic to append.
+     *
+     * \exception StorageWriteFailed The topic could not be written.
+     */
+    void append(const Topic& t);
+
+    /**
+     * \brief Writes the buffered records to the log file.
+     *
+     * Records are handed to the operating system, without syncing
+     * the file, so they survive a crash of the process only.
+     *
+     * \exception StorageWriteFailed The records could not be written.
+     */
+    void flush();
+
+    /**
+     * \return Number of records appended since the latest compaction.
+     */
+    size_t appended() const noexcept;
+
+    /**
+     * \brief Starts compacting the storage.
+     *
+     * Every topic passed to the write function by \c visit is serialized
+     * by the calling thread, the log file is rotated and then the new
+     * snapshot file is written by a background thread, so the caller
+     * is not blocked by file I/O. A previous compaction is waited for,
+     * see \ref waitCompaction().
+     *
+     * \param[in] visit Function which writes the whole state.
+     *
+     * \exception StorageWriteFailed The log could not be rotated,
+     *      or the previous compaction failed.
+     * \see isCompacting()
+     */
+    void compact(const VisitFunc& visit);
+
+    /**
+     * \return Whether a compaction is being written in background.
+     */
+    bool isCompacting() const;
+
+    /**
+     * \brief Waits for the latest compaction to complete.
+     *
+     * \exception StorageWriteFailed The snapshot could not be written.
+     */
+    void waitCompaction();
+
+
+private:
+    /**
+     * \brief Rotates the log file, unless a rotated log already exists.
+     *
+     * \exception StorageWriteFailed The log could not be rotated.
+     */
+    void rotate();
+
+
+private:
+    ///< Size of the buffer of the log file.
+    static constexpr size_t BufferSize = 64 * 1024;
+
+    const std::string path_;       ///< Path of the snapshot file.
+    const std::string pathLog_;    ///< Path of the log file.
+    const std::string pathLogOld_; ///< Path of the rotated log file.
+    std::FILE* log_;               ///< Log file.
+    size_t appended_;              ///< Number of appended records.
+    std::future<void> compact_;    ///< Compaction being written in background.
+};
+
+} // namespace fuurin
+
+#endif // TOPICLOG_H
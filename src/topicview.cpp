@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) Contributors as noted in the AUTHORS file.
+ *
+ * This Source Code Form is part of *fuurin* library.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "fuurin/topicview.h"
+#include "fuurin/zmqpart.h"
+#include "fuurin/zmqpartmulti.h"
+#include "failure.h"
+#include "types.h"
+
+#include <type_traits>
+
+
+namespace fuurin {
+
+
+TopicView::TopicView(const zmq::Part& part)
+    : part_{part}
+{
+    auto [seqn, type, brok, work, name, data] = zmq::PartMulti::unpack<Topic::SeqN,
+        std::underlying_type_t<Topic::Type>, Uuid::Bytes, Uuid::Bytes,
+        std::string_view, std::string_view>(part);
+
+    type &= ~Topic::TracedFlag;
+
+    ASSERT(type >= toIntegral(Topic::State) &&
+            type <= toIntegral(Topic::Event),
+        "TopicView: bad topic type");
+
+    seqn_ = seqn;
+    type_ = Topic::Type(type);
+    broker_ = brok;
+    worker_ = work;
+    name_ = name;
+    data_ = data;
+}
+
+
+Uuid TopicView::broker() const
+{
+    return Uuid::fromBytes(broker_);
+}
+
+
+Uuid TopicView::worker() const
+{
+    return Uuid::fromBytes(worker_);
+}
+
+
+Topic::SeqN TopicView::seqNum() const noexcept
+{
+    return seqn_;
+}
+
+
+std::string_view TopicView::name() const noexcept
+{
+    return name_;
+}
+
+
+std::string_view TopicView::data() const noexcept
+{
+    return data_;
+}
+
+
+Topic::Type TopicView::type() const noexcept
+{
+    return type_;
+}
+
+
+Topic TopicView::toTopic() const
+{
+    return Topic::fromPart(part_);
+}
+
+} // namespace fuurin
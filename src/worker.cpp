@@ -13,6 +13,9 @@
 #include "fuurin/zmqpart.h"
 #include "fuurin/workerconfig.h"
 #include "fuurin/sessionworker.h"
+#include "fuurin/sessionstate.h"
+#include "topiccache.h"
+#include "deliveryconflater.h"
 #include "log.h"
 
 #include <chrono>
@@ -27,23 +30,19 @@ namespace fuurin {
 
 Worker::Worker(Uuid id, Topic::SeqN initSequence, const std::string& name)
     : Runner{id, name}
-    , zseqs_(std::make_unique<zmq::Socket>(context(), zmq::Socket::PUSH))
-    , zseqr_(std::make_unique<zmq::Socket>(context(), zmq::Socket::PULL))
-    , seqNum_{initSequence}
+    , metrics_(std::make_unique<WorkerMetrics>())
+    , cache_(std::make_unique<TopicCache>())
+    , confl_(std::make_unique<DeliveryConflater>())
+    , tracing_{false}
+    , syncRacing_{false}
+    , stateCache_{false}
+    , connRetry_{WorkerConfig{}.connRetry}
+    , connTimeout_{WorkerConfig{}.connTimeout}
+    , connKeepalive_{WorkerConfig{}.connKeepalive}
     , subscrAll_{true}
+    , handlerBudget_{100us}
 {
-    // MUST be inproc in order to get instant delivery of messages.
-    zseqs_->setEndpoints({"inproc://worker-seqn"});
-    zseqr_->setEndpoints({"inproc://worker-seqn"});
-
-    zseqs_->setHighWaterMark(1, 1);
-    zseqr_->setHighWaterMark(1, 1);
-
-    zseqs_->setConflate(true);
-    zseqr_->setConflate(true);
-
-    zseqr_->bind();
-    zseqs_->connect();
+    sessionState()->seqNum.store(initSequence, std::memory_order_release);
 }
 
 
@@ -72,6 +71,76 @@ std::tuple<bool, const std::vector<Topic::Name>&> Worker::topicsNames() const
 }
 
 
+void Worker::setTopicsConflated(const std::vector<Topic::Name>& names)
+{
+    conflNames_ = names;
+}
+
+
+const std::vector<Topic::Name>& Worker::topicsConflated() const
+{
+    return conflNames_;
+}
+
+
+void Worker::setTracing(bool enable)
+{
+    tracing_ = enable;
+}
+
+
+bool Worker::tracing() const
+{
+    return tracing_;
+}
+
+
+void Worker::setSyncRacing(bool enable)
+{
+    syncRacing_ = enable;
+}
+
+
+bool Worker::syncRacing() const
+{
+    return syncRacing_;
+}
+
+
+void Worker::setConnectionTimeout(std::chrono::milliseconds retry, std::chrono::milliseconds timeout,
+    std::chrono::milliseconds keepalive)
+{
+    connRetry_ = retry;
+    connTimeout_ = timeout;
+    connKeepalive_ = keepalive;
+}
+
+
+std::tuple<std::chrono::milliseconds, std::chrono::milliseconds, std::chrono::milliseconds>
+Worker::connectionTimeout() const
+{
+    return {connRetry_, connTimeout_, connKeepalive_};
+}
+
+
+void Worker::setStateCache(bool enable)
+{
+    stateCache_ = enable;
+}
+
+
+bool Worker::stateCache() const
+{
+    return stateCache_;
+}
+
+
+bool Worker::hasDeliveryHandler() const
+{
+    return bool(handler_);
+}
+
+
 void Worker::dispatch(Topic::Name name, const Topic::Data& data, Topic::Type type)
 {
     dispatch(name, zmq::Part{data}, type);
@@ -86,15 +155,59 @@ void Worker::dispatch(Topic::Name name, Topic::Data& data, Topic::Type type)
 
 void Worker::dispatch(Topic::Name name, Topic::Data&& data, Topic::Type type)
 {
-    if (!isRunning())
+    if (!isRunning()) {
+        metrics_->dispatchDropped.add();
         return;
+    }
+
+    std::optional<Topic::Trace> trace;
+    if (tracing_)
+        trace = Topic::Trace{Topic::traceNow()};
 
     sendOperation(Operation::Type::Dispatch,
         Topic{Uuid{}, uuid(), Topic::SeqN{}, name, data, type}
+            .withTrace(trace)
             .toPart());
 }
 
 
+Worker::DispatchResult Worker::tryDispatch(Topic::Name name, const Topic::Data& data, Topic::Type type)
+{
+    if (const auto ret = canDispatch(); ret != DispatchResult::Sent)
+        return ret;
+
+    dispatch(name, data, type);
+    return DispatchResult::Sent;
+}
+
+
+Worker::DispatchResult Worker::tryDispatch(Topic::Name name, Topic::Data&& data, Topic::Type type)
+{
+    if (const auto ret = canDispatch(); ret != DispatchResult::Sent)
+        return ret;
+
+    dispatch(name, std::move(data), type);
+    return DispatchResult::Sent;
+}
+
+
+Worker::DispatchResult Worker::canDispatch()
+{
+    if (!isRunning()) {
+        metrics_->dispatchDropped.add();
+        return DispatchResult::NotRunning;
+    }
+
+    const auto hwm = std::get<0>(highWaterMark());
+    if (hwm > 0 && pendingOperations() >= uint64_t(hwm)) {
+        metrics_->dispatchBlocked.add();
+        return DispatchResult::WouldBlock;
+    }
+
+    return DispatchResult::Sent;
+}
+
+
 void Worker::sync()
 {
     if (!isRunning())
@@ -206,14 +319,31 @@ std::optional<Topic> Worker::waitForTopic(std::chrono::milliseconds timeout) con
 
 Topic::SeqN Worker::seqNumber() const
 {
-    // latest message is always available
-    // over the socket, because we are using
-    // inproc transport.
-    zmq::Part r;
-    if (zseqr_->tryRecv(&r) != -1)
-        seqNum_ = r.toUint64();
+    return sessionState()->seqNum.load(std::memory_order_acquire);
+}
+
+
+WorkerStats Worker::stats() const
+{
+    return metrics_->stats();
+}
+
+
+std::vector<TraceStats> Worker::traceStats() const
+{
+    return metrics_->traceStats();
+}
+
 
-    return seqNum_;
+std::optional<Topic> Worker::get(std::string_view name) const
+{
+    return cache_->get(name);
+}
+
+
+void Worker::forEach(std::string_view prefix, const std::function<void(const Topic&)>& f) const
+{
+    cache_->forEach(prefix, f);
 }
 
 
@@ -227,6 +357,16 @@ zmq::Part Worker::prepareConfiguration() const
         endpointDelivery(),
         endpointDispatch(),
         endpointSnapshot(),
+        syncRacing_,
+        connRetry_,
+        connTimeout_,
+        connKeepalive_,
+        conflNames_,
+        std::get<0>(highWaterMark()),
+        std::get<1>(highWaterMark()),
+        std::get<0>(bufferSize()),
+        std::get<1>(bufferSize()),
+        drainBatch(),
     }
         .toPart();
 }
@@ -234,7 +374,14 @@ zmq::Part Worker::prepareConfiguration() const
 
 std::unique_ptr<Session> Worker::createSession() const
 {
-    return makeSession<WorkerSession>(zseqs_.get());
+    return makeSession<WorkerSession>(metrics_.get(), stateCache_ ? cache_.get() : nullptr, confl_.get(),
+        handler_, handlerBudget_);
+}
+
+
+std::optional<zmq::Part> Worker::takeConflatedEvent(SessionEnv::token_t token, std::string_view name) const
+{
+    return confl_->take(token, name);
 }
 
 } // namespace fuurin
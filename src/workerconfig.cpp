@@ -26,7 +26,17 @@ bool WorkerConfig::operator==(const WorkerConfig& rhs) const
         topicsNames == rhs.topicsNames &&
         endpDelivery == rhs.endpDelivery &&
         endpDispatch == rhs.endpDispatch &&
-        endpSnapshot == rhs.endpSnapshot;
+        endpSnapshot == rhs.endpSnapshot &&
+        syncRacing == rhs.syncRacing &&
+        connRetry == rhs.connRetry &&
+        connTimeout == rhs.connTimeout &&
+        connKeepalive == rhs.connKeepalive &&
+        topicsConflated == rhs.topicsConflated &&
+        hwmSend == rhs.hwmSend &&
+        hwmRecv == rhs.hwmRecv &&
+        bufSend == rhs.bufSend &&
+        bufRecv == rhs.bufRecv &&
+        drainBatch == rhs.drainBatch;
 }
 
 
@@ -40,23 +50,44 @@ WorkerConfig WorkerConfig::fromPart(const zmq::Part& part)
 {
     WorkerConfig wc;
 
-    const auto [uuid, seqNum, getall, subscr, endp1, endp2, endp3] = zmq::PartMulti::unpack<
+    const auto [uuid, seqNum, getall, subscr, endp1, endp2, endp3, racing, retry, tmo, alive, conflated,
+        hwmSnd, hwmRcv, bufSnd, bufRcv, drain] = zmq::PartMulti::unpack<
         Uuid::Bytes,
         Topic::SeqN,
         bool,
         zmq::Part,
         zmq::Part,
         zmq::Part,
-        zmq::Part>(part);
+        zmq::Part,
+        bool,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        zmq::Part,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        uint32_t>(part);
 
     wc.uuid = Uuid::fromBytes(uuid);
     wc.seqNum = seqNum;
     wc.topicsAll = getall;
+    wc.syncRacing = racing;
+    wc.connRetry = std::chrono::milliseconds(retry);
+    wc.connTimeout = std::chrono::milliseconds(tmo);
+    wc.connKeepalive = std::chrono::milliseconds(alive);
+    wc.hwmSend = int(hwmSnd);
+    wc.hwmRecv = int(hwmRcv);
+    wc.bufSend = int(bufSnd);
+    wc.bufRecv = int(bufRcv);
+    wc.drainBatch = int(drain);
 
     zmq::PartMulti::unpack<std::string_view>(subscr, std::inserter(wc.topicsNames, wc.topicsNames.begin()));
     zmq::PartMulti::unpack(endp1, std::inserter(wc.endpDelivery, wc.endpDelivery.begin()));
     zmq::PartMulti::unpack(endp2, std::inserter(wc.endpDispatch, wc.endpDispatch.begin()));
     zmq::PartMulti::unpack(endp3, std::inserter(wc.endpSnapshot, wc.endpSnapshot.begin()));
+    zmq::PartMulti::unpack<std::string_view>(conflated, std::inserter(wc.topicsConflated, wc.topicsConflated.begin()));
 
     return wc;
 }
@@ -68,7 +99,17 @@ zmq::Part WorkerConfig::toPart() const
         zmq::PartMulti::pack<std::string_view>(topicsNames.begin(), topicsNames.end()),
         zmq::PartMulti::pack(endpDelivery.begin(), endpDelivery.end()),
         zmq::PartMulti::pack(endpDispatch.begin(), endpDispatch.end()),
-        zmq::PartMulti::pack(endpSnapshot.begin(), endpSnapshot.end()));
+        zmq::PartMulti::pack(endpSnapshot.begin(), endpSnapshot.end()),
+        syncRacing,
+        uint32_t(connRetry.count()),
+        uint32_t(connTimeout.count()),
+        uint32_t(connKeepalive.count()),
+        zmq::PartMulti::pack<std::string_view>(topicsConflated.begin(), topicsConflated.end()),
+        uint32_t(hwmSend),
+        uint32_t(hwmRecv),
+        uint32_t(bufSend),
+        uint32_t(bufRecv),
+        uint32_t(drainBatch));
 }
 
 
@@ -93,7 +134,15 @@ std::ostream& operator<<(std::ostream& os, const WorkerConfig& wc)
     putList(wc.topicsNames) << ", ";
     putList(wc.endpDelivery) << ", ";
     putList(wc.endpDispatch) << ", ";
-    putList(wc.endpSnapshot);
+    putList(wc.endpSnapshot) << ", ";
+    os << (wc.syncRacing ? "race" : "rotate") << ", ";
+    os << wc.connRetry.count() << "ms, ";
+    os << wc.connTimeout.count() << "ms, ";
+    os << wc.connKeepalive.count() << "ms, ";
+    putList(wc.topicsConflated) << ", ";
+    os << wc.hwmSend << "/" << wc.hwmRecv << ", ";
+    os << wc.bufSend << "/" << wc.bufRecv << ", ";
+    os << wc.drainBatch;
     os << "]";
 
     return os;
@@ -55,7 +55,7 @@ void initMessageSize(zmq_msg_t* msg, size_t size)
         throw ERROR(ZMQPartCreateFailed, "could not create message part",
             log::Arg{
                 log::Arg{"reason"sv, log::ec_t{zmq_errno()}},
-                log::Arg{"size"sv, int(size)}, // FIXME: allow size_t/unsigned in Arg
+                log::Arg{"size"sv, uint64_t(size)},
             });
     }
 }
@@ -364,7 +364,7 @@ uint16_t Part::toUint16() const noexcept
     if (size() != 2)
         return 0;
 
-    const char* const d = data();
+    const auto* const d = reinterpret_cast<const uint8_t*>(data());
     return uint16_t(0) |
 #if defined(FUURIN_ENDIANESS_LITTLE)
         (static_cast<uint16_t>(d[1]) << 8) |
@@ -381,7 +381,7 @@ uint32_t Part::toUint32() const noexcept
     if (size() != 4)
         return 0;
 
-    const char* const d = data();
+    const auto* const d = reinterpret_cast<const uint8_t*>(data());
     return uint32_t(0) |
 #if defined(FUURIN_ENDIANESS_LITTLE)
         (static_cast<uint32_t>(d[3]) << 24) |
@@ -402,7 +402,7 @@ uint64_t Part::toUint64() const noexcept
     if (size() != 8)
         return 0;
 
-    const char* const d = data();
+    const auto* const d = reinterpret_cast<const uint8_t*>(data());
     return uint64_t(0) |
 #if defined(FUURIN_ENDIANESS_LITTLE)
         (static_cast<uint64_t>(d[7]) << 56) |
@@ -262,6 +262,32 @@ PollerIterator::value_type PollerIterator::operator*() const noexcept
 PollerWaiter::PollerWaiter() = default;
 PollerWaiter::~PollerWaiter() noexcept = default;
 
+
+PollerEvents PollerWaiter::busyWait(std::chrono::microseconds spin)
+{
+    if (spin.count() <= 0)
+        return wait();
+
+    const auto tmeo = timeout();
+    BOOST_SCOPE_EXIT(this, &tmeo)
+    {
+        setTimeout(tmeo);
+    };
+
+    setTimeout(std::chrono::milliseconds(0));
+
+    const auto deadline = std::chrono::steady_clock::now() + spin;
+    do {
+        const auto ev = wait();
+        if (!ev.empty())
+            return ev;
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    setTimeout(tmeo);
+    return wait();
+}
+
+
 PollerObserver::PollerObserver() = default;
 PollerObserver::~PollerObserver() noexcept = default;
 
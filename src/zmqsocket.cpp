@@ -75,6 +75,8 @@ Socket::Socket(Context* ctx, Type type) noexcept
     , linger_(0ms)
     , hwmsnd_(0)
     , hwmrcv_(0)
+    , bufsnd_(-1)
+    , bufrcv_(-1)
     , conflate_(false)
 {
 }
@@ -138,6 +140,19 @@ std::tuple<int, int> Socket::highWaterMark() const noexcept
 }
 
 
+void Socket::setBufferSize(int snd, int rcv) noexcept
+{
+    bufsnd_ = snd;
+    bufrcv_ = rcv;
+}
+
+
+std::tuple<int, int> Socket::bufferSize() const noexcept
+{
+    return std::make_tuple(bufsnd_, bufrcv_);
+}
+
+
 void Socket::setConflate(bool val) noexcept
 {
     conflate_ = val;
@@ -342,6 +357,8 @@ void Socket::open(std::function<void(std::string)> action)
     setOption(ZMQ_LINGER, getMillis<int>(linger_));
     setOption(ZMQ_SNDHWM, hwmsnd_);
     setOption(ZMQ_RCVHWM, hwmrcv_);
+    setOption(ZMQ_SNDBUF, bufsnd_);
+    setOption(ZMQ_RCVBUF, bufrcv_);
     setOption(ZMQ_CONFLATE, conflate_ ? 1 : 0);
 
     for (const auto& s : subscriptions_)
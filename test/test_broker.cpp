@@ -21,13 +21,20 @@
 #include "fuurin/zmqpart.h"
 #include "fuurin/zmqpartmulti.h"
 #include "fuurin/workerconfig.h"
+#include "fuurin/sessionenv.h"
+#include "fuurin/topic.h"
 #include "fuurin/errors.h"
 #include "fuurin/uuid.h"
+#include "fuurin/logger.h"
+#include "topiclog.h"
 
 #include <string_view>
 #include <chrono>
 #include <memory>
 #include <vector>
+#include <cstdio>
+#include <thread>
+#include <tuple>
 
 
 using namespace fuurin;
@@ -132,7 +139,8 @@ public:
 
     std::unique_ptr<Session> createSession() const override
     {
-        auto ret = makeSession<TestBrokerSession>();
+        const auto [topics, versions, workers] = storageCapacity();
+        auto ret = makeSession<TestBrokerSession>(metrics_.get(), topics, versions, workers);
         const_cast<TestBroker*>(this)->setupSession(static_cast<TestBrokerSession*>(ret.get()));
         return ret;
     }
@@ -273,6 +281,102 @@ BOOST_AUTO_TEST_CASE(testStoreTopicMultiple)
 }
 
 
+BOOST_AUTO_TEST_CASE(testStorageLog)
+{
+    const std::string path = "/tmp/fuurin_broker_storage";
+    std::remove(path.c_str());
+    std::remove((path + ".log").c_str());
+    std::remove((path + ".log.old").c_str());
+
+    Topic t1{Uuid{}, TestBroker::wid, 1, "hello1"sv, zmq::Part{"data1"sv}, Topic::State};
+    Topic t2{Uuid{}, TestBroker::wid, 2, "hello2"sv, zmq::Part{"data2"sv}, Topic::State};
+    Topic t3{Uuid{}, TestBroker::wid, 3, "hello1"sv, zmq::Part{"data3"sv}, Topic::State};
+
+    const auto loadAll = [&path]() {
+        std::vector<Topic> ret;
+        TopicLog l{path};
+        const auto n = l.load([&ret](Topic&& t) { ret.push_back(std::move(t)); });
+        BOOST_TEST(n == ret.size());
+        return ret;
+    };
+
+    // missing files.
+    BOOST_TEST(loadAll().empty());
+
+    // append to log.
+    TopicLog l{path};
+    BOOST_TEST(!l.isOpen());
+    l.open();
+    BOOST_TEST(l.isOpen());
+    l.append(t1);
+    l.append(t2);
+    BOOST_TEST(l.appended() == 2u);
+
+    // appended records are buffered until flush.
+    BOOST_TEST(loadAll().empty());
+    l.flush();
+    BOOST_TEST((loadAll() == std::vector<Topic>{t1, t2}));
+
+    // log is rotated, while snapshot is being written.
+    l.compact([&t2](const TopicLog::WriteFunc& write) { write(t2); });
+    BOOST_TEST(l.appended() == 0u);
+    BOOST_TEST(l.isOpen());
+    l.waitCompaction();
+    BOOST_TEST(!l.isCompacting());
+    BOOST_TEST((loadAll() == std::vector<Topic>{t2}));
+
+    // snapshot and log.
+    l.append(t3);
+    l.flush();
+    BOOST_TEST((loadAll() == std::vector<Topic>{t2, t3}));
+
+    // rotated log is loaded, until compaction completes.
+    l.close();
+    std::rename((path + ".log").c_str(), (path + ".log.old").c_str());
+    l.open();
+    l.append(t1);
+    l.flush();
+    BOOST_TEST((loadAll() == std::vector<Topic>{t2, t3, t1}));
+    l.compact([&t2, &t3](const TopicLog::WriteFunc& write) {
+        write(t2);
+        write(t3);
+    });
+    l.waitCompaction();
+    BOOST_TEST((loadAll() == std::vector<Topic>{t2, t3, t1}));
+    l.compact([&t2, &t3](const TopicLog::WriteFunc& write) {
+        write(t2);
+        write(t3);
+    });
+    l.waitCompaction();
+    BOOST_TEST((loadAll() == std::vector<Topic>{t2, t3}));
+
+    // truncated record.
+    l.close();
+    std::FILE* fp = std::fopen((path + ".log").c_str(), "ab");
+    const char trunc[] = {'\xff', 0, 0, 0, 'a', 'b', 'c'};
+    std::fwrite(trunc, 1, sizeof(trunc), fp);
+    std::fclose(fp);
+    BOOST_TEST((loadAll() == std::vector<Topic>{t2, t3}));
+
+    // corrupt record length, followed by a valid record.
+    std::remove((path + ".log").c_str());
+    l.open();
+    l.append(t3);
+    l.close();
+    fp = std::fopen((path + ".log").c_str(), "r+b");
+    const char corrupt[] = {'\x04', 0, 0, 0};
+    std::fwrite(corrupt, 1, sizeof(corrupt), fp);
+    std::fclose(fp);
+    BOOST_TEST((loadAll() == std::vector<Topic>{t2, t3}));
+
+    // bad snapshot header.
+    fp = std::fopen(path.c_str(), "r+b");
+    std::fwrite("X", 1, 1, fp);
+    std::fclose(fp);
+    BOOST_CHECK_THROW(loadAll(), err::StorageReadFailed);
+}
+
+
 const WorkerConfig cnfAll{{}, {}, true, {}, {}, {}, {}};
 const WorkerConfig cnfNone{{}, {}, false, {}, {}, {}, {}};
 
@@ -387,3 +491,226 @@ BOOST_DATA_TEST_CASE(testReceiverWorkerSync,
 
     b.stop();
 }
+
+
+BOOST_DATA_TEST_CASE(testHugzSkippedByData,
+    bdata::make({
+        std::make_tuple("all topics", uint8_t(0), false),
+        std::make_tuple("filtered topics", SessionEnv::WorkerHugzFiltered, true),
+    }),
+    name, flags, wantHugz)
+{
+    BOOST_TEST_MESSAGE(name);
+
+    Broker b{TestBroker::bid};
+
+    zmq::Context ctx;
+    zmq::Socket disp{&ctx, zmq::Socket::RADIO};
+    zmq::Socket delv{&ctx, zmq::Socket::DISH};
+
+    disp.setEndpoints({"ipc:///tmp/worker_dispatch"});
+    delv.setEndpoints({"ipc:///tmp/worker_delivery"});
+    delv.setGroups({SessionEnv::BrokerHugz.data()});
+
+    auto bf = b.start();
+
+    disp.connect();
+    delv.connect();
+
+    const auto recvHugz = [&delv]() {
+        int n = 0;
+        for (zmq::Part p; delv.tryRecv(&p) != -1;)
+            ++n;
+        return n;
+    };
+
+    Topic::SeqN seqn = 0;
+    const auto dispatchFor = [&disp, &seqn](std::chrono::milliseconds dur) {
+        for (auto i = 0ms; i < dur; i += 100ms) {
+            disp.send(Topic{Uuid{}, TestBroker::wid, ++seqn, "topic"sv, zmq::Part{"data"sv}, Topic::State}
+                          .toPart()
+                          .withGroup(SessionEnv::WorkerUpdt.data()));
+            std::this_thread::sleep_for(100ms);
+        }
+    };
+
+    // announce until the first keepalive is received.
+    int n = 0;
+    for (int i = 0; i < 50 && n == 0; ++i) {
+        disp.send(zmq::PartMulti::pack(uint8_t(flags | SessionEnv::WorkerHugzAnnounce),
+            TestBroker::wid.bytes(), uint64_t(i), uint64_t(0))
+                      .withGroup(SessionEnv::WorkerHugz.data()));
+        std::this_thread::sleep_for(100ms);
+        n = recvHugz();
+    }
+    BOOST_REQUIRE(n > 0);
+
+    // data replaces keepalives, unless topics are filtered.
+    dispatchFor(1500ms);
+    recvHugz();
+    dispatchFor(3000ms);
+    BOOST_TEST((recvHugz() > 0) == wantHugz);
+
+    // without data keepalives are sent.
+    std::this_thread::sleep_for(2500ms);
+    BOOST_TEST(recvHugz() > 0);
+
+    b.stop();
+    bf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testHugzEcho)
+{
+    Broker b{TestBroker::bid};
+
+    zmq::Context ctx;
+    zmq::Socket disp{&ctx, zmq::Socket::RADIO};
+    zmq::Socket delv{&ctx, zmq::Socket::DISH};
+
+    disp.setEndpoints({"ipc:///tmp/worker_dispatch"});
+    delv.setEndpoints({"ipc:///tmp/worker_delivery"});
+    delv.setGroups({SessionEnv::BrokerHugz.data()});
+
+    auto bf = b.start();
+
+    disp.connect();
+    delv.connect();
+
+    disp.send(Topic{Uuid{}, TestBroker::wid, 1, "topic"sv, zmq::Part{"data"sv}, Topic::State}
+                  .toPart()
+                  .withGroup(SessionEnv::WorkerUpdt.data()));
+
+    // send keepalives until the echo is received.
+    bool echoed = false;
+    for (uint64_t i = 1; i <= 50 && !echoed; ++i) {
+        disp.send(zmq::PartMulti::pack(SessionEnv::WorkerHugzAnnounce, TestBroker::wid.bytes(), i, 1000 + i)
+                      .withGroup(SessionEnv::WorkerHugz.data()));
+        std::this_thread::sleep_for(100ms);
+
+        for (zmq::Part p; delv.tryRecv(&p) != -1;) {
+            const auto [workers, load, topics, worker, nonce, stamp] = zmq::PartMulti::unpack<uint32_t,
+                uint64_t, uint64_t, Uuid::Bytes, uint64_t, uint64_t>(p);
+
+            BOOST_TEST(load <= 1u);
+
+            if (Uuid::fromBytes(worker).isNull())
+                continue;
+
+            BOOST_TEST(Uuid::fromBytes(worker) == TestBroker::wid);
+            BOOST_TEST(stamp == 1000 + nonce);
+            BOOST_TEST(workers == 1u);
+            BOOST_TEST(topics <= 1u);
+            echoed = true;
+        }
+    }
+    BOOST_TEST(echoed);
+
+    b.stop();
+    bf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testDrainBatch)
+{
+    Broker b{TestBroker::bid};
+
+    BOOST_TEST(b.drainBatch() == 32);
+    b.setDrainBatch(0);
+    BOOST_TEST(b.drainBatch() == 1);
+    b.setDrainBatch(4);
+    BOOST_TEST(b.drainBatch() == 4);
+
+    zmq::Context ctx;
+    zmq::Socket disp{&ctx, zmq::Socket::RADIO};
+    zmq::Socket delv{&ctx, zmq::Socket::DISH};
+
+    disp.setEndpoints({"ipc:///tmp/worker_dispatch"});
+    delv.setEndpoints({"ipc:///tmp/worker_delivery"});
+    delv.setGroups({"topic"});
+
+    auto bf = b.start();
+
+    disp.connect();
+    delv.connect();
+
+    // wait for connections to be established.
+    std::this_thread::sleep_for(500ms);
+
+    // a burst is ingested by batches, without losing any topic.
+    constexpr Topic::SeqN count = 100;
+    for (Topic::SeqN i = 1; i <= count; ++i) {
+        disp.send(Topic{Uuid{}, TestBroker::wid, i, "topic"sv, zmq::Part{"data"sv}, Topic::State}
+                      .toPart()
+                      .withGroup(SessionEnv::WorkerUpdt.data()));
+    }
+
+    Topic::SeqN last = 0;
+    for (int i = 0; i < 100 && last < count; ++i) {
+        for (zmq::Part p; delv.tryRecv(&p) != -1;) {
+            const auto t = Topic::fromPart(p);
+            BOOST_TEST(t.seqNum() == last + 1);
+            last = t.seqNum();
+        }
+        std::this_thread::sleep_for(50ms);
+    }
+
+    BOOST_TEST(last == count);
+    BOOST_TEST(b.stats().received == count);
+    BOOST_TEST(b.stats().dispatched == count);
+
+    b.stop();
+    bf.get();
+}
+
+
+static void BM_BrokerIngest(benchmark::State& state)
+{
+    constexpr int burst = 256;
+
+    log::Logger::setLevel(log::Level::Warn);
+
+    Broker b{TestBroker::bid};
+    b.setDrainBatch(int(state.range(0)));
+
+    zmq::Context ctx;
+    zmq::Socket disp{&ctx, zmq::Socket::RADIO};
+    disp.setEndpoints({"ipc:///tmp/worker_dispatch"});
+
+    auto bf = b.start();
+    disp.connect();
+
+    std::this_thread::sleep_for(500ms);
+
+    Topic::SeqN seqn = 0;
+    const auto topic = Topic{Uuid{}, TestBroker::wid, 0, "topic"sv, zmq::Part{"data"sv}, Topic::State};
+
+    for (auto _ : state) {
+        const auto recv = b.stats().received;
+
+        for (int i = 0; i < burst; ++i) {
+            disp.send(Topic{topic}
+                          .withSeqNum(++seqn)
+                          .toPart()
+                          .withGroup(SessionEnv::WorkerUpdt.data()));
+        }
+
+        // a burst stays within high water marks, so nothing is dropped.
+        while (b.stats().received < recv + burst)
+            std::this_thread::yield();
+    }
+
+    state.SetItemsProcessed(state.iterations() * burst);
+
+    b.stop();
+    bf.get();
+
+    log::Logger::setLevel(log::Level::Debug);
+}
+BENCHMARK(BM_BrokerIngest)->ArgName("drain")->Arg(1)->Arg(32)->UseRealTime();
+
+
+BOOST_AUTO_TEST_CASE(bench, *utf::disabled())
+{
+    ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -838,3 +838,39 @@ BOOST_AUTO_TEST_CASE(testCWorker_eventFD)
 
     CWorker_delete(w);
 }
+
+
+BOOST_AUTO_TEST_CASE(testCWorker_stats, *utf::timeout(15))
+{
+    CBroker* b = CBroker_new(CUuid_createRandomUuid(), "broker");
+    BOOST_REQUIRE(b != nullptr);
+    CBroker_start(b);
+
+    CWorker* w = CWorker_new(CUuid_createRandomUuid(), 0, "test");
+    BOOST_REQUIRE(w != nullptr);
+    CWorker_start(w);
+    BOOST_REQUIRE(CWorker_waitForOnline(w, 5000));
+
+    CWorker_dispatch(w, "topic1", "hello1", 6, TopicState);
+    BOOST_REQUIRE(CWorker_waitForTopic(w, 5000) != nullptr);
+
+    const CWorkerStats ws = CWorker_stats(w);
+    BOOST_TEST(ws.dispatched == 1ull);
+    BOOST_TEST(ws.delivered == 1ull);
+    BOOST_TEST(ws.deliveryLatency.count == 1ull);
+    BOOST_TEST(ws.deliveryLatency.p50 == ws.deliveryLatency.max);
+    BOOST_TEST(ws.deliveryLatency.max > 0ull);
+
+    const CBrokerStats bs = CBroker_stats(b);
+    BOOST_TEST(bs.received == 1ull);
+    BOOST_TEST(bs.dispatched == 1ull);
+    BOOST_TEST(bs.dispatchLatency.count == 1ull);
+
+    CWorker_stop(w);
+    CWorker_wait(w);
+    CWorker_delete(w);
+
+    CBroker_stop(b);
+    CBroker_wait(b);
+    CBroker_delete(b);
+}
@@ -15,8 +15,15 @@
 
 #include "fuurin/fuurin.h"
 #include "fuurin/lrucache.h"
+#include "fuurin/concurrentlrucache.h"
+#include "fuurin/stats.h"
+#include "fuurin/topic.h"
 
 #include <ostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 
 using namespace std::literals;
@@ -169,3 +176,211 @@ BOOST_AUTO_TEST_CASE(testLRUCache)
     BOOST_TEST(d1.size() == 0u);
     BOOST_TEST(d1.empty());
 }
+
+
+BOOST_AUTO_TEST_CASE(testLRUCacheMove)
+{
+    using PtrCache = LRUCache<std::string, std::unique_ptr<int>>;
+
+    PtrCache c{2};
+
+    // put: move only value
+    auto p = std::make_unique<int>(1);
+    const auto raw = p.get();
+    c.put("a", std::move(p));
+    BOOST_TEST(c.find("a")->second.get() == raw);
+
+    // emplace: value constructed in place
+    c.emplace("b", new int{2});
+    BOOST_TEST(*c.find("b")->second == 2);
+
+    // emplace: update item
+    c.emplace("a", new int{3});
+    BOOST_TEST(*c.list().back().second == 3);
+    BOOST_TEST(c.list().front().first == "b");
+
+    // emplace: add item, over capacity
+    c.emplace("c", new int{4});
+    BOOST_TEST(c.size() == 2u);
+    BOOST_TEST((c.find("b") == c.list().end()));
+
+    // get: item is moved out
+    auto el = c.get("c");
+    BOOST_TEST(el.has_value());
+    BOOST_TEST(*el->second == 4);
+    BOOST_TEST(c.size() == 1u);
+
+    // move constructor
+    PtrCache c2{std::move(c)};
+    BOOST_TEST(c.empty());
+    BOOST_TEST(c2.size() == 1u);
+    BOOST_TEST(*c2.find("a")->second == 3);
+
+    // nodes are reused after clear
+    c2.clear();
+    for (int i = 0; i < 10; ++i)
+        c2.emplace(std::to_string(i), new int{i});
+    BOOST_TEST(c2.size() == 2u);
+    BOOST_TEST(*c2.list().front().second == 8);
+    BOOST_TEST(*c2.list().back().second == 9);
+}
+
+
+BOOST_AUTO_TEST_CASE(testLRUCacheHeterogeneous)
+{
+    LRUCache<Topic::Name, int> c{4};
+
+    c.put(Topic::Name{"topic/a"sv}, 1);
+    c.put(Topic::Name{"topic/b"sv}, 2);
+
+    // find by string view
+    const auto it = c.find("topic/a"sv);
+    BOOST_TEST((it != c.list().end()));
+    BOOST_TEST(it->second == 1);
+    BOOST_TEST((c.find("topic/x"sv) == c.list().end()));
+
+    // truncated names
+    const std::string longName(300, 'x');
+    c.put(Topic::Name{longName}, 3);
+    BOOST_TEST((c.find(std::string_view(longName)) != c.list().end()));
+    BOOST_TEST(std::hash<Topic::Name>{}(Topic::Name{longName}) ==
+        std::hash<Topic::Name>{}(std::string_view(longName)));
+
+    // get by string view
+    auto el = c.get("topic/b"sv);
+    BOOST_TEST(el.has_value());
+    BOOST_TEST(el->second == 2);
+    BOOST_TEST(c.size() == 2u);
+
+    // copy constructor keeps order
+    const auto c2 = c;
+    BOOST_TEST((c2 == c));
+}
+
+
+BOOST_AUTO_TEST_CASE(testConcurrentLRUCache)
+{
+    ConcurrentLRUCache<Topic::Name, int> c{5, 2};
+
+    BOOST_TEST(c.shards() == 8u);
+    BOOST_TEST(c.capacity() == 2u);
+    BOOST_TEST(c.empty());
+
+    // put and find
+    c.put(Topic::Name{"topic/a"sv}, 1);
+    c.emplace(Topic::Name{"topic/b"sv}, 2);
+    BOOST_TEST(c.size() == 2u);
+    BOOST_TEST(c.find("topic/a"sv).value() == 1);
+    BOOST_TEST(!c.find("topic/x"sv).has_value());
+
+    // update
+    c.put(Topic::Name{"topic/a"sv}, 3);
+    BOOST_TEST(c.size() == 2u);
+    BOOST_TEST(c.find(Topic::Name{"topic/a"sv}).value() == 3);
+
+    // visit
+    int got = 0;
+    BOOST_TEST(c.visit("topic/b"sv, [&got](int v) { got = v; }));
+    BOOST_TEST(got == 2);
+    BOOST_TEST(!c.visit("topic/x"sv, [](int) {}));
+
+    // get
+    auto el = c.get("topic/b"sv);
+    BOOST_TEST(el.has_value());
+    BOOST_TEST(el->second == 2);
+    BOOST_TEST(c.size() == 1u);
+
+    // per shard capacity
+    for (int i = 0; i < 1000; ++i)
+        c.put(Topic::Name{"topic/" + std::to_string(i)}, i);
+    BOOST_TEST(c.size() <= c.shards() * c.capacity());
+
+    size_t count = 0;
+    c.forEach([&count](const auto&) { ++count; });
+    BOOST_TEST(count == c.size());
+
+    c.clear();
+    BOOST_TEST(c.empty());
+
+    // concurrent access
+    ConcurrentLRUCache<std::string, int> cc{16, 64};
+    std::vector<std::thread> th;
+    for (int t = 0; t < 4; ++t) {
+        th.emplace_back([&cc, t]() {
+            for (int i = 0; i < 10000; ++i) {
+                const auto k = std::to_string((i * 7 + t) % 512);
+                switch (i % 4) {
+                case 0:
+                    cc.put(k, i);
+                    break;
+                case 3:
+                    cc.get(k);
+                    break;
+                default:
+                    cc.find(k);
+                    break;
+                }
+            }
+        });
+    }
+    for (auto& t : th)
+        t.join();
+
+    BOOST_TEST(cc.size() <= cc.shards() * cc.capacity());
+}
+
+
+BOOST_AUTO_TEST_CASE(testHistogramBuckets)
+{
+    // exact buckets
+    for (uint64_t v = 0; v < Histogram::SubCount; ++v) {
+        BOOST_TEST(Histogram::bucketIndex(v) == v);
+        BOOST_TEST(Histogram::bucketLowest(v) == v);
+        BOOST_TEST(Histogram::bucketHighest(v) == v);
+    }
+
+    // contiguous buckets
+    for (size_t i = 0; i + 1 < Histogram::BucketCount; ++i) {
+        BOOST_TEST(Histogram::bucketHighest(i) + 1 == Histogram::bucketLowest(i + 1));
+        BOOST_TEST(Histogram::bucketIndex(Histogram::bucketLowest(i)) == i);
+        BOOST_TEST(Histogram::bucketIndex(Histogram::bucketHighest(i)) == i);
+    }
+    BOOST_TEST(Histogram::bucketHighest(Histogram::BucketCount - 1) == UINT64_MAX);
+
+    // relative error
+    for (uint64_t v : {9ull, 100ull, 12345ull, 1000000007ull, 1ull << 62}) {
+        const auto i = Histogram::bucketIndex(v);
+        const auto err = Histogram::bucketHighest(i) - Histogram::bucketLowest(i);
+        BOOST_TEST(err * Histogram::SubCount <= v);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(testHistogramPercentile)
+{
+    Histogram h;
+
+    auto s = h.snapshot();
+    BOOST_TEST(s.count == 0u);
+    BOOST_TEST(s.percentile(0.5) == 0u);
+    BOOST_TEST(s.mean() == 0.0);
+
+    for (uint64_t v = 1; v <= 1000; ++v)
+        h.record(v);
+    h.record(std::chrono::microseconds(1));
+    h.record(std::chrono::nanoseconds(-1));
+
+    s = h.snapshot();
+    BOOST_TEST(s.count == 1002u);
+    BOOST_TEST(s.sum == 500500u + 1000u);
+    BOOST_TEST(s.max == 1000u);
+    BOOST_TEST(s.buckets[0] == 1u);
+
+    const auto p50 = s.percentile(0.5);
+    BOOST_TEST(p50 >= 500u);
+    BOOST_TEST(p50 <= 500u + 500u / Histogram::SubCount);
+
+    BOOST_TEST(s.percentile(0) == 0u);
+    BOOST_TEST(s.percentile(1) == 1000u);
+    BOOST_TEST(s.percentile(0.999) == 1000u);
+}
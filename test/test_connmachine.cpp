@@ -316,6 +316,107 @@ BOOST_AUTO_TEST_CASE(testOnTimerTimeoutInStable)
 }
 
 
+/**
+ * DATA
+ */
+BOOST_AUTO_TEST_CASE(testOnDataInTrying)
+{
+    auto [conn, test] = setupConn();
+    conn.onStart();
+    conn.timerTimeout()->stop();
+
+    conn.onData();
+    test({ConnMachine::State::Trying}, 2, 1, 1, true, false);
+}
+
+
+BOOST_AUTO_TEST_CASE(testOnDataInStable)
+{
+    auto [conn, test] = setupConn();
+    conn.onStart();
+    conn.onPing();
+    conn.timerTimeout()->stop();
+
+    conn.onData();
+    test({ConnMachine::State::Trying, ConnMachine::State::Stable},
+        2, 1, 2, false, true);
+}
+
+
+BOOST_AUTO_TEST_CASE(testOnDataSentSkipsPong)
+{
+    auto [conn, test] = setupConn();
+    conn.onStart();
+    conn.onDataSent();
+    conn.onPing();
+    test({ConnMachine::State::Trying, ConnMachine::State::Stable},
+        2, 1, 2, false, true);
+
+    conn.onDataSent();
+    conn.onPing();
+    test({ConnMachine::State::Trying, ConnMachine::State::Stable},
+        2, 1, 2, false, true);
+
+    conn.onPing();
+    test({ConnMachine::State::Trying, ConnMachine::State::Stable},
+        2, 1, 3, false, true);
+}
+
+
+/**
+ * ROUND TRIP
+ */
+BOOST_AUTO_TEST_CASE(testRoundTripFixedTimeout)
+{
+    zmq::Context ctx;
+    ConnMachine conn{"conn"sv, Uuid{}, &ctx, 500ms, 3s, []() {}, []() {}, []() {}, [](ConnMachine::State) {}};
+
+    BOOST_TEST(conn.roundTrip().count() == 0);
+    BOOST_TEST(conn.timeout().count() == 3000);
+
+    conn.onRoundTrip(10ms);
+    BOOST_TEST(conn.roundTrip().count() == std::chrono::nanoseconds(10ms).count());
+    BOOST_TEST(conn.timeout().count() == 3000);
+}
+
+
+BOOST_AUTO_TEST_CASE(testRoundTripAdaptiveTimeout)
+{
+    zmq::Context ctx;
+    ConnMachine conn{"conn"sv, Uuid{}, &ctx, 500ms, 3s, []() {}, []() {}, []() {}, [](ConnMachine::State) {}};
+
+    conn.setKeepalive(1s);
+    BOOST_TEST(conn.timeout().count() == 3000);
+
+    // rto is at least 200ms.
+    conn.onRoundTrip(10ms);
+    BOOST_TEST(conn.timeout().count() == 1200);
+
+    // srtt = 33.75ms, rttvar = 51.25ms.
+    conn.onRoundTrip(200ms);
+    BOOST_TEST(conn.roundTrip().count() == 33750000);
+    BOOST_TEST(conn.timeout().count() == 1000 + 239);
+
+    // capped to maximum timeout.
+    conn.onRoundTrip(5s);
+    BOOST_TEST(conn.timeout().count() == 3000);
+
+    conn.setIntervals(100ms, 10s);
+    BOOST_TEST(conn.timeout().count() > 3000);
+    BOOST_TEST(conn.timerRetry()->interval().count() == 100);
+
+    // halt resets estimates.
+    conn.onStart();
+    conn.onStop();
+    BOOST_TEST(conn.roundTrip().count() == 0);
+    BOOST_TEST(conn.timeout().count() == 10000);
+
+    conn.setKeepalive(0ms);
+    conn.onRoundTrip(10ms);
+    BOOST_TEST(conn.timeout().count() == 10000);
+}
+
+
 /**
  * CONSUME TIMERS
  */
@@ -31,6 +31,10 @@
 #include <errno.h>
 #include <thread>
 #include <ostream>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <limits>
 
 
 using namespace std::literals;
@@ -146,6 +150,208 @@ BOOST_DATA_TEST_CASE(silentLogContentHandler,
 }
 
 
+namespace {
+class CollectHandler : public log::Handler
+{
+public:
+    void debug(const log::Loc& l, const log::Arg a[], size_t n) const override { collect(l, a, n); }
+    void info(const log::Loc& l, const log::Arg a[], size_t n) const override { collect(l, a, n); }
+    void warn(const log::Loc& l, const log::Arg a[], size_t n) const override { collect(l, a, n); }
+    void error(const log::Loc& l, const log::Arg a[], size_t n) const override { collect(l, a, n); }
+    void fatal(const log::Loc& l, const log::Arg a[], size_t n) const override { collect(l, a, n); }
+
+    std::vector<std::string> lines() const
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        return out;
+    }
+
+    std::atomic<bool> hold{false};
+    std::atomic<int> delay{0};
+
+private:
+    void collect(const log::Loc&, const log::Arg a[], size_t n) const
+    {
+        while (hold)
+            std::this_thread::yield();
+        if (delay)
+            std::this_thread::sleep_for(std::chrono::microseconds(delay));
+
+        std::stringstream ss;
+        log::printArgs(ss, a, n);
+
+        std::lock_guard<std::mutex> lk(mtx);
+        out.push_back(ss.str());
+    }
+
+    mutable std::mutex mtx;
+    mutable std::vector<std::string> out;
+};
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(asyncLogContentHandler)
+{
+    auto sink = new CollectHandler;
+    auto hndl = new log::AsyncHandler(sink);
+    log::Logger::installContentHandler(hndl);
+
+    const log::Loc loc{"test_file", 1};
+    const auto logThread = [&loc](int id) {
+        for (int i = 0; i < 100; ++i) {
+            // temporary strings are copied into the record.
+            const std::string name = "thread_" + std::to_string(id);
+            const log::Arg v[] = {log::Arg{"num"sv, i}, log::Arg{"ec"sv, log::ec_t{EINVAL}}};
+            const log::Arg a[] = {
+                log::Arg{name, std::string(20, 'x')},
+                log::Arg{"val"sv, v},
+                log::Arg{"dbl"sv, 1.5},
+                log::Arg{},
+            };
+            log::Logger::info(loc, a, std::size(a));
+        }
+    };
+
+    std::vector<std::thread> th;
+    for (int i = 0; i < 3; ++i)
+        th.emplace_back(logThread, i);
+    logThread(3);
+    for (auto& t : th)
+        t.join();
+
+    hndl->flush();
+
+    BOOST_TEST((hndl->overflow() == log::AsyncHandler::Overflow::Drop));
+    BOOST_TEST(hndl->written() + hndl->dropped() == 400u);
+
+    const auto& lines = sink->lines();
+    BOOST_TEST(lines.size() == hndl->written());
+
+    // order is preserved for each thread.
+    for (int id = 0; id < 4; ++id) {
+        int next = 0;
+        for (const auto& l : lines) {
+            std::stringstream ss;
+            const log::Arg v[] = {log::Arg{"num"sv, next}, log::Arg{"ec"sv, log::ec_t{EINVAL}}};
+            const log::Arg a[] = {
+                log::Arg{"thread_" + std::to_string(id), std::string(20, 'x')},
+                log::Arg{"val"sv, v},
+                log::Arg{"dbl"sv, 1.5},
+                log::Arg{},
+            };
+            log::printArgs(ss, a, std::size(a));
+            if (l == ss.str())
+                ++next;
+        }
+        BOOST_TEST(next > 0);
+    }
+
+    log::Logger::installContentHandler(new log::StandardHandler);
+}
+
+
+BOOST_DATA_TEST_CASE(asyncLogOverflow,
+    bdata::make({false, true}),
+    block)
+{
+    const auto policy = block ? log::AsyncHandler::Overflow::Block : log::AsyncHandler::Overflow::Drop;
+
+    auto sink = new CollectHandler;
+    log::AsyncHandler hndl(sink, policy, 256);
+
+    const log::Loc loc{"test_file", 1};
+    const log::Arg a[] = {log::Arg{"key"sv, "some value to log"sv}};
+
+    if (policy == log::AsyncHandler::Overflow::Drop)
+        sink->hold = true;
+    else
+        sink->delay = 100;
+
+    for (int i = 0; i < 50; ++i)
+        hndl.warn(loc, a, std::size(a));
+
+    sink->hold = false;
+    hndl.flush();
+
+    if (policy == log::AsyncHandler::Overflow::Drop) {
+        BOOST_TEST(hndl.dropped() > 0u);
+    } else {
+        BOOST_TEST(hndl.dropped() == 0u);
+    }
+    BOOST_TEST(hndl.written() + hndl.dropped() == 50u);
+    BOOST_TEST(sink->lines().size() == hndl.written());
+}
+
+
+BOOST_AUTO_TEST_CASE(asyncLogThreadExit)
+{
+    auto sink = new CollectHandler;
+    log::AsyncHandler hndl(sink);
+
+    const log::Loc loc{"test_file", 1};
+    const log::Arg a[] = {log::Arg{"key"sv, "value"sv}};
+
+    // rings of exited threads are reused.
+    for (int i = 0; i < 20; ++i)
+        std::thread([&]() { hndl.info(loc, a, std::size(a)); }).join();
+
+    BOOST_TEST(hndl.rings() == 1u);
+
+    // record is written without waiting for the polling interval.
+    const auto t0 = std::chrono::steady_clock::now();
+    hndl.info(loc, a, std::size(a));
+    while (hndl.written() < 21u)
+        std::this_thread::yield();
+
+    BOOST_TEST((std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(5)));
+    BOOST_TEST(hndl.rings() == 1u);
+    BOOST_TEST(sink->lines().size() == 21u);
+}
+
+
+BOOST_AUTO_TEST_CASE(logLevelThreshold)
+{
+    auto sink = new CollectHandler;
+    log::Logger::installContentHandler(sink);
+
+    int evals = 0;
+    const auto value = [&evals]() {
+        ++evals;
+        return evals;
+    };
+
+    BOOST_TEST((log::Logger::level() == log::Level::Debug));
+    BOOST_TEST(log::Logger::isEnabled(log::Level::Debug));
+
+    log::Logger::setLevel(log::Level::Error);
+    BOOST_TEST((log::Logger::level() == log::Level::Error));
+    BOOST_TEST(!log::Logger::isEnabled(log::Level::Debug));
+    BOOST_TEST(!log::Logger::isEnabled(log::Level::Info));
+    BOOST_TEST(!log::Logger::isEnabled(log::Level::Warn));
+    BOOST_TEST(log::Logger::isEnabled(log::Level::Error));
+    BOOST_TEST(log::Logger::isEnabled(log::Level::Fatal));
+
+    // disabled levels don't evaluate arguments.
+    LOG_DEBUG(log::Arg{"val"sv, value()});
+    LOG_INFO(log::Arg{"val"sv, value()});
+    LOG_WARN(log::Arg{"val"sv, value()});
+    BOOST_TEST(evals == 0);
+    BOOST_TEST(sink->lines().empty());
+
+    LOG_ERROR(log::Arg{"val"sv, value()});
+    BOOST_TEST(evals == 1);
+    BOOST_TEST(sink->lines().size() == 1u);
+
+    // fatal level can't be disabled.
+    log::Logger::setLevel(log::Level::Fatal);
+    BOOST_TEST(log::Logger::isEnabled(log::Level::Fatal));
+    BOOST_TEST(!log::Logger::isEnabled(log::Level::Error));
+
+    log::Logger::setLevel(log::Level::Debug);
+    log::Logger::installContentHandler(new log::StandardHandler);
+}
+
+
 BOOST_AUTO_TEST_CASE(formatLog)
 {
     BOOST_TEST("test_fun: test_msg1" == log::format("test_fun: %s%d", "test_msg", 1));
@@ -174,6 +380,8 @@ BOOST_DATA_TEST_CASE(logArgType,
     bdata::make({
         std::make_tuple(log::Arg::Type::Invalid, "key1"sv, 0, 0.0, "0"sv, ""s, false, 0),
         std::make_tuple(log::Arg::Type::Int, "key2"sv, 10, 0.0, "0"sv, ""s, false, 0),
+        std::make_tuple(log::Arg::Type::Int64, "key2.2"sv, -20, 0.0, "0"sv, ""s, false, 0),
+        std::make_tuple(log::Arg::Type::UInt64, "key2.3"sv, 30, 0.0, "0"sv, ""s, false, 0),
         std::make_tuple(log::Arg::Type::Errno, "key2.1"sv, ENOENT, 0.0, "0"sv, ""s, false, 0),
         std::make_tuple(log::Arg::Type::Double, "key3"sv, 0, 10.0, "0"sv, ""s, false, 0),
         std::make_tuple(log::Arg::Type::String, "key4"sv, 0, 0.0, "charval"sv, ""s, false, 0),
@@ -197,6 +405,20 @@ BOOST_DATA_TEST_CASE(logArgType,
         testArg(a, argType, argKey, argInt, 0, std::string_view(), 1, 0);
         break;
     }
+    case log::Arg::Type::Int64: {
+        log::Arg a{argKey, int64_t(argInt)};
+        BOOST_TEST((a.type() == argType));
+        BOOST_TEST(a.toInt64() == argInt);
+        BOOST_TEST(a.refCount() == 0u);
+        break;
+    }
+    case log::Arg::Type::UInt64: {
+        log::Arg a{argKey, uint64_t(argInt)};
+        BOOST_TEST((a.type() == argType));
+        BOOST_TEST(a.toUInt64() == uint64_t(argInt));
+        BOOST_TEST(a.refCount() == 0u);
+        break;
+    }
     case log::Arg::Type::Errno: {
         log::Arg a{argKey, log::ec_t{argInt}};
         testArg(a, argType, argKey, argInt, 0, "No such file or directory"sv, 1, 0);
@@ -350,6 +572,47 @@ BOOST_AUTO_TEST_CASE(logArgCopyStringStack)
 }
 
 
+BOOST_AUTO_TEST_CASE(logArgCopyStringStackMax)
+{
+    const std::string val(log::Arg::MaxStringStackSize, 'a');
+
+    log::Arg a{"key"sv, val};
+    testArg(a, log::Arg::Type::String, "key"sv, 0, 0, val, 1, 0);
+
+    log::Arg b = a;
+    testArg(b, log::Arg::Type::String, "key"sv, 0, 0, val, 1, 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(logArgInt64)
+{
+    const int64_t i64 = std::numeric_limits<int64_t>::min();
+    const uint64_t u64 = std::numeric_limits<uint64_t>::max();
+
+    const log::Arg a{"k1"sv, i64};
+    BOOST_TEST((a.type() == log::Arg::Type::Int64));
+    BOOST_TEST(a.key() == "k1"sv);
+    BOOST_TEST(a.toInt64() == i64);
+    BOOST_TEST(a.count() == 1u);
+    BOOST_TEST(a.refCount() == 0u);
+
+    const log::Arg b{"k2"sv, u64};
+    BOOST_TEST((b.type() == log::Arg::Type::UInt64));
+    BOOST_TEST(b.key() == "k2"sv);
+    BOOST_TEST(b.toUInt64() == u64);
+    BOOST_TEST(b.count() == 1u);
+    BOOST_TEST(b.refCount() == 0u);
+
+    const log::Arg c{"k3"sv, -5};
+    BOOST_TEST(c.toInt64() == -5);
+    BOOST_TEST(c.toUInt64() == uint64_t(-5));
+
+    std::ostringstream os;
+    os << log::Arg{"arr"sv, {a, b}};
+    BOOST_TEST(os.str() == "arr: k1: " + std::to_string(i64) + ", k2: " + std::to_string(u64));
+}
+
+
 BOOST_DATA_TEST_CASE(logArgShareAtomic,
     bdata::make({
         log::Arg::Type::String,
@@ -452,6 +715,36 @@ static void BM_LogArgArray(benchmark::State& state)
 }
 BENCHMARK(BM_LogArgArray);
 
+static void BM_LogDisabled(benchmark::State& state)
+{
+    log::Logger::installContentHandler(new log::SilentHandler);
+    log::Logger::setLevel(log::Level::Warn);
+
+    const std::string group = "group";
+
+    for (auto _ : state)
+        LOG_INFO(log::Arg{"name"sv, "session"sv}, log::Arg{"delivery"sv},
+            log::Arg{"group"sv, std::string(group)}, log::Arg{"size"sv, int(state.iterations())});
+
+    log::Logger::setLevel(log::Level::Debug);
+    log::Logger::installContentHandler(new log::StandardHandler);
+}
+BENCHMARK(BM_LogDisabled);
+
+static void BM_LogSilent(benchmark::State& state)
+{
+    log::Logger::installContentHandler(new log::SilentHandler);
+
+    const std::string group = "group";
+
+    for (auto _ : state)
+        LOG_WARN(log::Arg{"name"sv, "session"sv}, log::Arg{"delivery"sv},
+            log::Arg{"group"sv, std::string(group)}, log::Arg{"size"sv, int(state.iterations())});
+
+    log::Logger::installContentHandler(new log::StandardHandler);
+}
+BENCHMARK(BM_LogSilent);
+
 BOOST_AUTO_TEST_CASE(bench, *utf::disabled())
 {
     ::benchmark::RunSpecifiedBenchmarks();
@@ -27,6 +27,7 @@
 #include <memory>
 #include <future>
 #include <string_view>
+#include <thread>
 
 
 using namespace fuurin;
@@ -377,3 +378,93 @@ BOOST_AUTO_TEST_CASE(testDispatchTwoBrokers)
     w1f.get();
     w2f.get();
 }
+
+
+BOOST_AUTO_TEST_CASE(testPeerBrokers)
+{
+    // Setup w1 bound to b1 and w2 bound to b2, brokers are peers.
+    Broker b1{Uuid::createNamespaceUuid(Uuid::Ns::Dns, "broker1.net"sv)};
+    Broker b2{Uuid::createNamespaceUuid(Uuid::Ns::Dns, "broker2.net"sv)};
+    Worker w1{Uuid::createNamespaceUuid(Uuid::Ns::Dns, "worker1.net"sv)};
+    Worker w2{Uuid::createNamespaceUuid(Uuid::Ns::Dns, "worker2.net"sv)};
+
+    b1.setEndpoints(
+        {"ipc:///tmp/delivery_b1"},
+        {"ipc:///tmp/dispatch_b1"},
+        {"ipc:///tmp/snapshot_b1"});
+    b2.setEndpoints(
+        {"ipc:///tmp/delivery_b2"},
+        {"ipc:///tmp/dispatch_b2"},
+        {"ipc:///tmp/snapshot_b2"});
+    b1.setPeerEndpoints({"ipc:///tmp/dispatch_b2"}, {"ipc:///tmp/snapshot_b2"});
+    b2.setPeerEndpoints({"ipc:///tmp/dispatch_b1"}, {"ipc:///tmp/snapshot_b1"});
+    w1.setEndpoints(
+        {"ipc:///tmp/delivery_b1"},
+        {"ipc:///tmp/dispatch_b1"},
+        {"ipc:///tmp/snapshot_b1"});
+    w2.setEndpoints(
+        {"ipc:///tmp/delivery_b2"},
+        {"ipc:///tmp/dispatch_b2"},
+        {"ipc:///tmp/snapshot_b2"});
+
+    auto b1f = b1.start();
+    auto w1f = w1.start();
+    BOOST_TEST(w1.waitForOnline(5s));
+
+    // topic is stored by b1 only.
+    auto t1 = Topic{{}, w1.uuid(), 1, "topic1"sv, zmq::Part{"hello1"sv}, Topic::State};
+    w1.dispatch(t1.name(), t1.data());
+    testWaitForTopic(w1, t1.withBroker(b1.uuid()), t1.seqNum());
+
+    // b2 downloads the snapshot from b1.
+    auto b2f = b2.start();
+    auto w2f = w2.start();
+    BOOST_TEST(w2.waitForOnline(5s));
+
+    w2.sync();
+    const auto opt = w2.waitForTopic(5s);
+    BOOST_TEST(opt.has_value());
+    BOOST_TEST(opt.value() == t1.withBroker(b2.uuid()));
+
+    // topic is forwarded from b2 to b1, and it's not looped back.
+    auto t2 = Topic{{}, w2.uuid(), 1, "topic2"sv, zmq::Part{"hello2"sv}, Topic::State};
+    w2.dispatch(t2.name(), t2.data());
+    const auto op2 = w2.waitForTopic(5s);
+    BOOST_TEST(op2.has_value());
+    BOOST_TEST(op2.value() == t2.withBroker(b2.uuid()));
+    testWaitForTopic(w1, t2.withBroker(b1.uuid()), t2.seqNum());
+    BOOST_TEST(!w2.waitForTopic(500ms).has_value());
+
+    // topics of peers are counted apart from topics of workers.
+    BOOST_TEST(b1.stats().received == 1u);
+    BOOST_TEST(b2.stats().received == 1u);
+    BOOST_TEST(b1.stats().peerReceived >= 1u);
+    BOOST_TEST(b2.stats().peerReceived >= 1u);
+
+    w2.stop();
+    BOOST_TEST(w2.waitForStopped());
+    w2f.get();
+
+    // b1 requests a snapshot again, once b2 reconnects after it expired.
+    b2.stop();
+    b2f.get();
+    std::this_thread::sleep_for(4s);
+
+    const auto syncRequests = b2.stats().syncRequests;
+    b2f = b2.start();
+
+    for (int i = 0; i < 50 && b2.stats().syncRequests == syncRequests; ++i)
+        std::this_thread::sleep_for(100ms);
+
+    BOOST_TEST(b2.stats().syncRequests == syncRequests + 1);
+
+    b1.stop();
+    b2.stop();
+    w1.stop();
+
+    BOOST_TEST(w1.waitForStopped());
+
+    b1f.get();
+    b2f.get();
+    w1f.get();
+}
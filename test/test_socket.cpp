@@ -173,6 +173,22 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(partEndianessInt, T, partIntTypes)
 }
 
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(partHighBitInt, T, partIntTypes)
+{
+    const T val = T(0x80F0E0D0C0B0A090ull);
+    const Part m{val};
+
+    if constexpr (sizeof(T) == 1)
+        testPartIntValue(&m, val, 0, 0, 0);
+    else if constexpr (sizeof(T) == 2)
+        testPartIntValue(&m, 0, val, 0, 0);
+    else if constexpr (sizeof(T) == 4)
+        testPartIntValue(&m, 0, 0, val, 0);
+    else
+        testPartIntValue(&m, 0, 0, 0, val);
+}
+
+
 BOOST_AUTO_TEST_CASE(partEndianessArray)
 {
     std::string val{networkDataBuf, networkDataBuf + sizeof(networkDataBuf)};
@@ -974,6 +990,43 @@ BOOST_AUTO_TEST_CASE(waitForEventOpen)
 }
 
 
+BOOST_AUTO_TEST_CASE(pollerBusyWait)
+{
+    Context ctx;
+    Socket s1{&ctx, Socket::Type::PAIR};
+    Socket s2{&ctx, Socket::Type::PAIR};
+
+    s1.setEndpoints({"inproc://transfer1"});
+    s2.setEndpoints({"inproc://transfer1"});
+
+    s2.bind();
+    s1.connect();
+
+    Poller poll{PollerEvents::Type::Read, &s2};
+    poll.setTimeout(100ms);
+
+    // nothing to read, spin and then wait for the timeout.
+    auto t0 = std::chrono::steady_clock::now();
+    BOOST_TEST(poll.busyWait(50ms).empty());
+    BOOST_TEST((std::chrono::steady_clock::now() - t0 >= 150ms));
+    BOOST_TEST((poll.timeout() == 100ms));
+
+    // ready socket is returned while spinning.
+    s1.send(Part{uint8_t(1)});
+    t0 = std::chrono::steady_clock::now();
+    BOOST_TEST(poll.busyWait(50ms).size() == 1u);
+    BOOST_TEST((std::chrono::steady_clock::now() - t0 < 100ms));
+    BOOST_TEST((poll.timeout() == 100ms));
+
+    // no spin is like waiting.
+    BOOST_TEST(poll.busyWait(0us).size() == 1u);
+
+    Part p;
+    s2.recv(&p);
+    BOOST_TEST(poll.busyWait(0us).empty());
+}
+
+
 BOOST_AUTO_TEST_CASE(pollerOpenSockets)
 {
     Context ctx;
@@ -1083,12 +1136,16 @@ BOOST_AUTO_TEST_CASE(socketProps)
 
     BOOST_TEST(s.linger() == 0s);
     BOOST_TEST(s.highWaterMark() == std::make_tuple(0, 0));
+    BOOST_TEST(s.bufferSize() == std::make_tuple(-1, -1));
 
     s.setLinger(10s);
     BOOST_TEST(s.linger() == 10s);
 
     s.setHighWaterMark(1000, 2000);
     BOOST_TEST(s.highWaterMark() == std::make_tuple(1000, 2000));
+
+    s.setBufferSize(65536, 131072);
+    BOOST_TEST(s.bufferSize() == std::make_tuple(65536, 131072));
 }
 
 
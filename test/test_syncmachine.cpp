@@ -489,6 +489,104 @@ BOOST_AUTO_TEST_CASE(testOnTimeoutInFailed)
 }
 
 
+/**
+ * RACE
+ */
+BOOST_AUTO_TEST_CASE(testRaceOnSyncInHalted)
+{
+    auto [mach, test] = setupMach(2, 1);
+    mach.setRacing(true);
+    BOOST_TEST(mach.isRacing());
+
+    mach.onSync();
+    test({SS::Download}, {{0, 1}, {1, 1}, {2, 1}}, {{0, 1}, {1, 1}, {2, 1}}, {{0, 1}, {1, 1}, {2, 1}},
+        true, 0, 1, 0, 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(testRaceOnReplyWinner)
+{
+    auto [mach, test] = setupMach(2, 1);
+    mach.setRacing(true);
+    mach.onSync();
+
+    BOOST_TEST(mach.onReply(1, 2, RT::Begin) == RR::Discarded);
+    BOOST_TEST(mach.onReply(1, 1, RT::Begin) == RR::Accepted);
+    BOOST_TEST(mach.onReply(0, 1, RT::Begin) == RR::Discarded);
+    BOOST_TEST(mach.onReply(2, 1, RT::Snapshot) == RR::Discarded);
+    BOOST_TEST(mach.onReply(1, 1, RT::Snapshot) == RR::Accepted);
+    test({SS::Download}, {{0, 2}, {1, 1}, {2, 2}}, {{0, 1}, {1, 1}, {2, 1}}, {{0, 1}, {1, 1}, {2, 1}},
+        true, 1, 2, 0, 1);
+
+    BOOST_TEST(mach.onReply(1, 1, RT::Complete) == RR::Accepted);
+    test({SS::Download, SS::Synced}, {{0, 2}, {1, 1}, {2, 2}}, {{0, 1}, {1, 1}, {2, 1}}, {{0, 1}, {1, 1}, {2, 1}},
+        false, 1, 2, 0, 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(testRaceOnSyncInSynced)
+{
+    auto [mach, test] = setupMach(1, 1);
+    mach.setRacing(true);
+    mach.onSync();
+    mach.onReply(1, 1, RT::Begin);
+    mach.onReply(1, 1, RT::Complete);
+    BOOST_TEST(mach.state() == SS::Synced);
+
+    mach.onSync();
+    test({SS::Download, SS::Synced, SS::Download}, {{0, 2}, {1, 2}}, {{0, 2}, {1, 2}}, {{0, 2}, {1, 2}},
+        true, 1, 0, 0, 2);
+}
+
+
+BOOST_AUTO_TEST_CASE(testRaceOnTimeout)
+{
+    auto [mach, test] = setupMach(1, 1);
+    mach.setRacing(true);
+    mach.onSync();
+
+    mach.onTimerTimeoutFired();
+    test({SS::Download}, {{0, 2}, {1, 2}}, {{0, 2}, {1, 2}}, {{0, 2}, {1, 2}},
+        true, 0, 1, 1, 2);
+
+    mach.onTimerTimeoutFired();
+    test({SS::Download, SS::Failed}, {{0, 3}, {1, 3}}, {{0, 2}, {1, 2}}, {{0, 2}, {1, 2}},
+        false, 0, 1, 1, 2);
+
+    mach.onSync();
+    test({SS::Download, SS::Failed, SS::Download}, {{0, 3}, {1, 3}}, {{0, 3}, {1, 3}}, {{0, 3}, {1, 3}},
+        true, 0, 1, 0, 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(testRaceOnHalt)
+{
+    auto [mach, test] = setupMach(1, 1);
+    mach.setRacing(true);
+    mach.onSync();
+
+    mach.onHalt();
+    test({SS::Download, SS::Halted}, {{0, 2}, {1, 2}}, {{0, 1}, {1, 1}}, {{0, 1}, {1, 1}},
+        false, 0, 1, 0, 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(testSetMaxIndex)
+{
+    auto [mach, test] = setupMach(0, 1);
+    BOOST_TEST(!mach.isRacing());
+    BOOST_TEST(mach.maxIndex() == 0);
+
+    mach.setMaxIndex(3);
+    BOOST_TEST(mach.maxIndex() == 3);
+    BOOST_TEST(mach.nextIndex() == 1);
+
+    mach.setMaxIndex(0);
+    BOOST_TEST(mach.maxIndex() == 0);
+    BOOST_TEST(mach.nextIndex() == 0);
+}
+
+
 /**
  * CONSUME TIMERS
  */
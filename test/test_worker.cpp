@@ -13,11 +13,13 @@
 #include <boost/test/data/test_case.hpp>
 #include <boost/mpl/list.hpp>
 #include <benchmark/benchmark.h>
+#include <boost/asio/io_context.hpp>
 
 #include "test_utils.hpp"
 
 #include "fuurin/broker.h"
 #include "fuurin/worker.h"
+#include "fuurin/asyncworker.h"
 #include "fuurin/workerconfig.h"
 #include "fuurin/zmqpart.h"
 #include "fuurin/zmqpoller.h"
@@ -25,11 +27,17 @@
 #include "fuurin/stopwatch.h"
 #include "fuurin/errors.h"
 
+#include <algorithm>
 #include <string_view>
 #include <chrono>
 #include <thread>
 #include <list>
+#include <map>
+#include <mutex>
 #include <type_traits>
+#include <tuple>
+#include <vector>
+#include <cstdio>
 
 
 using namespace fuurin;
@@ -198,6 +206,40 @@ BOOST_AUTO_TEST_CASE(testTopicPatchSeqNum)
 }
 
 
+BOOST_AUTO_TEST_CASE(testTopicTrace)
+{
+    using f = WorkerFixture;
+    const Topic::Name name{"topic/test"sv};
+    const Topic::Data data{"topic/data"sv};
+
+    Topic t1{f::bid, f::wid, 1, name, data, Topic::State};
+    BOOST_TEST(!t1.trace().has_value());
+    t1.withTraceStamp(Topic::Hop::Dispatched, 10);
+    BOOST_TEST(!t1.trace().has_value());
+
+    zmq::Part p1 = t1.toPart();
+    BOOST_TEST(!Topic::isTraced(p1));
+    BOOST_TEST(!Topic::withTraceStamp(p1, Topic::Hop::Delivered, 50));
+    BOOST_TEST(!Topic::fromPart(p1).trace().has_value());
+
+    Topic t2{t1};
+    t2.withTrace(Topic::Trace{1, 2}).withTraceStamp(Topic::Hop::Ingested, 3);
+    BOOST_TEST(t2 == t1);
+
+    zmq::Part p2 = t2.toPart();
+    BOOST_TEST(p2.size() == p1.size() + sizeof(Topic::Trace));
+    BOOST_TEST(Topic::isTraced(p2));
+    BOOST_TEST(Topic::typeOf(p2) == Topic::State);
+    BOOST_TEST(TopicView{p2}.type() == Topic::State);
+    BOOST_TEST(Topic::withTraceStamp(p2, Topic::Hop::Delivered, 5));
+
+    const Topic t3{Topic::fromPart(p2)};
+    BOOST_TEST(t3 == t1);
+    BOOST_REQUIRE(t3.trace().has_value());
+    BOOST_TEST((*t3.trace() == Topic::Trace{1, 2, 3, 0, 5}));
+}
+
+
 typedef boost::mpl::list<Broker, Worker> runnerTypes;
 BOOST_AUTO_TEST_CASE_TEMPLATE(workerStart, T, runnerTypes)
 {
@@ -626,6 +668,120 @@ BOOST_AUTO_TEST_CASE(testSyncError_Timeout)
 }
 
 
+BOOST_AUTO_TEST_CASE(testSyncRacing)
+{
+    Broker b{WorkerFixture::bid};
+    Worker w{WorkerFixture::wid};
+
+    const std::vector<std::string> endp{"ipc:///tmp/broker_snapshot_none", "ipc:///tmp/broker_snapshot"};
+
+    w.setEndpoints({"ipc:///tmp/worker_delivery"}, {"ipc:///tmp/worker_dispatch"}, endp);
+    w.setSyncRacing(true);
+    BOOST_TEST(w.syncRacing());
+
+    auto cnf = mkCnf(w, 0, true, {}, {"ipc:///tmp/worker_delivery"}, {"ipc:///tmp/worker_dispatch"}, endp);
+    cnf.syncRacing = true;
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    testWaitForStart(w, cnf);
+
+    w.dispatch("topic"sv, zmq::Part{"hello"sv});
+    testWaitForTopic(w, mkT("topic", 0, "hello"), 1);
+
+    // first broker is not reachable, so the second one wins.
+    for (int i = 0; i < 3; ++i) {
+        cnf.seqNum = 1;
+
+        StopWatch t;
+        t.start();
+
+        w.sync();
+
+        testWaitForSyncStart(w, b, cnf);
+        testWaitForSyncTopic(w, mkT("topic", 1, "hello"), 1);
+        testWaitForSyncStop(w, b);
+
+        BOOST_TEST((t.elapsed() < 1s));
+    }
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testConnectionTimeout)
+{
+    Broker b{WorkerFixture::bid};
+    Worker w{WorkerFixture::wid};
+
+    BOOST_TEST((w.connectionTimeout() == std::make_tuple(500ms, 3000ms, 0ms)));
+
+    w.setConnectionTimeout(100ms, 1s, 200ms);
+    BOOST_TEST((w.connectionTimeout() == std::make_tuple(100ms, 1000ms, 200ms)));
+
+    auto cnf = mkCnf(w);
+    cnf.connRetry = 100ms;
+    cnf.connTimeout = 1s;
+    cnf.connKeepalive = 200ms;
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    testWaitForStart(w, cnf);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testRedundantPaths)
+{
+    Broker b{WorkerFixture::bid};
+    Worker w{WorkerFixture::wid};
+
+    // second path is not reachable.
+    const std::vector<std::string> endp1{"ipc:///tmp/worker_delivery", "ipc:///tmp/worker_delivery_none"};
+    const std::vector<std::string> endp2{"ipc:///tmp/worker_dispatch", "ipc:///tmp/worker_dispatch_none"};
+    const std::vector<std::string> endp3{"ipc:///tmp/broker_snapshot"};
+
+    w.setEndpoints(endp1, endp2, endp3);
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    testWaitForStart(w, mkCnf(w, 0, true, {}, endp1, endp2, endp3));
+
+    w.dispatch("topic"sv, zmq::Part{"hello"sv});
+    testWaitForTopic(w, mkT("topic", 0, "hello"), 1);
+
+    // reconnection of second path doesn't affect the first one.
+    testWaitForEvent(w, 4s, Event::Notification::Timeout, Event::Type::Invalid);
+
+    w.dispatch("topic"sv, zmq::Part{"hello"sv});
+    testWaitForTopic(w, mkT("topic", 0, "hello"), 2);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
 BOOST_FIXTURE_TEST_CASE(testSyncTopicRecentSameWorker, WorkerFixture)
 {
     w.dispatch("topic"sv, zmq::Part{"hello1"sv});
@@ -732,8 +888,10 @@ BOOST_AUTO_TEST_CASE(testTopicSubscriptionInvalid)
 {
     Worker w(WorkerFixture::wid);
     w.setTopicsNames({"UPDT"sv});
+    BOOST_TEST(!w.isRunning());
+    // session might already be failed, so check start was accepted.
     auto wf = w.start();
-    BOOST_TEST(w.isRunning());
+    BOOST_TEST(wf.valid());
     BOOST_REQUIRE_THROW(wf.get(), err::Error);
     BOOST_TEST(!w.isRunning());
 }
@@ -1153,6 +1311,698 @@ BOOST_AUTO_TEST_CASE(testWorkerSeqSync)
 }
 
 
+BOOST_AUTO_TEST_CASE(testBrokerStorageRestart)
+{
+    const std::string path = "/tmp/fuurin_worker_storage";
+    std::remove(path.c_str());
+    std::remove((path + ".log").c_str());
+    std::remove((path + ".log.old").c_str());
+
+    Worker w(WorkerFixture::wid);
+    Broker b1(WorkerFixture::bid);
+    b1.setStorageFile(path);
+
+    auto wf = w.start();
+    auto bf1 = b1.start();
+
+    testWaitForStart(w);
+
+    const auto t1 = mkT("topic1", 1, "hello1");
+    const auto t2 = mkT("topic2", 2, "hello2");
+    const auto t3 = Topic{mkT("topic3", 3, "hello3")}.withType(Topic::Event);
+
+    for (const auto& t : {t1, t2, t3}) {
+        w.dispatch(t.name(), t.data(), t.type());
+        testWaitForTopic(w, t, t.seqNum());
+    }
+
+    // broker is restarted without workers republishing.
+    b1.stop();
+    bf1.get();
+    w.stop();
+    testWaitForStop(w);
+    wf.get();
+
+    Broker b2(WorkerFixture::bid);
+    b2.setStorageFile(path);
+    BOOST_TEST(b2.storageFile() == path);
+
+    auto bf2 = b2.start();
+    wf = w.start();
+
+    BOOST_TEST(w.waitForOnline(5s));
+
+    // events are not persisted.
+    w.sync();
+    for (const auto& t : {t1, t2}) {
+        const auto opt = w.waitForTopic(5s);
+        BOOST_TEST(opt.has_value());
+        BOOST_TEST(opt.value() == t);
+    }
+    BOOST_TEST(!w.waitForTopic(500ms).has_value());
+
+    b2.stop();
+    w.stop();
+
+    BOOST_TEST(w.waitForStopped());
+
+    bf2.get();
+    wf.get();
+
+    BOOST_TEST(b1.stats().storageErrors == 0u);
+    BOOST_TEST(b2.stats().storageErrors == 0u);
+}
+
+
+BOOST_AUTO_TEST_CASE(testBrokerStorageFailure)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    // storage can't be opened, topics are served anyway.
+    b.setStorageFile("/nonexistent/fuurin_worker_storage", 10s, 10ms);
+    BOOST_TEST((b.storageFlush() == 10ms));
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    testWaitForStart(w);
+
+    const auto t1 = mkT("topic1", 1, "hello1");
+    w.dispatch(t1.name(), t1.data());
+    testWaitForTopic(w, t1, t1.seqNum());
+
+    BOOST_TEST(b.stats().storageErrors == 1u);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testBrokerStorageCapacity)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    BOOST_TEST((b.storageCapacity() == std::make_tuple(size_t(1024), size_t(8), size_t(64))));
+    b.setStorageCapacity(2, 1, 0);
+    BOOST_TEST((b.storageCapacity() == std::make_tuple(size_t(2), size_t(1), size_t(0))));
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    testWaitForStart(w);
+
+    const auto t1 = mkT("topic1", 1, "hello1");
+    const auto t2 = mkT("topic2", 2, "hello2");
+    const auto t3 = mkT("topic3", 3, "hello3");
+
+    for (const auto& t : {t1, t2, t3}) {
+        w.dispatch(t.name(), t.data());
+        testWaitForTopic(w, t, t.seqNum());
+    }
+
+    // least recently stored topic name was evicted.
+    w.sync();
+    std::vector<Topic> synced;
+    for (int i = 0; i < 2; ++i) {
+        const auto opt = w.waitForTopic(5s);
+        BOOST_TEST(opt.has_value());
+        if (opt)
+            synced.push_back(opt.value());
+    }
+    BOOST_TEST(!w.waitForTopic(500ms).has_value());
+    BOOST_TEST(synced.size() == 2u);
+    BOOST_TEST((std::find(synced.begin(), synced.end(), t1) == synced.end()));
+
+    b.stop();
+    w.stop();
+
+    BOOST_TEST(w.waitForStopped());
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testStats)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    const auto ws0 = w.stats();
+    const auto bs0 = b.stats();
+    BOOST_TEST(ws0.dispatched == 0u);
+    BOOST_TEST(ws0.deliveryLatency.count == 0u);
+    BOOST_TEST(bs0.received == 0u);
+    BOOST_TEST(bs0.dispatchLatency.count == 0u);
+
+    auto wf = w.start();
+    auto bf = b.start();
+
+    testWaitForStart(w);
+
+    const auto t1 = mkT("topic1", 1, "hello1");
+    const auto t2 = mkT("topic2", 2, "hello2");
+
+    for (const auto& t : {t1, t2}) {
+        w.dispatch(t.name(), t.data(), t.type());
+        testWaitForTopic(w, t, t.seqNum());
+    }
+
+    w.sync();
+    testWaitForSyncStart(w, b, mkCnf(w, 2));
+    testWaitForSyncTopic(w, t1, 1);
+    testWaitForSyncTopic(w, t2, 2);
+    testWaitForSyncStop(w, b);
+
+    const auto ws = w.stats();
+    BOOST_TEST(ws.dispatched == 2u);
+    BOOST_TEST(ws.delivered == 2u);
+    BOOST_TEST(ws.discarded == 0u);
+    BOOST_TEST(ws.syncElements == 2u);
+    BOOST_TEST(ws.syncRetries == 0u);
+    BOOST_TEST(ws.connTransitions >= 2u);
+    BOOST_TEST(ws.deliveryLatency.count == 2u);
+    BOOST_TEST(ws.deliveryLatency.max > 0u);
+    BOOST_TEST(ws.syncLatency.count == 1u);
+
+    const auto bs = b.stats();
+    BOOST_TEST(bs.received == 2u);
+    BOOST_TEST(bs.dispatched == 2u);
+    BOOST_TEST(bs.discarded == 0u);
+    BOOST_TEST(bs.syncRequests == 1u);
+    BOOST_TEST(bs.syncElements == 2u);
+    BOOST_TEST(bs.syncAborts == 0u);
+    BOOST_TEST(bs.dispatchLatency.count == 2u);
+    BOOST_TEST(bs.syncLatency.count == 1u);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    wf.get();
+    bf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testKeepaliveStatus)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    auto wf = w.start();
+    auto bf = b.start();
+
+    testWaitForStart(w);
+
+    const auto t1 = mkT("topic1", 1, "hello1");
+    w.dispatch(t1.name(), t1.data(), t1.type());
+    testWaitForTopic(w, t1, t1.seqNum());
+
+    // wait for keepalives and their echoes.
+    std::this_thread::sleep_for(2500ms);
+
+    const auto ws = w.stats();
+    BOOST_TEST(ws.keepaliveLatency.count > 0u);
+    BOOST_TEST(ws.keepaliveLatency.max > 0u);
+    BOOST_TEST(ws.brokerWorkers == 1u);
+    BOOST_TEST(ws.brokerTopics == 1u);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    wf.get();
+    bf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testTracing)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    BOOST_TEST(!w.tracing());
+    BOOST_TEST(w.traceStats().empty());
+
+    auto wf = w.start();
+    auto bf = b.start();
+
+    testWaitForStart(w);
+
+    const auto t1 = mkT("topic1", 1, "hello1");
+    const auto t2 = mkT("topic2", 2, "hello2");
+
+    w.dispatch(t1.name(), t1.data(), t1.type());
+    const auto ev1 = testWaitForTopic(w, t1, 1);
+    BOOST_TEST(!Topic::fromPart(ev1.payload()).trace().has_value());
+
+    w.setTracing(true);
+    BOOST_TEST(w.tracing());
+
+    w.dispatch(t2.name(), t2.data(), t2.type());
+    const auto ev2 = testWaitForTopic(w, t2, 2);
+    const auto tr = Topic::fromPart(ev2.payload()).trace();
+    BOOST_REQUIRE(tr.has_value());
+    for (size_t i = 0; i < tr->size(); ++i) {
+        BOOST_TEST((*tr)[i] != 0u);
+        if (i > 0)
+            BOOST_TEST((*tr)[i] >= (*tr)[i - 1]);
+    }
+
+    const auto ts = w.traceStats();
+    BOOST_REQUIRE(ts.size() == 1u);
+    BOOST_TEST(ts[0].name == "topic2");
+    BOOST_TEST(ts[0].total.count == 1u);
+    BOOST_TEST(ts[0].total.max == (*tr)[size_t(Topic::Hop::Delivered)] - (*tr)[size_t(Topic::Hop::Created)]);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    wf.get();
+    bf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testStateCache)
+{
+    Worker w1(WorkerFixture::wid);
+    Worker w2(Uuid::createNamespaceUuid(Uuid::Ns::Dns, "worker2.net"sv));
+    Broker b(WorkerFixture::bid);
+
+    BOOST_TEST(!w1.stateCache());
+    w1.setStateCache(true);
+    w2.setStateCache(true);
+    BOOST_TEST(w1.stateCache());
+
+    auto bf = b.start();
+    auto wf1 = w1.start();
+
+    testWaitForStart(w1);
+
+    const auto t1 = mkT("cache/a", 1, "hello1");
+    const auto t2 = mkT("cache/b", 2, "hello2");
+    const auto t3 = mkT("cache/e", 3, "hello3").withType(Topic::Event);
+    const auto t4 = mkT("other", 4, "hello4");
+    const auto t5 = mkT("cache/a", 5, "hello5");
+
+    for (const auto& t : {t1, t2, t3, t4}) {
+        w1.dispatch(t.name(), t.data(), t.type());
+        testWaitForTopic(w1, t, t.seqNum());
+    }
+
+    BOOST_TEST((w1.get("cache/a"sv) == t1));
+    BOOST_TEST((w1.get("cache/b"sv) == t2));
+    BOOST_TEST(!w1.get("cache/e"sv).has_value());
+    BOOST_TEST(!w1.get("none"sv).has_value());
+
+    std::map<std::string, Topic> found;
+    w1.forEach("cache/"sv, [&found](const Topic& t) {
+        found.emplace(std::string(std::string_view(t.name())), t);
+    });
+    BOOST_TEST(found.size() == 2u);
+    BOOST_TEST(found.at("cache/a") == t1);
+    BOOST_TEST(found.at("cache/b") == t2);
+
+    size_t count = 0;
+    w1.forEach(""sv, [&count](const Topic&) { ++count; });
+    BOOST_TEST(count == 3u);
+
+    // latest value replaces the cached one
+    w1.dispatch(t5.name(), t5.data(), t5.type());
+    testWaitForTopic(w1, t5, t5.seqNum());
+    BOOST_TEST((w1.get("cache/a"sv) == t5));
+
+    // snapshot fills the cache
+    auto wf2 = w2.start();
+    testWaitForStart(w2);
+    BOOST_TEST(!w2.get("cache/b"sv).has_value());
+
+    w2.sync();
+    for (;;) {
+        const auto ev = w2.waitForEvent(5s);
+        BOOST_REQUIRE(ev.type() != Event::Type::Invalid);
+        if (ev.type() == Event::Type::SyncDownloadOff)
+            break;
+    }
+
+    BOOST_TEST((w2.get("cache/a"sv) == t5));
+    BOOST_TEST((w2.get("cache/b"sv) == t2));
+    BOOST_TEST((w2.get("other"sv) == t4));
+    BOOST_TEST(!w2.get("cache/e"sv).has_value());
+
+    b.stop();
+    w1.stop();
+    w2.stop();
+
+    for (auto w : {&w1, &w2})
+        testWaitForStop(*w);
+
+    bf.get();
+    wf1.get();
+    wf2.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testTopicConflated)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    BOOST_TEST(w.topicsConflated().empty());
+    w.setTopicsConflated({"conflated"sv});
+    BOOST_TEST(w.topicsConflated() == std::vector<Topic::Name>{"conflated"sv});
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    auto cnf = mkCnf(w);
+    cnf.topicsConflated = w.topicsConflated();
+    testWaitForStart(w, cnf);
+
+    // nothing is read, while topics are delivered.
+    const auto c1 = mkT("conflated", 1, "hello1");
+    const auto t2 = mkT("plain", 2, "hello2");
+    const auto c3 = mkT("conflated", 3, "hello3");
+    const auto e4 = mkT("conflated", 4, "hello4").withType(Topic::Event);
+    const auto c5 = mkT("conflated", 5, "hello5");
+    const auto t6 = mkT("plain", 6, "hello6");
+
+    for (const auto& t : {c1, t2, c3, e4, c5, t6})
+        w.dispatch(t.name(), t.data(), t.type());
+
+    for (int i = 0; i < 500 && w.stats().delivered < 6; ++i)
+        std::this_thread::sleep_for(10ms);
+
+    BOOST_TEST(w.stats().delivered == 6u);
+    BOOST_TEST(w.stats().conflated == 2u);
+
+    // the pending conflated delivery keeps its position,
+    // but it's replaced by the latest one.
+    for (const auto& t : {c5, t2, e4, t6}) {
+        const auto ev = w.waitForEvent(5s);
+        BOOST_TEST(ev.type() == Event::Type::Delivery);
+        BOOST_TEST(ev.notification() == Event::Notification::Success);
+        BOOST_TEST(Topic::fromPart(ev.payload()) == t);
+    }
+
+    BOOST_TEST(w.waitForEvent(100ms).type() == Event::Type::Invalid);
+
+    // a new delivery is notified again.
+    const auto c7 = mkT("conflated", 7, "hello7");
+    w.dispatch(c7.name(), c7.data(), c7.type());
+    testWaitForTopic(w, c7, 7);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testDeliveryHandler)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    std::mutex mtx;
+    std::vector<Topic> got;
+
+    BOOST_TEST(!w.hasDeliveryHandler());
+    w.setDeliveryHandler(
+        [&mtx, &got](const TopicView& t) noexcept {
+            if (t.name() == "slow"sv)
+                std::this_thread::sleep_for(5ms);
+
+            std::lock_guard<std::mutex> lock(mtx);
+            got.push_back(t.toTopic());
+        },
+        1ms);
+    BOOST_TEST(w.hasDeliveryHandler());
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    testWaitForStart(w);
+
+    const auto t1 = mkT("fast", 1, "hello1");
+    const auto t2 = mkT("slow", 2, "hello2");
+
+    for (const auto& t : {t1, t2})
+        w.dispatch(t.name(), t.data(), t.type());
+
+    for (int i = 0; i < 500 && w.stats().delivered < 2; ++i)
+        std::this_thread::sleep_for(10ms);
+
+    // deliveries are not notified as events.
+    BOOST_TEST(w.waitForEvent(100ms).type() == Event::Type::Invalid);
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        BOOST_TEST(got.size() == 2u);
+        BOOST_TEST((got == std::vector<Topic>{t1, t2}));
+    }
+
+    const auto st = w.stats();
+    BOOST_TEST(st.delivered == 2u);
+    BOOST_TEST(st.handlerLatency.count == 2u);
+    BOOST_TEST(st.handlerLatency.max >= uint64_t(std::chrono::nanoseconds(5ms).count()));
+    BOOST_TEST(st.handlerOverruns >= 1u);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testAsyncEvents)
+{
+    boost::asio::io_context io;
+
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    const auto t1 = mkT("topic1", 1, "hello1");
+
+    bool initiated = false;
+    std::vector<Event::Type> types;
+    std::optional<Topic> got;
+    std::optional<Worker::DispatchResult> res;
+
+    std::function<void(boost::system::error_code, Event)> onEvent;
+    onEvent = [&](boost::system::error_code ec, Event ev) {
+        // completion never happens within the initiating function.
+        BOOST_TEST(initiated);
+        BOOST_TEST(!ec);
+        BOOST_TEST(ev.notification() == Event::Notification::Success);
+
+        types.push_back(ev.type());
+
+        if (ev.type() == Event::Type::Delivery) {
+            got = Topic::fromPart(ev.payload());
+            return;
+        }
+
+        if (ev.type() == Event::Type::Online) {
+            asyncDispatch(w, io.get_executor(), t1.name(), t1.data(), t1.type(),
+                [&res](boost::system::error_code ec, Worker::DispatchResult r) {
+                    BOOST_TEST(!ec);
+                    res = r;
+                });
+        }
+
+        asyncNextEvent(w, io.get_executor(), [&onEvent](boost::system::error_code ec, Event ev) {
+            onEvent(ec, std::move(ev));
+        });
+    };
+
+    asyncNextEvent(w, io.get_executor(), [&onEvent](boost::system::error_code ec, Event ev) {
+        onEvent(ec, std::move(ev));
+    });
+    initiated = true;
+
+    io.run_for(10s);
+
+    BOOST_TEST((res == Worker::DispatchResult::Sent));
+    BOOST_TEST((got == t1));
+    BOOST_TEST(types.front() == Event::Type::Started);
+    BOOST_TEST(types.back() == Event::Type::Delivery);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testDispatchBackpressure)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    BOOST_TEST((w.highWaterMark() == std::make_tuple(0, 0)));
+    BOOST_TEST((w.bufferSize() == std::make_tuple(-1, -1)));
+
+    BOOST_TEST((w.tryDispatch("topic"sv, zmq::Part{"hello"sv}) == Worker::DispatchResult::NotRunning));
+    w.dispatch("topic"sv, zmq::Part{"hello"sv});
+    BOOST_TEST(w.stats().dispatchDropped == 2u);
+
+    w.setHighWaterMark(2, 0);
+    w.setBufferSize(65536, 65536);
+    BOOST_TEST((w.highWaterMark() == std::make_tuple(2, 0)));
+    BOOST_TEST((w.bufferSize() == std::make_tuple(65536, 65536)));
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    auto cnf = mkCnf(w);
+    cnf.hwmSend = 2;
+    cnf.bufSend = 65536;
+    cnf.bufRecv = 65536;
+    testWaitForStart(w, cnf);
+
+    // topics are refused while the asynchronous task is behind.
+    size_t sent = 0;
+    size_t blocked = 0;
+    for (int i = 0; i < 100000 && blocked == 0; ++i) {
+        switch (w.tryDispatch("topic"sv, zmq::Part{"hello"sv})) {
+        case Worker::DispatchResult::Sent:
+            ++sent;
+            break;
+        case Worker::DispatchResult::WouldBlock:
+            ++blocked;
+            break;
+        case Worker::DispatchResult::NotRunning:
+            BOOST_FAIL("worker is not running");
+            break;
+        }
+    }
+
+    BOOST_TEST(sent >= 2u);
+    BOOST_TEST(blocked == 1u);
+    BOOST_TEST(w.stats().dispatchBlocked == 1u);
+
+    for (int i = 0; i < 500 && w.pendingOperations() > 0; ++i)
+        std::this_thread::sleep_for(10ms);
+
+    BOOST_TEST(w.pendingOperations() == 0u);
+    BOOST_TEST((w.tryDispatch("topic"sv, zmq::Part{"hello"sv}) == Worker::DispatchResult::Sent));
+
+    // discard deliveries of the dispatched topics.
+    Event ev;
+    do {
+        ev = w.waitForEvent(1s);
+    } while (ev.type() == Event::Type::Delivery);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testBrokerDroppedTopics)
+{
+    Broker b(WorkerFixture::bid);
+    auto bf = b.start();
+
+    {
+        Worker w(WorkerFixture::wid, 0);
+        auto wf = w.start();
+        testWaitForStart(w);
+
+        w.dispatch("topic"sv, zmq::Part{"hello1"sv});
+        testWaitForTopic(w, mkT("topic", 1, "hello1"), 1);
+
+        w.stop();
+        testWaitForStop(w);
+        wf.get();
+    }
+
+    BOOST_TEST(b.stats().dropped == 0u);
+
+    {
+        // sequence numbers from 2 to 10 are missing.
+        Worker w(WorkerFixture::wid, 10);
+        auto wf = w.start();
+        testWaitForStart(w, mkCnf(w, 10));
+
+        w.dispatch("topic"sv, zmq::Part{"hello11"sv});
+        testWaitForTopic(w, mkT("topic", 11, "hello11"), 11);
+
+        w.stop();
+        testWaitForStop(w);
+        wf.get();
+    }
+
+    BOOST_TEST(b.stats().dropped == 9u);
+
+    b.stop();
+    bf.get();
+}
+
+
+BOOST_AUTO_TEST_CASE(testBusyPoll)
+{
+    Worker w(WorkerFixture::wid);
+    Broker b(WorkerFixture::bid);
+
+    BOOST_TEST((w.busyPoll() == 0us));
+    BOOST_TEST(w.cpuAffinity().empty());
+
+    w.setBusyPoll(-1us);
+    BOOST_TEST((w.busyPoll() == 0us));
+
+    w.setBusyPoll(100us);
+    w.setCpuAffinity({0});
+    b.setBusyPoll(100us);
+    BOOST_TEST((w.busyPoll() == 100us));
+    BOOST_TEST((w.cpuAffinity() == std::vector<int>{0}));
+
+    auto bf = b.start();
+    auto wf = w.start();
+
+    testWaitForStart(w);
+
+    w.dispatch("topic"sv, zmq::Part{"hello"sv});
+    testWaitForTopic(w, mkT("topic", 1, "hello"), 1);
+
+    b.stop();
+    w.stop();
+
+    testWaitForStop(w);
+
+    bf.get();
+    wf.get();
+}
+
+
 BOOST_AUTO_TEST_CASE(testWaitForTopicFileDescriptor)
 {
     Worker w(WorkerFixture::wid);